@@ -0,0 +1,80 @@
+//
+// RBBenchmarkReporter.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * The formats results can be written in.
+ */
+typedef enum {
+    
+    /// One JSON object per line, with the benchmark, its parameters and its metrics.
+    RBBenchmarkFormatJSON,
+    
+    /// One "suite,benchmark,parameters,metric,value" row per metric, after a header row.
+    RBBenchmarkFormatCSV,
+    
+} RBBenchmarkFormat;
+
+
+/**
+ * Writes benchmark results in a machine-readable format, so runs can be 
+ * compared with each other. Each result names its suite and benchmark, the 
+ * parameters it ran with, such as a thread count or a file size, and the 
+ * metrics it measured. Metric names end in their unit, such as 
+ * "messages_per_sec" or "p99_us".
+ */
+@interface RBBenchmarkReporter : NSObject
+
+/// The format results are written in.
+@property (nonatomic, assign, readonly) RBBenchmarkFormat format;
+
+/// Whether the suites should run small sizes only, as a smoke test.
+@property (nonatomic, assign, getter=isQuick) BOOL quick;
+
+/// The suite whose results are being reported.
+@property (nonatomic, copy) NSString * suiteName;
+
+/**
+ * Standard initializer.
+ *
+ * @param format The format to write results in.
+ * @param fileHandle Where to write results.
+ *
+ * @return self
+ */
+- (id)initWithFormat:(RBBenchmarkFormat)format fileHandle:(NSFileHandle *)fileHandle;
+
+/**
+ * Writes one result.
+ *
+ * @param benchmark The name of the benchmark.
+ * @param parameters What the benchmark ran with, as NSStrings or NSNumbers 
+ * keyed by name. May be nil.
+ * @param metrics What the benchmark measured, as NSNumbers keyed by name.
+ */
+- (void)reportBenchmark:(NSString *)benchmark parameters:(NSDictionary *)parameters metrics:(NSDictionary *)metrics;
+
+@end
@@ -0,0 +1,146 @@
+//
+// RBBenchmarkReporter.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBBenchmarkReporter.h"
+
+
+@interface RBBenchmarkReporter ()
+
+@property (nonatomic, assign, readwrite) RBBenchmarkFormat format;
+
+/**
+ * Where results are written.
+ */
+@property (nonatomic, strong) NSFileHandle * fileHandle;
+
+/**
+ * Whether the CSV header row has been written.
+ */
+@property (nonatomic, assign) BOOL wroteHeader;
+
+/**
+ * Writes a line to the file handle.
+ *
+ * @param line The line, without its newline.
+ */
+- (void)writeLine:(NSString *)line;
+
+/**
+ * Returns the parameters as "name=value" pairs separated by semicolons, 
+ * sorted by name.
+ *
+ * @param parameters The parameters.
+ *
+ * @return The text.
+ */
++ (NSString *)descriptionOfParameters:(NSDictionary *)parameters;
+
+/**
+ * Returns the given text as a CSV field, quoted if it contains a comma, a 
+ * quote or a line break.
+ *
+ * @param text The text.
+ *
+ * @return The field.
+ */
++ (NSString *)CSVFieldWithString:(NSString *)text;
+
+@end
+
+
+@implementation RBBenchmarkReporter
+
+@synthesize format, quick, suiteName, fileHandle, wroteHeader;
+
+- (id)initWithFormat:(RBBenchmarkFormat)theFormat fileHandle:(NSFileHandle *)theFileHandle {
+    
+    if ((self = [super init])) {
+        [self setFormat:theFormat];
+        [self setFileHandle:theFileHandle];
+        [self setSuiteName:@""];
+    }
+    
+    return self;
+}
+
+- (void)reportBenchmark:(NSString *)benchmark parameters:(NSDictionary *)parameters metrics:(NSDictionary *)metrics {
+    
+    if (!parameters)
+        parameters = [NSDictionary dictionary];
+    
+    if ([self format] == RBBenchmarkFormatJSON) {
+        
+        NSDictionary * result = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [self suiteName], @"suite", 
+                                 benchmark, @"benchmark", 
+                                 parameters, @"parameters", 
+                                 metrics, @"metrics", 
+                                 nil];
+        NSData * json = [NSJSONSerialization dataWithJSONObject:result options:0 error:NULL];
+        
+        [self writeLine:[[NSString alloc] initWithData:json encoding:NSUTF8StringEncoding]];
+        return;
+    }
+    
+    if (![self wroteHeader]) {
+        [self writeLine:@"suite,benchmark,parameters,metric,value"];
+        [self setWroteHeader:YES];
+    }
+    
+    NSString * parameterText = [[self class] CSVFieldWithString:[[self class] descriptionOfParameters:parameters]];
+    
+    for (NSString * metric in [[metrics allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+        [self writeLine:[NSString stringWithFormat:@"%@,%@,%@,%@,%@", 
+                         [self suiteName], benchmark, parameterText, metric, [metrics objectForKey:metric]]];
+    }
+}
+
+- (void)writeLine:(NSString *)line {
+    
+    NSString * text = [line stringByAppendingString:@"\n"];
+    
+    [[self fileHandle] writeData:[text dataUsingEncoding:NSUTF8StringEncoding]];
+}
+
++ (NSString *)CSVFieldWithString:(NSString *)text {
+    
+    NSCharacterSet * specialCharacters = [NSCharacterSet characterSetWithCharactersInString:@",\"\r\n"];
+    
+    if ([text rangeOfCharacterFromSet:specialCharacters].location == NSNotFound)
+        return text;
+    
+    return [NSString stringWithFormat:@"\"%@\"", [text stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""]];
+}
+
++ (NSString *)descriptionOfParameters:(NSDictionary *)parameters {
+    
+    NSMutableArray * pairs = [NSMutableArray array];
+    
+    for (NSString * name in [[parameters allKeys] sortedArrayUsingSelector:@selector(compare:)])
+        [pairs addObject:[NSString stringWithFormat:@"%@=%@", name, [parameters objectForKey:name]]];
+    
+    return [pairs componentsJoinedByString:@";"];
+}
+
+@end
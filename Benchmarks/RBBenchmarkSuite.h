@@ -0,0 +1,51 @@
+//
+// RBBenchmarkSuite.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RBBenchmarkReporter;
+
+
+/**
+ * A group of related benchmarks, run by name from the RBReporterBenchmarks 
+ * tool. Each benchmark sets up its own files in a temporary directory and 
+ * removes them when it is done.
+ */
+@protocol RBBenchmarkSuite <NSObject>
+
+/**
+ * Returns the name the suite is selected by.
+ *
+ * @return The name.
+ */
++ (NSString *)suiteName;
+
+/**
+ * Runs every benchmark in the suite.
+ *
+ * @param reporter Receives the results. Its quick flag asks for small sizes.
+ */
+- (void)runWithReporter:(RBBenchmarkReporter *)reporter;
+
+@end
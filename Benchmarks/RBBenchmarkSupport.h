@@ -0,0 +1,101 @@
+//
+// RBBenchmarkSupport.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RBLogger;
+
+
+/**
+ * Returns a monotonic time in seconds, for measuring durations.
+ *
+ * @return The time.
+ */
+extern double RBBenchmarkTime(void);
+
+/**
+ * Returns the bytes of memory the process has resident right now.
+ *
+ * @return The resident set size, or 0 if it can't be read.
+ */
+extern unsigned long long RBBenchmarkResidentBytes(void);
+
+/**
+ * Runs the given block while sampling the resident set size every 
+ * millisecond on another thread.
+ *
+ * @param block The work to measure.
+ *
+ * @return The largest resident set size seen, in bytes.
+ */
+extern unsigned long long RBBenchmarkPeakResidentBytesDuring(void (^block)(void));
+
+/**
+ * Runs the given block on the given number of new threads at once and waits 
+ * for all of them. Unlike dispatch_apply(), every block gets its own thread, 
+ * even with more threads than cores.
+ *
+ * @param count The number of threads.
+ * @param block Called on each thread with the thread's index.
+ */
+extern void RBBenchmarkRunThreads(NSUInteger count, void (^block)(NSUInteger index));
+
+/**
+ * Creates an empty directory under the temporary directory.
+ *
+ * @param name Part of the directory's name.
+ *
+ * @return The path of the directory.
+ */
+extern NSString * RBBenchmarkCreateTemporaryDirectory(NSString * name);
+
+/**
+ * Returns a logger with its own directory, so benchmarks never touch the 
+ * app's logs. Loggers live for the rest of the process, so each call makes a 
+ * new one.
+ *
+ * @param name Part of the logger's name.
+ * @param directory The logger's directory, or nil for a new temporary one.
+ *
+ * @return The logger, once it has finished starting.
+ */
+extern RBLogger * RBBenchmarkCreateLogger(NSString * name, NSString * directory);
+
+/**
+ * Flushes the logger until nothing is waiting in its queue.
+ *
+ * @param logger The logger.
+ */
+extern void RBBenchmarkDrainLogger(RBLogger * logger);
+
+/**
+ * Returns the given percentile of some durations.
+ *
+ * @param durations The durations, in seconds. Sorted in place.
+ * @param count The number of durations.
+ * @param fraction The percentile, such as 0.99.
+ *
+ * @return The duration, or 0 if there are none.
+ */
+extern double RBBenchmarkPercentile(double * durations, NSUInteger count, double fraction);
@@ -0,0 +1,238 @@
+//
+// RBBenchmarkSupport.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <dispatch/dispatch.h>
+#import <pthread.h>
+#import <sched.h>
+#import <stdatomic.h>
+#import <stdbool.h>
+#import <stdio.h>
+#import <stdlib.h>
+#import <sys/resource.h>
+#import <time.h>
+#import <unistd.h>
+
+#import "RBBenchmarkSupport.h"
+#import "RBLogger.h"
+#import "RBLogFileFactory.h"
+
+/// The microseconds between resident set size samples.
+static const useconds_t kSampleIntervalMicroseconds = 1000;
+
+
+/**
+ * What each thread started by RBBenchmarkRunThreads() runs.
+ */
+typedef struct {
+    
+    /// The block to call.
+    void * block;
+    
+    /// The thread's index.
+    NSUInteger index;
+    
+    /// Set once every thread has been created, so they start together.
+    _Atomic(bool) * go;
+    
+} RBBenchmarkThread;
+
+
+/**
+ * Waits for the go flag, then calls the thread's block.
+ */
+static void * RBBenchmarkThreadMain(void * argument);
+
+/**
+ * Compares two doubles for qsort().
+ */
+static int RBCompareDurations(const void * first, const void * second);
+
+
+double RBBenchmarkTime(void) {
+    
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+unsigned long long RBBenchmarkResidentBytes(void) {
+    
+#ifdef __linux__
+    
+    // The second field is the resident pages.
+    FILE * statm = fopen("/proc/self/statm", "r");
+    unsigned long long size = 0;
+    unsigned long long resident = 0;
+    
+    if (!statm)
+        return 0;
+    
+    int fields = fscanf(statm, "%llu %llu", &size, &resident);
+    fclose(statm);
+    
+    return fields == 2 ? resident * (unsigned long long)sysconf(_SC_PAGESIZE) : 0;
+    
+#else
+    
+    // Only the peak is portable; macOS reports it in bytes.
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    
+    return (unsigned long long)usage.ru_maxrss;
+    
+#endif
+}
+
+unsigned long long RBBenchmarkPeakResidentBytesDuring(void (^block)(void)) {
+    
+    _Atomic(bool) running = true;
+    _Atomic(unsigned long long) peak = RBBenchmarkResidentBytes();
+    
+    // The sampler is waited for below, so it can use this function's variables.
+    _Atomic(bool) * isRunning = &running;
+    _Atomic(unsigned long long) * peakBytes = &peak;
+    dispatch_group_t group = dispatch_group_create();
+    
+    dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        
+        while (atomic_load(isRunning)) {
+            
+            unsigned long long resident = RBBenchmarkResidentBytes();
+            
+            if (resident > atomic_load(peakBytes))
+                atomic_store(peakBytes, resident);
+            
+            usleep(kSampleIntervalMicroseconds);
+        }
+    });
+    
+    block();
+    
+    unsigned long long resident = RBBenchmarkResidentBytes();
+    
+    if (resident > atomic_load(&peak))
+        atomic_store(&peak, resident);
+    
+    atomic_store(&running, false);
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(group);
+#endif
+    
+    return atomic_load(&peak);
+}
+
+void RBBenchmarkRunThreads(NSUInteger count, void (^block)(NSUInteger index)) {
+    
+    _Atomic(bool) go = false;
+    pthread_t * threads = calloc(count, sizeof(pthread_t));
+    RBBenchmarkThread * arguments = calloc(count, sizeof(RBBenchmarkThread));
+    void * retainedBlock = (__bridge_retained void *)[block copy];
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        arguments[i].block = retainedBlock;
+        arguments[i].index = i;
+        arguments[i].go = &go;
+        pthread_create(&threads[i], NULL, RBBenchmarkThreadMain, &arguments[i]);
+    }
+    
+    atomic_store(&go, true);
+    
+    for (NSUInteger i = 0; i < count; i++)
+        pthread_join(threads[i], NULL);
+    
+    CFBridgingRelease(retainedBlock);
+    free(arguments);
+    free(threads);
+}
+
+static void * RBBenchmarkThreadMain(void * argument) {
+    
+    RBBenchmarkThread * thread = argument;
+    void (^block)(NSUInteger) = (__bridge void (^)(NSUInteger))thread->block;
+    
+    while (!atomic_load(thread->go))
+        sched_yield();
+    
+    @autoreleasepool {
+        block(thread->index);
+    }
+    
+    return NULL;
+}
+
+NSString * RBBenchmarkCreateTemporaryDirectory(NSString * name) {
+    
+    NSString * unique = [NSString stringWithFormat:@"RBBenchmark-%@-%d-%@", name, getpid(), [[NSProcessInfo processInfo] globallyUniqueString]];
+    NSString * path = [NSTemporaryDirectory() stringByAppendingPathComponent:unique];
+    
+    [[NSFileManager defaultManager] createDirectoryAtPath:path withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    return path;
+}
+
+RBLogger * RBBenchmarkCreateLogger(NSString * name, NSString * directory) {
+    
+    static _Atomic(unsigned) loggerCount = 0;
+    
+    NSString * loggerName = [NSString stringWithFormat:@"%@%u", name, atomic_fetch_add(&loggerCount, 1)];
+    RBLogger * logger = [RBLogger loggerNamed:loggerName 
+                                    directory:directory ? directory : RBBenchmarkCreateTemporaryDirectory(loggerName) 
+                               logFileFactory:[RBLogFileFactory defaultFactory]];
+    
+    // Waits for the index to load and the startup purge to finish.
+    dispatch_sync([logger loggerQueue], ^{});
+    
+    return logger;
+}
+
+void RBBenchmarkDrainLogger(RBLogger * logger) {
+    
+    // Each flush drains at most one queue's worth.
+    do {
+        [logger flush];
+    } while ([logger statistics].queueDepth > 0);
+}
+
+double RBBenchmarkPercentile(double * durations, NSUInteger count, double fraction) {
+    
+    if (count == 0)
+        return 0;
+    
+    qsort(durations, count, sizeof(double), RBCompareDurations);
+    
+    NSUInteger index = (NSUInteger)(fraction * (count - 1) + 0.5);
+    
+    return durations[MIN(index, count - 1)];
+}
+
+static int RBCompareDurations(const void * first, const void * second) {
+    
+    double a = *(const double *)first;
+    double b = *(const double *)second;
+    
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
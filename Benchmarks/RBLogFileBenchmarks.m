@@ -0,0 +1,128 @@
+//
+// RBLogFileBenchmarks.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogFileBenchmarks.h"
+#import "RBBenchmarkReporter.h"
+#import "RBBenchmarkSupport.h"
+#import "RBExtendedLogFile.h"
+#import "RBLogRecord.h"
+
+
+@interface RBLogFileBenchmarks ()
+
+/**
+ * Compares writing one message at a time through the log file's open, 
+ * buffered descriptor with the path it replaced, which opened a stream, 
+ * wrote one line and closed the stream for every message.
+ *
+ * @param reporter Receives the results.
+ * @param count The number of messages.
+ */
+- (void)runWriteWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count;
+
+/**
+ * Reports the messages per second of one way of writing.
+ *
+ * @param reporter Receives the results.
+ * @param mode The name of the way of writing.
+ * @param count The number of messages written.
+ * @param elapsed The seconds taken.
+ */
+- (void)reportWriteWithReporter:(RBBenchmarkReporter *)reporter mode:(NSString *)mode count:(NSUInteger)count elapsed:(double)elapsed;
+
+@end
+
+
+@implementation RBLogFileBenchmarks
+
++ (NSString *)suiteName {
+    return @"log_file";
+}
+
+- (void)runWithReporter:(RBBenchmarkReporter *)reporter {
+    [self runWriteWithReporter:reporter count:[reporter isQuick] ? 2000 : 100000];
+}
+
+- (void)runWriteWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count {
+    
+    NSString * directory = RBBenchmarkCreateTemporaryDirectory(@"LogFile");
+    NSString * message = @"Request failed with a timeout; retrying with a longer interval.";
+    
+    // Open handle: each message is formatted into the write buffer, which 
+    // goes out in large writes to a descriptor that stays open.
+    @autoreleasepool {
+        
+        RBExtendedLogFile * file = [[RBExtendedLogFile alloc] initWithFilePath:[directory stringByAppendingPathComponent:@"OpenHandle.log"]];
+        double start = RBBenchmarkTime();
+        
+        for (NSUInteger i = 0; i < count; i++) {
+            RBLogRecord * record = [RBLogRecord recordWithMessage:message];
+            [file writeRecords:[NSArray arrayWithObject:record] error:NULL];
+        }
+        
+        [file closeFile];
+        [self reportWriteWithReporter:reporter mode:@"open_handle" count:count elapsed:RBBenchmarkTime() - start];
+    }
+    
+    // Per message: the same lines, each through a stream that is opened, 
+    // written and closed again.
+    @autoreleasepool {
+        
+        NSString * path = [directory stringByAppendingPathComponent:@"PerMessage.log"];
+        RBExtendedLogFile * formatter = [[RBExtendedLogFile alloc] initWithFilePath:path];
+        NSMutableData * line = [NSMutableData data];
+        double start = RBBenchmarkTime();
+        
+        for (NSUInteger i = 0; i < count; i++) {
+            
+            RBLogRecord * record = [RBLogRecord recordWithMessage:message];
+            NSOutputStream * stream = [NSOutputStream outputStreamToFileAtPath:path append:YES];
+            
+            [line setLength:0];
+            [formatter appendRecord:record toData:line];
+            
+            [stream open];
+            [stream write:[line bytes] maxLength:[line length]];
+            [stream close];
+        }
+        
+        [self reportWriteWithReporter:reporter mode:@"per_message_open_close" count:count elapsed:RBBenchmarkTime() - start];
+    }
+    
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+}
+
+- (void)reportWriteWithReporter:(RBBenchmarkReporter *)reporter mode:(NSString *)mode count:(NSUInteger)count elapsed:(double)elapsed {
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 mode, @"mode", 
+                                 [NSNumber numberWithUnsignedInteger:count], @"messages", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObject:[NSNumber numberWithDouble:count / elapsed] 
+                                                         forKey:@"messages_per_sec"];
+    
+    [reporter reportBenchmark:@"write" parameters:parameters metrics:metrics];
+}
+
+@end
@@ -0,0 +1,385 @@
+//
+// RBLogReadingBenchmarks.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogReadingBenchmarks.h"
+#import "RBBenchmarkReporter.h"
+#import "RBBenchmarkSupport.h"
+#import "RBExtendedLogFile.h"
+#import "RBExtendedLogReader.h"
+#import "RBLogQuery.h"
+#import "RBLogRecord.h"
+#import "RBLogSearch.h"
+#import "RBLogSegment.h"
+
+/// The seconds in a day.
+static const CFTimeInterval kSecondsPerDay = 86400.0;
+
+/// The approximate bytes in each synthetic line, used to spread lines over a day.
+static const NSUInteger kAverageLineLength = 110;
+
+/// The records written to a synthetic log file at a time.
+static const NSUInteger kRecordsPerBatch = 1024;
+
+/// One in this many synthetic records is an error worth searching for.
+static const NSUInteger kErrorInterval = 997;
+
+
+@interface RBLogReadingBenchmarks ()
+
+/**
+ * The synthetic log files, oldest first.
+ */
+@property (nonatomic, strong) NSArray * logFilePaths;
+
+/**
+ * Writes a day of synthetic records to each of the given number of log 
+ * files, named like the logger names them.
+ *
+ * @param directory Where to write the files.
+ * @param dayCount The number of days.
+ * @param bytesPerDay The approximate size of each file.
+ *
+ * @return The paths of the files, oldest first.
+ */
++ (NSArray *)writeLogFilesToDirectory:(NSString *)directory dayCount:(NSUInteger)dayCount bytesPerDay:(unsigned long long)bytesPerDay;
+
+/**
+ * Returns the total size of the given files.
+ *
+ * @param paths The paths of the files.
+ *
+ * @return The number of bytes.
+ */
++ (unsigned long long)byteCountOfFilesAtPaths:(NSArray *)paths;
+
+/**
+ * Measures time range queries of several lengths, ending late on the last 
+ * day, against the given files.
+ *
+ * @param reporter Receives the results.
+ * @param paths The log files to query.
+ */
+- (void)runQueryWithReporter:(RBBenchmarkReporter *)reporter paths:(NSArray *)paths;
+
+/**
+ * Measures full-text searches of every file, limited to 1, 2, 4 and so on up 
+ * to as many chunks at once as there are cores.
+ *
+ * @param reporter Receives the results.
+ * @param searchString What to search for.
+ */
+- (void)runSearchWithReporter:(RBBenchmarkReporter *)reporter searchString:(NSString *)searchString;
+
+/**
+ * Measures reading the last file on one thread: opening it and skipping its 
+ * header, iterating its lines as views, and creating the string of every 
+ * message as well.
+ *
+ * @param reporter Receives the results.
+ */
+- (void)runReaderWithReporter:(RBBenchmarkReporter *)reporter;
+
+/**
+ * Measures finding the same records by parsing every line of the last file 
+ * and checking its time, which is what a query without an index costs.
+ *
+ * @param reporter Receives the results.
+ * @param paths The log files to query.
+ */
+- (void)runFullScanWithReporter:(RBBenchmarkReporter *)reporter paths:(NSArray *)paths;
+
+@end
+
+
+@implementation RBLogReadingBenchmarks
+
+@synthesize logFilePaths;
+
++ (NSString *)suiteName {
+    return @"log_reading";
+}
+
+- (void)runWithReporter:(RBBenchmarkReporter *)reporter {
+    
+    BOOL quick = [reporter isQuick];
+    NSString * directory = RBBenchmarkCreateTemporaryDirectory(@"LogReading");
+    
+    // 2 GB in 8 files, or 4 MB as a smoke test.
+    [self setLogFilePaths:[[self class] writeLogFilesToDirectory:directory 
+                                                        dayCount:quick ? 2 : 8 
+                                                     bytesPerDay:quick ? 2 * 1024 * 1024 : 256 * 1024 * 1024]];
+    
+    // A query should cost the same whatever the size of the set.
+    NSArray * lastDay = [NSArray arrayWithObject:[[self logFilePaths] lastObject]];
+    
+    [self runQueryWithReporter:reporter paths:lastDay];
+    [self runQueryWithReporter:reporter paths:[self logFilePaths]];
+    [self runFullScanWithReporter:reporter paths:[self logFilePaths]];
+    [self runReaderWithReporter:reporter];
+    
+    // The second has quotes, which are doubled in the files.
+    [self runSearchWithReporter:reporter searchString:@"NSURLErrorDomain Code=-1001"];
+    [self runSearchWithReporter:reporter searchString:@"key \"user-42\""];
+    
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+}
+
+- (void)runQueryWithReporter:(RBBenchmarkReporter *)reporter paths:(NSArray *)paths {
+    
+    CFAbsoluteTime end = [RBExtendedLogReader dayStartForLogFilePath:[paths lastObject]] + 18 * 3600;
+    CFTimeInterval windows[] = { 60, 600, 7200 };
+    unsigned long long setBytes = [[self class] byteCountOfFilesAtPaths:paths];
+    
+    for (NSUInteger i = 0; i < sizeof(windows) / sizeof(windows[0]); i++) {
+        
+        @autoreleasepool {
+            
+            RBLogQuery * query = [[RBLogQuery alloc] initWithStartTime:end - windows[i] endTime:end];
+            unsigned long long returnedBytes = 0;
+            double start = RBBenchmarkTime();
+            NSArray * records = [query recordsInLogFilesAtPaths:paths error:NULL];
+            double elapsed = RBBenchmarkTime() - start;
+            
+            for (RBLogRecord * record in records)
+                returnedBytes += [[record message] lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+            
+            NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                         [NSNumber numberWithUnsignedLongLong:setBytes], @"set_bytes", 
+                                         [NSNumber numberWithUnsignedInteger:[paths count]], @"files", 
+                                         [NSNumber numberWithDouble:windows[i]], @"window_sec", 
+                                         nil];
+            NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                                      [NSNumber numberWithDouble:elapsed * 1e3], @"query_ms", 
+                                      [NSNumber numberWithUnsignedInteger:[records count]], @"records", 
+                                      [NSNumber numberWithUnsignedLongLong:returnedBytes], @"returned_bytes", 
+                                      nil];
+            
+            [reporter reportBenchmark:@"time_range_query" parameters:parameters metrics:metrics];
+        }
+    }
+}
+
+- (void)runFullScanWithReporter:(RBBenchmarkReporter *)reporter paths:(NSArray *)paths {
+    
+    NSString * path = [paths lastObject];
+    CFAbsoluteTime end = [RBExtendedLogReader dayStartForLogFilePath:path] + 18 * 3600;
+    CFAbsoluteTime begin = end - 7200;
+    __block NSUInteger matches = 0;
+    
+    double start = RBBenchmarkTime();
+    
+    @autoreleasepool {
+        
+        RBExtendedLogReader * reader = [[RBExtendedLogReader alloc] initWithContentsOfFile:path error:NULL];
+        
+        [reader enumerateLinesUsingBlock:^(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop) {
+            
+            CFAbsoluteTime timestamp = [reader timestampOfLine:line];
+            
+            if (timestamp >= begin && timestamp <= end && [reader recordForLine:line])
+                matches++;
+        }];
+    }
+    
+    double elapsed = RBBenchmarkTime() - start;
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [NSNumber numberWithUnsignedLongLong:[[self class] byteCountOfFilesAtPaths:[NSArray arrayWithObject:path]]], @"file_bytes", 
+                                 [NSNumber numberWithDouble:7200], @"window_sec", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:elapsed * 1e3], @"scan_ms", 
+                              [NSNumber numberWithUnsignedInteger:matches], @"records", 
+                              nil];
+    
+    [reporter reportBenchmark:@"full_scan" parameters:parameters metrics:metrics];
+}
+
+- (void)runReaderWithReporter:(RBBenchmarkReporter *)reporter {
+    
+    NSString * path = [[self logFilePaths] lastObject];
+    unsigned long long fileBytes = [[self class] byteCountOfFilesAtPaths:[NSArray arrayWithObject:path]];
+    NSString * modes[] = { @"views", @"messages" };
+    
+    for (NSUInteger i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+        
+        BOOL createsMessages = i == 1;
+        __block NSUInteger lineCount = 0;
+        __block NSUInteger messageBytes = 0;
+        double openElapsed = 0;
+        double start = RBBenchmarkTime();
+        
+        @autoreleasepool {
+            
+            RBExtendedLogReader * reader = [[RBExtendedLogReader alloc] initWithContentsOfFile:path error:NULL];
+            
+            openElapsed = RBBenchmarkTime() - start;
+            
+            [reader enumerateLinesUsingBlock:^(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop) {
+                
+                lineCount++;
+                
+                if (!createsMessages) {
+                    messageBytes += line->messageLength;
+                    return;
+                }
+                
+                @autoreleasepool {
+                    messageBytes += [[reader messageOfLine:line] length];
+                }
+            }];
+        }
+        
+        double elapsed = RBBenchmarkTime() - start;
+        
+        NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                     modes[i], @"mode", 
+                                     [NSNumber numberWithUnsignedLongLong:fileBytes], @"file_bytes", 
+                                     nil];
+        NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                                  [NSNumber numberWithDouble:fileBytes / elapsed / (1024 * 1024)], @"mb_per_sec", 
+                                  [NSNumber numberWithDouble:lineCount / elapsed], @"lines_per_sec", 
+                                  [NSNumber numberWithDouble:openElapsed * 1e6], @"open_us", 
+                                  [NSNumber numberWithUnsignedInteger:lineCount], @"lines", 
+                                  [NSNumber numberWithUnsignedInteger:messageBytes], @"message_bytes", 
+                                  nil];
+        
+        [reporter reportBenchmark:@"reader" parameters:parameters metrics:metrics];
+    }
+}
+
+- (void)runSearchWithReporter:(RBBenchmarkReporter *)reporter searchString:(NSString *)searchString {
+    
+    NSUInteger coreCount = [[NSProcessInfo processInfo] activeProcessorCount];
+    unsigned long long setBytes = [[self class] byteCountOfFilesAtPaths:[self logFilePaths]];
+    double singleThreadElapsed = 0;
+    
+    for (NSUInteger threadCount = 1; ; threadCount = MIN(threadCount * 2, coreCount)) {
+        
+        @autoreleasepool {
+            
+            RBLogSearch * search = [[RBLogSearch alloc] initWithSearchString:searchString];
+            
+            [search setMaxConcurrency:threadCount];
+            
+            double start = RBBenchmarkTime();
+            NSArray * records = [search recordsInLogFilesAtPaths:[self logFilePaths] error:NULL];
+            double elapsed = RBBenchmarkTime() - start;
+            
+            if (threadCount == 1)
+                singleThreadElapsed = elapsed;
+            
+            NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                         searchString, @"search", 
+                                         [NSNumber numberWithUnsignedLongLong:setBytes], @"set_bytes", 
+                                         [NSNumber numberWithUnsignedInteger:threadCount], @"threads", 
+                                         nil];
+            NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                                      [NSNumber numberWithDouble:elapsed * 1e3], @"search_ms", 
+                                      [NSNumber numberWithDouble:setBytes / elapsed / (1024 * 1024)], @"mb_per_sec", 
+                                      [NSNumber numberWithDouble:singleThreadElapsed / elapsed], @"speedup", 
+                                      [NSNumber numberWithUnsignedInteger:[records count]], @"matches", 
+                                      nil];
+            
+            [reporter reportBenchmark:@"search" parameters:parameters metrics:metrics];
+        }
+        
+        if (threadCount >= coreCount)
+            break;
+    }
+}
+
++ (NSArray *)writeLogFilesToDirectory:(NSString *)directory dayCount:(NSUInteger)dayCount bytesPerDay:(unsigned long long)bytesPerDay {
+    
+    NSMutableArray * paths = [NSMutableArray array];
+    NSDateFormatter * dayFormatter = [NSDateFormatter new];
+    CFTimeInterval step = kSecondsPerDay * kAverageLineLength / bytesPerDay;
+    NSUInteger recordIndex = 0;
+    
+    [dayFormatter setDateFormat:@"yyyy-MM-dd"];
+    [dayFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+    
+    for (NSUInteger day = 0; day < dayCount; day++) {
+        
+        NSDate * date = [NSDate dateWithTimeIntervalSinceReferenceDate:(3650 + day) * kSecondsPerDay];
+        NSString * dayString = [dayFormatter stringFromDate:date];
+        NSString * path = [directory stringByAppendingPathComponent:[RBLogSegment fileNameForDay:dayString number:0]];
+        CFAbsoluteTime dayStart = [RBLogSegment startTimeOfDay:dayString];
+        RBExtendedLogFile * file = [[RBExtendedLogFile alloc] initWithFilePath:path];
+        CFAbsoluteTime timestamp = dayStart;
+        
+        // Milliseconds keep the lines within a second in order.
+        [file setTimePrecision:RBTimestampPrecisionMilliseconds];
+        
+        while ([file fileSize] < bytesPerDay && timestamp < dayStart + kSecondsPerDay) {
+            
+            @autoreleasepool {
+                
+                NSMutableArray * batch = [NSMutableArray arrayWithCapacity:kRecordsPerBatch];
+                
+                for (NSUInteger i = 0; i < kRecordsPerBatch; i++, recordIndex++, timestamp += step) {
+                    
+                    NSString * message = nil;
+                    RBLogLevel level = RBLogLevelInfo;
+                    
+                    if (recordIndex % kErrorInterval == 0) {
+                        message = @"Request failed: Error Domain=NSURLErrorDomain Code=-1001 \"The request timed out.\"";
+                        level = RBLogLevelError;
+                    }
+                    else if (recordIndex % 3 == 0) {
+                        message = [NSString stringWithFormat:@"Cache miss for key \"user-%lu\"", (unsigned long)(recordIndex % 10000)];
+                    }
+                    else {
+                        message = [NSString stringWithFormat:@"GET /api/items/%lu completed in %lu ms", 
+                                   (unsigned long)recordIndex, (unsigned long)(recordIndex % 250)];
+                    }
+                    
+                    [batch addObject:[[RBLogRecord alloc] initWithMessage:message 
+                                                                     type:RBLogRecordTypeMessage 
+                                                                    level:level 
+                                                                timestamp:MIN(timestamp, dayStart + kSecondsPerDay - 0.001)]];
+                }
+                
+                [file writeRecords:batch error:NULL];
+            }
+        }
+        
+        [file closeFile];
+        [paths addObject:path];
+    }
+    
+    return paths;
+}
+
++ (unsigned long long)byteCountOfFilesAtPaths:(NSArray *)paths {
+    
+    unsigned long long byteCount = 0;
+    
+    for (NSString * path in paths)
+        byteCount += [[[NSFileManager defaultManager] attributesOfItemAtPath:path error:NULL] fileSize];
+    
+    return byteCount;
+}
+
+@end
@@ -0,0 +1,41 @@
+//
+// RBLoggerBenchmarks.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBBenchmarkSuite.h"
+
+
+/**
+ * Benchmarks RBLogger end to end: messages per second through to the log 
+ * file, with the default batch limits and others, the time callers spend 
+ * logging with several threads at once, the time the main thread spends 
+ * logging when formatting is deferred and when it isn't, the cost of 
+ * logging calls whose level is disabled, each sink's throughput and latency 
+ * with a slow sink beside a fast one, and how long purging old log files 
+ * takes as the directory grows.
+ */
+@interface RBLoggerBenchmarks : NSObject <RBBenchmarkSuite>
+
+@end
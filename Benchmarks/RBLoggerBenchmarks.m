@@ -0,0 +1,562 @@
+//
+// RBLoggerBenchmarks.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <stdlib.h>
+
+#import "RBLoggerBenchmarks.h"
+#import "RBBenchmarkReporter.h"
+#import "RBBenchmarkSupport.h"
+#import "NSString+RBExtras.h"
+#import "RBLogger.h"
+#import "RBLogLevel.h"
+#import "RBLogSegment.h"
+#import "RBLogSinkChannel.h"
+#import "RBMemoryLogSink.h"
+#import "RBReporter.h"
+#import "RBSlowLogSink.h"
+
+/// The seconds in a day.
+static const NSTimeInterval kSecondsPerDay = 86400.0;
+
+/// The days of log files the logger keeps by default.
+static const NSUInteger kLogFileAgeLimit = 30;
+
+/// The calls made between drains when measuring main thread latency, well 
+/// under the logger's queue capacity so no call waits or drops.
+static const NSUInteger kLatencyBurstLength = 1000;
+
+
+@interface RBLoggerBenchmarks ()
+
+/**
+ * Measures messages per second from the first call until everything is in 
+ * the log file, with one thread logging.
+ *
+ * @param reporter Receives the results.
+ * @param messageLength The bytes in each message.
+ * @param count The number of messages.
+ */
+- (void)runThroughputWithReporter:(RBBenchmarkReporter *)reporter messageLength:(NSUInteger)messageLength count:(NSUInteger)count;
+
+/**
+ * Measures messages per second with the given batch limits, and how many 
+ * messages went out in each batch written to the log file.
+ *
+ * @param reporter Receives the results.
+ * @param maxBatchSize The logger's maxBatchSize.
+ * @param maxBatchAge The logger's maxBatchAge.
+ * @param count The number of messages.
+ */
+- (void)runBatchThroughputWithReporter:(RBBenchmarkReporter *)reporter maxBatchSize:(NSUInteger)maxBatchSize maxBatchAge:(NSTimeInterval)maxBatchAge count:(NSUInteger)count;
+
+/**
+ * Measures the time each call to -logMessage: takes with several threads 
+ * logging at once. The logger keeps its default drop-oldest policy, so 
+ * callers never wait for the disk.
+ *
+ * @param reporter Receives the results.
+ * @param threadCount The number of logging threads.
+ * @param count The number of messages each thread logs.
+ */
+- (void)runCallerLatencyWithReporter:(RBBenchmarkReporter *)reporter threadCount:(NSUInteger)threadCount count:(NSUInteger)count;
+
+/**
+ * Measures the time the main thread spends in each logging call when 
+ * messages and errors are formatted on the logger's queue, and when the 
+ * caller formats them first.
+ *
+ * @param reporter Receives the results.
+ * @param count The number of calls of each kind.
+ */
+- (void)runMainThreadLatencyWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count;
+
+/**
+ * Times each call of the given block on the calling thread, draining the 
+ * logger between bursts, and reports the percentiles.
+ *
+ * @param reporter Receives the results.
+ * @param mode The name of the way of logging.
+ * @param count The number of calls.
+ * @param block Logs one message to the logger.
+ */
+- (void)runMainThreadLatencyWithReporter:(RBBenchmarkReporter *)reporter mode:(NSString *)mode count:(NSUInteger)count block:(void (^)(RBLogger * logger, NSUInteger index))block;
+
+/**
+ * Measures the nanoseconds a call to a logging macro takes when its level is 
+ * disabled: below the runtime threshold, which costs one atomic load, and 
+ * below RB_LOG_LEVEL_FLOOR, which compiles to nothing. The arguments would 
+ * be costly to build, so any that were evaluated would show.
+ *
+ * @param reporter Receives the results.
+ * @param count The number of calls of each kind.
+ */
+- (void)runDisabledCallSitesWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count;
+
+/**
+ * Reports the time per call of one kind of disabled call site.
+ *
+ * @param reporter Receives the results.
+ * @param callSite The name of the call site.
+ * @param level The level the call site logs at.
+ * @param count The number of calls.
+ * @param elapsed The seconds all the calls took.
+ */
+- (void)reportDisabledCallSite:(NSString *)callSite reporter:(RBBenchmarkReporter *)reporter level:(int)level count:(NSUInteger)count elapsed:(double)elapsed;
+
+/**
+ * Measures fanning messages out to a fast sink and a slow one, each behind 
+ * its own channel, and reports each sink's statistics.
+ *
+ * @param reporter Receives the results.
+ * @param count The number of messages.
+ */
+- (void)runSinkFanOutWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count;
+
+/**
+ * Reports the statistics of one sink.
+ *
+ * @param reporter Receives the results.
+ * @param sinkName The name of the sink.
+ * @param channel The sink's channel.
+ * @param elapsed The seconds from the first message to the last being written.
+ */
+- (void)reportSink:(NSString *)sinkName reporter:(RBBenchmarkReporter *)reporter channel:(RBLogSinkChannel *)channel elapsed:(double)elapsed;
+
+/**
+ * Measures the startup purge of a directory holding the given number of log 
+ * files, half of them old enough to delete.
+ *
+ * @param reporter Receives the results.
+ * @param fileCount The number of log files.
+ */
+- (void)runPurgeWithReporter:(RBBenchmarkReporter *)reporter fileCount:(NSUInteger)fileCount;
+
+/**
+ * Returns a message of the given length.
+ *
+ * @param length The number of characters.
+ *
+ * @return The message.
+ */
++ (NSString *)messageOfLength:(NSUInteger)length;
+
+@end
+
+
+@implementation RBLoggerBenchmarks
+
++ (NSString *)suiteName {
+    return @"logger";
+}
+
+- (void)runWithReporter:(RBBenchmarkReporter *)reporter {
+    
+    BOOL quick = [reporter isQuick];
+    NSUInteger messageCount = quick ? 5000 : 500000;
+    NSUInteger batchSizes[] = { 1, 16, 256, 1024 };
+    NSTimeInterval batchAges[] = { 0.005, 0.05 };
+    NSUInteger threadCounts[] = { 1, 2, 4, 8, 16 };
+    NSUInteger fileCounts[] = { 10, 100, 1000, 10000 };
+    
+    [self runThroughputWithReporter:reporter messageLength:64 count:messageCount];
+    [self runThroughputWithReporter:reporter messageLength:512 count:messageCount];
+    
+    for (NSUInteger i = 0; i < sizeof(batchSizes) / sizeof(batchSizes[0]); i++) {
+        for (NSUInteger j = 0; j < sizeof(batchAges) / sizeof(batchAges[0]); j++) {
+            
+            if (quick && (batchSizes[i] == 1 || batchSizes[i] > 256 || j > 0))
+                continue;
+            
+            [self runBatchThroughputWithReporter:reporter maxBatchSize:batchSizes[i] maxBatchAge:batchAges[j] count:messageCount];
+        }
+    }
+    
+    for (NSUInteger i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++) {
+        
+        if (quick && threadCounts[i] > 4)
+            break;
+        
+        [self runCallerLatencyWithReporter:reporter threadCount:threadCounts[i] count:messageCount / threadCounts[i]];
+    }
+    
+    [self runMainThreadLatencyWithReporter:reporter count:quick ? kLatencyBurstLength : 50 * kLatencyBurstLength];
+    [self runDisabledCallSitesWithReporter:reporter count:messageCount * 20];
+    [self runSinkFanOutWithReporter:reporter count:messageCount / 10];
+    
+    for (NSUInteger i = 0; i < sizeof(fileCounts) / sizeof(fileCounts[0]); i++) {
+        
+        if (quick && fileCounts[i] > 100)
+            break;
+        
+        [self runPurgeWithReporter:reporter fileCount:fileCounts[i]];
+    }
+}
+
+- (void)runThroughputWithReporter:(RBBenchmarkReporter *)reporter messageLength:(NSUInteger)messageLength count:(NSUInteger)count {
+    
+    RBLogger * logger = RBBenchmarkCreateLogger(@"Throughput", nil);
+    NSString * message = [[self class] messageOfLength:messageLength];
+    
+    // Waits rather than drops, so every message reaches the file.
+    [logger setOverflowPolicy:RBLogOverflowBlock];
+    
+    double start = RBBenchmarkTime();
+    
+    for (NSUInteger i = 0; i < count; i++)
+        [logger logMessage:message];
+    
+    RBBenchmarkDrainLogger(logger);
+    
+    double elapsed = RBBenchmarkTime() - start;
+    RBLoggerStatistics statistics = [logger statistics];
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [NSNumber numberWithUnsignedInteger:messageLength], @"message_bytes", 
+                                 [NSNumber numberWithUnsignedInteger:count], @"messages", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:count / elapsed], @"messages_per_sec", 
+                              [NSNumber numberWithDouble:statistics.bytesWritten / elapsed], @"bytes_per_sec", 
+                              [NSNumber numberWithUnsignedLongLong:statistics.messagesWritten], @"messages_written", 
+                              [NSNumber numberWithDouble:statistics.diskLatency.p99 * 1e6], @"disk_latency_p99_us", 
+                              nil];
+    
+    [reporter reportBenchmark:@"throughput" parameters:parameters metrics:metrics];
+}
+
+- (void)runBatchThroughputWithReporter:(RBBenchmarkReporter *)reporter maxBatchSize:(NSUInteger)maxBatchSize maxBatchAge:(NSTimeInterval)maxBatchAge count:(NSUInteger)count {
+    
+    RBLogger * logger = RBBenchmarkCreateLogger(@"Batch", nil);
+    NSString * message = [[self class] messageOfLength:96];
+    
+    [logger setOverflowPolicy:RBLogOverflowBlock];
+    [logger setMaxBatchSize:maxBatchSize];
+    [logger setMaxBatchAge:maxBatchAge];
+    
+    double start = RBBenchmarkTime();
+    
+    for (NSUInteger i = 0; i < count; i++)
+        [logger logMessage:message];
+    
+    RBBenchmarkDrainLogger(logger);
+    
+    double elapsed = RBBenchmarkTime() - start;
+    RBLoggerStatistics statistics = [logger statistics];
+    
+    // Each batch records two write times: formatting it and flushing it.
+    unsigned long long batches = statistics.writeTime.count / 2;
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [NSNumber numberWithUnsignedInteger:maxBatchSize], @"max_batch_size", 
+                                 [NSNumber numberWithDouble:maxBatchAge * 1e3], @"max_batch_age_ms", 
+                                 [NSNumber numberWithUnsignedInteger:count], @"messages", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:count / elapsed], @"messages_per_sec", 
+                              [NSNumber numberWithUnsignedLongLong:batches], @"batches", 
+                              [NSNumber numberWithDouble:batches > 0 ? (double)statistics.messagesWritten / batches : 0], @"messages_per_batch", 
+                              [NSNumber numberWithUnsignedInteger:statistics.maxQueueDepth], @"max_queue_depth", 
+                              [NSNumber numberWithDouble:statistics.diskLatency.p99 * 1e6], @"disk_latency_p99_us", 
+                              nil];
+    
+    [reporter reportBenchmark:@"batch_throughput" parameters:parameters metrics:metrics];
+}
+
+- (void)runCallerLatencyWithReporter:(RBBenchmarkReporter *)reporter threadCount:(NSUInteger)threadCount count:(NSUInteger)count {
+    
+    RBLogger * logger = RBBenchmarkCreateLogger(@"Latency", nil);
+    NSString * message = [[self class] messageOfLength:96];
+    double * durations = calloc(threadCount * count, sizeof(double));
+    
+    double start = RBBenchmarkTime();
+    
+    RBBenchmarkRunThreads(threadCount, ^(NSUInteger thread) {
+        
+        double * threadDurations = durations + thread * count;
+        
+        for (NSUInteger i = 0; i < count; i++) {
+            
+            double callStart = RBBenchmarkTime();
+            [logger logMessage:message];
+            threadDurations[i] = RBBenchmarkTime() - callStart;
+        }
+    });
+    
+    double elapsed = RBBenchmarkTime() - start;
+    NSUInteger total = threadCount * count;
+    
+    RBBenchmarkDrainLogger(logger);
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [NSNumber numberWithUnsignedInteger:threadCount], @"threads", 
+                                 [NSNumber numberWithUnsignedInteger:total], @"messages", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:total / elapsed], @"calls_per_sec", 
+                              [NSNumber numberWithDouble:RBBenchmarkPercentile(durations, total, 0.5) * 1e6], @"p50_us", 
+                              [NSNumber numberWithDouble:RBBenchmarkPercentile(durations, total, 0.99) * 1e6], @"p99_us", 
+                              [NSNumber numberWithDouble:RBBenchmarkPercentile(durations, total, 1.0) * 1e6], @"max_us", 
+                              [NSNumber numberWithUnsignedInteger:[logger droppedMessageCount]], @"dropped", 
+                              nil];
+    
+    free(durations);
+    [reporter reportBenchmark:@"caller_latency" parameters:parameters metrics:metrics];
+}
+
+- (void)runMainThreadLatencyWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count {
+    
+    NSDictionary * userInfo = [NSDictionary dictionaryWithObjectsAndKeys:
+                               @"The request timed out.", NSLocalizedDescriptionKey, 
+                               @"https://example.com/api/items", @"NSErrorFailingURLStringKey", 
+                               nil];
+    NSError * error = [NSError errorWithDomain:@"NSURLErrorDomain" code:-1001 userInfo:userInfo];
+    NSString * name = @"inbox";
+    
+    [self runMainThreadLatencyWithReporter:reporter mode:@"message_eager" count:count block:^(RBLogger * logger, NSUInteger index) {
+        [logger logMessage:[NSString stringWithFormat:@"Loaded %lu items for %@ in %.3f s", (unsigned long)index, name, index * 0.001]];
+    }];
+    [self runMainThreadLatencyWithReporter:reporter mode:@"message_deferred" count:count block:^(RBLogger * logger, NSUInteger index) {
+        [logger logWithLevel:RBLogLevelInfo format:@"Loaded %lu items for %@ in %.3f s", (unsigned long)index, name, index * 0.001];
+    }];
+    [self runMainThreadLatencyWithReporter:reporter mode:@"error_eager" count:count block:^(RBLogger * logger, NSUInteger index) {
+        [logger logMessage:[NSString stringWithError:error] level:RBLogLevelError];
+    }];
+    [self runMainThreadLatencyWithReporter:reporter mode:@"error_deferred" count:count block:^(RBLogger * logger, NSUInteger index) {
+        [logger logError:error];
+    }];
+}
+
+- (void)runMainThreadLatencyWithReporter:(RBBenchmarkReporter *)reporter mode:(NSString *)mode count:(NSUInteger)count block:(void (^)(RBLogger * logger, NSUInteger index))block {
+    
+    RBLogger * logger = RBBenchmarkCreateLogger(@"MainThread", nil);
+    double * durations = calloc(count, sizeof(double));
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        
+        @autoreleasepool {
+            
+            double callStart = RBBenchmarkTime();
+            block(logger, i);
+            durations[i] = RBBenchmarkTime() - callStart;
+        }
+        
+        // Keeps the queue from filling, so only the call itself is measured.
+        if ((i + 1) % kLatencyBurstLength == 0)
+            RBBenchmarkDrainLogger(logger);
+    }
+    
+    RBBenchmarkDrainLogger(logger);
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 mode, @"mode", 
+                                 [NSNumber numberWithBool:[NSThread isMainThread]], @"main_thread", 
+                                 [NSNumber numberWithUnsignedInteger:count], @"calls", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:RBBenchmarkPercentile(durations, count, 0.5) * 1e6], @"p50_us", 
+                              [NSNumber numberWithDouble:RBBenchmarkPercentile(durations, count, 0.99) * 1e6], @"p99_us", 
+                              [NSNumber numberWithDouble:RBBenchmarkPercentile(durations, count, 1.0) * 1e6], @"max_us", 
+                              [NSNumber numberWithUnsignedInteger:[logger droppedMessageCount]], @"dropped", 
+                              nil];
+    
+    free(durations);
+    [reporter reportBenchmark:@"main_thread_latency" parameters:parameters metrics:metrics];
+}
+
+- (void)runDisabledCallSitesWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count {
+    
+    RBLogLevel threshold = RBLogLevelThreshold();
+    NSString * name = @"inbox";
+    double start = 0;
+    
+    // Above every level logged below, so only the checks are measured.
+    RBSetLogLevelThreshold(RBLogLevelWarn);
+    
+    start = RBBenchmarkTime();
+    
+    for (NSUInteger i = 0; i < count; i++)
+        RBLogTrace(@"Loaded %@ for %@", [NSString stringWithFormat:@"%lu items", (unsigned long)i], [name uppercaseString]);
+    
+    [self reportDisabledCallSite:@"trace" reporter:reporter level:RB_LOG_LEVEL_TRACE count:count elapsed:RBBenchmarkTime() - start];
+    
+    start = RBBenchmarkTime();
+    
+    for (NSUInteger i = 0; i < count; i++)
+        RBLogDebug(@"Loaded %@ for %@", [NSString stringWithFormat:@"%lu items", (unsigned long)i], [name uppercaseString]);
+    
+    [self reportDisabledCallSite:@"debug" reporter:reporter level:RB_LOG_LEVEL_DEBUG count:count elapsed:RBBenchmarkTime() - start];
+    
+    // One level under the floor whatever the build configuration, so this 
+    // call site is always compiled out.
+    start = RBBenchmarkTime();
+    
+    for (NSUInteger i = 0; i < count; i++)
+        RBLogWithLevel((RBLogLevel)(RB_LOG_LEVEL_FLOOR - 1), @"Loaded %@ for %@", [NSString stringWithFormat:@"%lu items", (unsigned long)i], [name uppercaseString]);
+    
+    [self reportDisabledCallSite:@"below_floor" reporter:reporter level:RB_LOG_LEVEL_FLOOR - 1 count:count elapsed:RBBenchmarkTime() - start];
+    
+    RBSetLogLevelThreshold(threshold);
+}
+
+- (void)reportDisabledCallSite:(NSString *)callSite reporter:(RBBenchmarkReporter *)reporter level:(int)level count:(NSUInteger)count elapsed:(double)elapsed {
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 callSite, @"call_site", 
+                                 RBNameOfLogLevel(RBLogLevelThreshold()), @"threshold", 
+                                 RBNameOfLogLevel((RBLogLevel)RB_LOG_LEVEL_FLOOR), @"floor", 
+                                 [NSNumber numberWithBool:level >= RB_LOG_LEVEL_FLOOR], @"compiled_in", 
+                                 [NSNumber numberWithUnsignedInteger:count], @"calls", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:elapsed / count * 1e9], @"ns_per_call", 
+                              [NSNumber numberWithDouble:elapsed * 1e3], @"total_ms", 
+                              nil];
+    
+    [reporter reportBenchmark:@"disabled_call_site" parameters:parameters metrics:metrics];
+}
+
+- (void)runSinkFanOutWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count {
+    
+    RBLogger * logger = RBBenchmarkCreateLogger(@"Sinks", nil);
+    NSString * message = [[self class] messageOfLength:96];
+    
+    // Only the memory sink keeps up; the slow one takes a millisecond a batch.
+    RBLogSinkChannel * memoryChannel = [logger addSink:[[RBMemoryLogSink alloc] initWithCapacity:4096] 
+                                              capacity:4096 
+                                        overflowPolicy:RBLogSinkDropOldest];
+    RBLogSinkChannel * slowChannel = [logger addSink:[[RBSlowLogSink alloc] initWithCapacity:4096 delay:0.001] 
+                                            capacity:1024 
+                                      overflowPolicy:RBLogSinkDropOldest];
+    
+    [logger setOverflowPolicy:RBLogOverflowBlock];
+    
+    double start = RBBenchmarkTime();
+    
+    for (NSUInteger i = 0; i < count; i++)
+        [logger logMessage:message];
+    
+    double loggingElapsed = RBBenchmarkTime() - start;
+    
+    RBBenchmarkDrainLogger(logger);
+    
+    double elapsed = RBBenchmarkTime() - start;
+    
+    [self reportSink:@"memory" reporter:reporter channel:memoryChannel elapsed:elapsed];
+    [self reportSink:@"slow" reporter:reporter channel:slowChannel elapsed:elapsed];
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 @"file", @"sink", 
+                                 [NSNumber numberWithUnsignedInteger:count], @"messages", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:count / loggingElapsed], @"logged_per_sec", 
+                              [NSNumber numberWithDouble:[logger statistics].messagesWritten / elapsed], @"records_per_sec", 
+                              [NSNumber numberWithDouble:[logger statistics].diskLatency.p99 * 1e6], @"latency_p99_us", 
+                              nil];
+    
+    [reporter reportBenchmark:@"sink_fan_out" parameters:parameters metrics:metrics];
+}
+
+- (void)reportSink:(NSString *)sinkName reporter:(RBBenchmarkReporter *)reporter channel:(RBLogSinkChannel *)channel elapsed:(double)elapsed {
+    
+    RBLogSinkStatistics statistics = [channel statistics];
+    double written = statistics.recordsWritten > 0 ? (double)statistics.recordsWritten : 1;
+    double batches = statistics.batchesWritten > 0 ? (double)statistics.batchesWritten : 1;
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 sinkName, @"sink", 
+                                 [NSNumber numberWithUnsignedInteger:[channel capacity]], @"capacity", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:statistics.recordsWritten / elapsed], @"records_per_sec", 
+                              [NSNumber numberWithUnsignedLongLong:statistics.recordsWritten], @"records_written", 
+                              [NSNumber numberWithUnsignedLongLong:statistics.recordsDropped], @"records_dropped", 
+                              [NSNumber numberWithUnsignedLongLong:statistics.batchesWritten], @"batches", 
+                              [NSNumber numberWithDouble:statistics.totalWriteTime / batches * 1e6], @"mean_write_us", 
+                              [NSNumber numberWithDouble:statistics.maxWriteTime * 1e6], @"max_write_us", 
+                              [NSNumber numberWithDouble:statistics.totalLatency / written * 1e6], @"mean_latency_us", 
+                              [NSNumber numberWithDouble:statistics.maxLatency * 1e6], @"max_latency_us", 
+                              nil];
+    
+    [reporter reportBenchmark:@"sink_fan_out" parameters:parameters metrics:metrics];
+}
+
+- (void)runPurgeWithReporter:(RBBenchmarkReporter *)reporter fileCount:(NSUInteger)fileCount {
+    
+    NSString * directory = RBBenchmarkCreateTemporaryDirectory(@"Purge");
+    NSDateFormatter * dayFormatter = [NSDateFormatter new];
+    NSData * contents = [[[self class] messageOfLength:1024] dataUsingEncoding:NSUTF8StringEncoding];
+    NSString * today = nil;
+    
+    [dayFormatter setDateFormat:@"yyyy-MM-dd"];
+    [dayFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+    today = [dayFormatter stringFromDate:[NSDate date]];
+    
+    // Half are a day each, older than the limit. The rest are segments of 
+    // today, which are neither purged nor compressed at startup.
+    for (NSUInteger i = 0; i < fileCount; i++) {
+        
+        RBLogSegment * segment = nil;
+        
+        if (i % 2 == 0) {
+            NSDate * day = [NSDate dateWithTimeIntervalSinceNow:-(NSTimeInterval)(kLogFileAgeLimit + 1 + i) * kSecondsPerDay];
+            segment = [[RBLogSegment alloc] initWithDay:[dayFormatter stringFromDate:day] number:0];
+        }
+        else {
+            segment = [[RBLogSegment alloc] initWithDay:today number:i];
+        }
+        
+        [contents writeToFile:[directory stringByAppendingPathComponent:[segment fileName]] atomically:NO];
+    }
+    
+    // The logger indexes the directory and purges it as it starts.
+    double start = RBBenchmarkTime();
+    RBLogger * logger = RBBenchmarkCreateLogger(@"Purge", directory);
+    double elapsed = RBBenchmarkTime() - start;
+    RBLoggerStatistics statistics = [logger statistics];
+    NSArray * fileNames = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:directory error:NULL];
+    NSUInteger remaining = [[fileNames pathsMatchingExtensions:[NSArray arrayWithObject:@"log"]] count];
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObject:[NSNumber numberWithUnsignedInteger:fileCount] 
+                                                            forKey:@"files"];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:statistics.purgeTime.total * 1e3], @"purge_ms", 
+                              [NSNumber numberWithDouble:elapsed * 1e3], @"startup_ms", 
+                              [NSNumber numberWithUnsignedInteger:remaining], @"files_remaining", 
+                              nil];
+    
+    [reporter reportBenchmark:@"purge" parameters:parameters metrics:metrics];
+}
+
++ (NSString *)messageOfLength:(NSUInteger)length {
+    
+    NSMutableString * message = [NSMutableString stringWithCapacity:length];
+    
+    while ([message length] < length)
+        [message appendString:@"Request failed with a timeout; retrying. "];
+    
+    return [message substringToIndex:length];
+}
+
+@end
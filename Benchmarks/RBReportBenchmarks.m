@@ -0,0 +1,145 @@
+//
+// RBReportBenchmarks.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBReportBenchmarks.h"
+#import "RBBenchmarkEmailBuilder.h"
+#import "RBBenchmarkReporter.h"
+#import "RBBenchmarkSupport.h"
+#import "RBMappedAttachment.h"
+#import "RBReportPackager.h"
+
+/// The bytes written to an attachment's file at a time.
+static const NSUInteger kChunkLength = 1024 * 1024;
+
+
+@interface RBReportBenchmarks ()
+
+/**
+ * Measures writing a report with one attachment of the given size.
+ *
+ * @param reporter Receives the results.
+ * @param byteCount The size of the attachment.
+ * @param mapped Whether to use RBMappedAttachment instead of 
+ * RBStandardAttachment.
+ */
+- (void)runReportWithReporter:(RBBenchmarkReporter *)reporter attachmentSize:(unsigned long long)byteCount mapped:(BOOL)mapped;
+
+/**
+ * Writes a file of log lines of the given size, a chunk at a time.
+ *
+ * @param path Where to write the file.
+ * @param byteCount The size of the file.
+ */
++ (void)writeFileAtPath:(NSString *)path byteCount:(unsigned long long)byteCount;
+
+@end
+
+
+@implementation RBReportBenchmarks
+
++ (NSString *)suiteName {
+    return @"report";
+}
+
+- (void)runWithReporter:(RBBenchmarkReporter *)reporter {
+    
+    unsigned long long sizes[] = { 1, 16, 128 };
+    
+    for (NSUInteger i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        
+        if ([reporter isQuick] && sizes[i] > 1)
+            break;
+        
+        [self runReportWithReporter:reporter attachmentSize:sizes[i] * 1024 * 1024 mapped:NO];
+        [self runReportWithReporter:reporter attachmentSize:sizes[i] * 1024 * 1024 mapped:YES];
+    }
+}
+
+- (void)runReportWithReporter:(RBBenchmarkReporter *)reporter attachmentSize:(unsigned long long)byteCount mapped:(BOOL)mapped {
+    
+    NSString * directory = RBBenchmarkCreateTemporaryDirectory(@"Report");
+    NSString * attachmentPath = [directory stringByAppendingPathComponent:@"Attachment.log"];
+    NSString * reportPath = [directory stringByAppendingPathComponent:@"Report.eml"];
+    __block BOOL written = NO;
+    __block double elapsed = 0;
+    
+    [[self class] writeFileAtPath:attachmentPath byteCount:byteCount];
+    
+    unsigned long long baseline = RBBenchmarkResidentBytes();
+    unsigned long long peak = RBBenchmarkPeakResidentBytesDuring(^{
+        
+        @autoreleasepool {
+            
+            Class attachmentClass = mapped ? [RBMappedAttachment class] : [RBStandardAttachment class];
+            RBStandardAttachment * attachment = [[attachmentClass alloc] initWithFilePath:attachmentPath];
+            RBBenchmarkEmailBuilder * builder = [[RBBenchmarkEmailBuilder alloc] initWithAttachments:[NSArray arrayWithObject:attachment]];
+            RBReportPackager * packager = [[RBReportPackager alloc] initWithEmailBuilder:builder];
+            double start = RBBenchmarkTime();
+            
+            written = [packager writeReportToPath:reportPath error:NULL];
+            elapsed = RBBenchmarkTime() - start;
+        }
+    });
+    
+    NSDictionary * attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:reportPath error:NULL];
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [NSNumber numberWithUnsignedLongLong:byteCount], @"attachment_bytes", 
+                                 mapped ? @"mapped" : @"standard", @"attachment", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:elapsed * 1e3], @"assembly_ms", 
+                              [NSNumber numberWithDouble:byteCount / elapsed / (1024 * 1024)], @"mb_per_sec", 
+                              [NSNumber numberWithUnsignedLongLong:peak > baseline ? peak - baseline : 0], @"peak_rss_delta_bytes", 
+                              [NSNumber numberWithUnsignedLongLong:[attributes fileSize]], @"report_bytes", 
+                              [NSNumber numberWithBool:written], @"succeeded", 
+                              nil];
+    
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+    [reporter reportBenchmark:@"assembly" parameters:parameters metrics:metrics];
+}
+
++ (void)writeFileAtPath:(NSString *)path byteCount:(unsigned long long)byteCount {
+    
+    NSMutableData * chunk = [NSMutableData dataWithCapacity:kChunkLength];
+    NSData * line = [@"12:00:00.000 INFO \"Request failed with a timeout; retrying.\"\n" dataUsingEncoding:NSUTF8StringEncoding];
+    NSFileHandle * handle = nil;
+    
+    while ([chunk length] + [line length] <= kChunkLength)
+        [chunk appendData:line];
+    
+    [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+    handle = [NSFileHandle fileHandleForWritingAtPath:path];
+    
+    for (unsigned long long written = 0; written < byteCount; written += [chunk length]) {
+        
+        if (byteCount - written < [chunk length])
+            [chunk setLength:(NSUInteger)(byteCount - written)];
+        
+        [handle writeData:chunk];
+    }
+    
+    [handle closeFile];
+}
+
+@end
@@ -0,0 +1,191 @@
+//
+// RBRingBufferBenchmarks.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <dispatch/dispatch.h>
+#import <sched.h>
+#import <stdatomic.h>
+#import <stdbool.h>
+
+#import "RBRingBufferBenchmarks.h"
+#import "RBBenchmarkReporter.h"
+#import "RBBenchmarkSupport.h"
+#import "RBLogRingBuffer.h"
+#import "RBLogger.h"
+
+/// The slots in the buffer, the same as the logger's queue of pending messages.
+static const NSUInteger kBufferCapacity = 4096;
+
+
+@interface RBRingBufferBenchmarks ()
+
+/**
+ * Measures enqueues per second with the given number of producers and one 
+ * consumer. Full buffers are handled the way RBLogger handles them.
+ *
+ * @param reporter Receives the results.
+ * @param threadCount The number of producer threads.
+ * @param policy What producers do when the buffer is full.
+ * @param count The number of messages each producer enqueues.
+ */
+- (void)runContentionWithReporter:(RBBenchmarkReporter *)reporter threadCount:(NSUInteger)threadCount policy:(RBLogOverflowPolicy)policy count:(NSUInteger)count;
+
+/**
+ * Returns the name of the given policy for reports.
+ *
+ * @param policy The policy.
+ *
+ * @return The name.
+ */
++ (NSString *)nameOfPolicy:(RBLogOverflowPolicy)policy;
+
+@end
+
+
+@implementation RBRingBufferBenchmarks
+
++ (NSString *)suiteName {
+    return @"ring_buffer";
+}
+
+- (void)runWithReporter:(RBBenchmarkReporter *)reporter {
+    
+    BOOL quick = [reporter isQuick];
+    NSUInteger threadCounts[] = { 1, 2, 4, 8, 16 };
+    RBLogOverflowPolicy policies[] = { RBLogOverflowDropNewest, RBLogOverflowDropOldest, RBLogOverflowBlock };
+    
+    for (NSUInteger i = 0; i < sizeof(policies) / sizeof(policies[0]); i++) {
+        for (NSUInteger j = 0; j < sizeof(threadCounts) / sizeof(threadCounts[0]); j++) {
+            
+            if (quick && threadCounts[j] > 4)
+                break;
+            
+            [self runContentionWithReporter:reporter 
+                                threadCount:threadCounts[j] 
+                                     policy:policies[i] 
+                                      count:quick ? 10000 : 1000000 / threadCounts[j]];
+        }
+    }
+}
+
+- (void)runContentionWithReporter:(RBBenchmarkReporter *)reporter threadCount:(NSUInteger)threadCount policy:(RBLogOverflowPolicy)policy count:(NSUInteger)count {
+    
+    RBLogRingBuffer * buffer = [[RBLogRingBuffer alloc] initWithCapacity:kBufferCapacity];
+    NSString * message = @"Request failed with a timeout; retrying.";
+    dispatch_group_t group = dispatch_group_create();
+    
+    // The consumer is waited for below, so it can use this method's variables.
+    _Atomic(bool) producing = true;
+    _Atomic(unsigned long long) dropped = 0;
+    _Atomic(unsigned long long) consumed = 0;
+    _Atomic(bool) * isProducing = &producing;
+    _Atomic(unsigned long long) * droppedCount = &dropped;
+    _Atomic(unsigned long long) * consumedCount = &consumed;
+    
+    dispatch_group_async(group, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+        
+        for (;;) {
+            
+            BOOL wasProducing = atomic_load(isProducing);
+            
+            @autoreleasepool {
+                
+                while ([buffer dequeueRecordWithTag:NULL])
+                    atomic_fetch_add_explicit(consumedCount, 1, memory_order_relaxed);
+            }
+            
+            // Only stops once the buffer was emptied after the producers finished.
+            if (!wasProducing)
+                break;
+            
+            sched_yield();
+        }
+    });
+    
+    double start = RBBenchmarkTime();
+    
+    RBBenchmarkRunThreads(threadCount, ^(NSUInteger thread) {
+        
+        for (NSUInteger i = 0; i < count; i++) {
+            
+            CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+            
+            while (![buffer enqueueMessage:message type:RBLogRecordTypeMessage level:RBLogLevelInfo timestamp:now tag:0]) {
+                
+                if (policy == RBLogOverflowDropNewest) {
+                    atomic_fetch_add_explicit(droppedCount, 1, memory_order_relaxed);
+                    break;
+                }
+                
+                if (policy == RBLogOverflowDropOldest) {
+                    
+                    if ([buffer discardOldestWithTag:NULL])
+                        atomic_fetch_add_explicit(droppedCount, 1, memory_order_relaxed);
+                }
+                else {
+                    sched_yield();
+                }
+            }
+        }
+    });
+    
+    double elapsed = RBBenchmarkTime() - start;
+    
+    atomic_store(&producing, false);
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+    
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(group);
+#endif
+    
+    NSUInteger total = threadCount * count;
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 [NSNumber numberWithUnsignedInteger:threadCount], @"producers", 
+                                 [[self class] nameOfPolicy:policy], @"policy", 
+                                 [NSNumber numberWithUnsignedInteger:total], @"messages", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:total / elapsed], @"enqueues_per_sec", 
+                              [NSNumber numberWithDouble:elapsed * 1e9 * threadCount / total], @"ns_per_enqueue", 
+                              [NSNumber numberWithUnsignedLongLong:atomic_load(&dropped)], @"dropped", 
+                              [NSNumber numberWithUnsignedLongLong:atomic_load(&consumed)], @"consumed", 
+                              nil];
+    
+    [reporter reportBenchmark:@"contention" parameters:parameters metrics:metrics];
+}
+
++ (NSString *)nameOfPolicy:(RBLogOverflowPolicy)policy {
+    
+    switch (policy) {
+        case RBLogOverflowDropNewest:
+            return @"drop_newest";
+        case RBLogOverflowDropOldest:
+            return @"drop_oldest";
+        case RBLogOverflowBlock:
+            return @"block";
+    }
+    
+    return @"unknown";
+}
+
+@end
@@ -0,0 +1,149 @@
+//
+// RBTimestampBenchmarks.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBTimestampBenchmarks.h"
+#import "RBBenchmarkReporter.h"
+#import "RBBenchmarkSupport.h"
+#import "RBTimestampEncoder.h"
+
+/// The time between consecutive encoded times, like a busy log.
+static const CFTimeInterval kTimeStep = 0.0001;
+
+
+@interface RBTimestampBenchmarks ()
+
+/**
+ * Measures encoding consecutive times with RBTimestampEncoder.
+ *
+ * @param reporter Receives the results.
+ * @param precision The encoder's precision.
+ * @param count The number of times to encode.
+ */
+- (void)runEncoderWithReporter:(RBBenchmarkReporter *)reporter precision:(RBTimestampPrecision)precision count:(NSUInteger)count;
+
+/**
+ * Measures formatting the same times the way RBExtendedLogFile used to, with 
+ * an NSDateFormatter and a conversion to UTF-8.
+ *
+ * @param reporter Receives the results.
+ * @param count The number of times to format.
+ */
+- (void)runDateFormatterWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count;
+
+/**
+ * Reports the cost of one way of formatting times.
+ *
+ * @param reporter Receives the results.
+ * @param formatter The name of the way of formatting.
+ * @param count The number of times formatted.
+ * @param elapsed The seconds taken.
+ */
+- (void)reportFormatter:(NSString *)formatter reporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count elapsed:(double)elapsed;
+
+@end
+
+
+@implementation RBTimestampBenchmarks
+
++ (NSString *)suiteName {
+    return @"timestamp";
+}
+
+- (void)runWithReporter:(RBBenchmarkReporter *)reporter {
+    
+    NSUInteger count = [reporter isQuick] ? 10000 : 1000000;
+    
+    [self runEncoderWithReporter:reporter precision:RBTimestampPrecisionSeconds count:count];
+    [self runEncoderWithReporter:reporter precision:RBTimestampPrecisionMilliseconds count:count];
+    [self runEncoderWithReporter:reporter precision:RBTimestampPrecisionMicroseconds count:count];
+    [self runDateFormatterWithReporter:reporter count:count];
+}
+
+- (void)runEncoderWithReporter:(RBBenchmarkReporter *)reporter precision:(RBTimestampPrecision)precision count:(NSUInteger)count {
+    
+    RBTimestampEncoder * encoder = [RBTimestampEncoder new];
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent();
+    char buffer[RB_TIMESTAMP_MAX_LENGTH];
+    NSUInteger checksum = 0;
+    NSString * names[] = { @"encoder_seconds", @"encoder_milliseconds", @"encoder_microseconds" };
+    
+    [encoder setPrecision:precision];
+    
+    double start = RBBenchmarkTime();
+    
+    // Sums the lengths so the encoding can't be optimized away.
+    for (NSUInteger i = 0; i < count; i++)
+        checksum += [encoder encodeTime:time + i * kTimeStep intoBuffer:buffer] + buffer[7];
+    
+    double elapsed = RBBenchmarkTime() - start;
+    
+    if (checksum == 0)
+        NSLog(@"Nothing was encoded.");
+    
+    [self reportFormatter:names[precision] reporter:reporter count:count elapsed:elapsed];
+}
+
+- (void)runDateFormatterWithReporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count {
+    
+    NSDateFormatter * formatter = [NSDateFormatter new];
+    CFAbsoluteTime time = CFAbsoluteTimeGetCurrent();
+    NSUInteger checksum = 0;
+    
+    [formatter setDateFormat:@"HH:mm:ss"];
+    [formatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+    
+    double start = RBBenchmarkTime();
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        
+        @autoreleasepool {
+            
+            NSDate * date = [NSDate dateWithTimeIntervalSinceReferenceDate:time + i * kTimeStep];
+            checksum += [[[formatter stringFromDate:date] dataUsingEncoding:NSUTF8StringEncoding] length];
+        }
+    }
+    
+    double elapsed = RBBenchmarkTime() - start;
+    
+    if (checksum == 0)
+        NSLog(@"Nothing was formatted.");
+    
+    [self reportFormatter:@"date_formatter" reporter:reporter count:count elapsed:elapsed];
+}
+
+- (void)reportFormatter:(NSString *)formatter reporter:(RBBenchmarkReporter *)reporter count:(NSUInteger)count elapsed:(double)elapsed {
+    
+    NSDictionary * parameters = [NSDictionary dictionaryWithObjectsAndKeys:
+                                 formatter, @"formatter", 
+                                 [NSNumber numberWithUnsignedInteger:count], @"times", 
+                                 nil];
+    NSDictionary * metrics = [NSDictionary dictionaryWithObjectsAndKeys:
+                              [NSNumber numberWithDouble:count / elapsed], @"times_per_sec", 
+                              [NSNumber numberWithDouble:elapsed * 1e9 / count], @"ns_per_time", 
+                              nil];
+    
+    [reporter reportBenchmark:@"format" parameters:parameters metrics:metrics];
+}
+
+@end
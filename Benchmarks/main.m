@@ -0,0 +1,139 @@
+//
+// main.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <stdio.h>
+
+#import "RBBenchmarkReporter.h"
+#import "RBBenchmarkSuite.h"
+#import "RBLogFileBenchmarks.h"
+#import "RBLogReadingBenchmarks.h"
+#import "RBLoggerBenchmarks.h"
+#import "RBReportBenchmarks.h"
+#import "RBRingBufferBenchmarks.h"
+#import "RBTimestampBenchmarks.h"
+
+
+/**
+ * Returns the classes of every benchmark suite, in the order they run.
+ *
+ * @return An array of classes conforming to RBBenchmarkSuite.
+ */
+static NSArray * RBBenchmarkSuiteClasses(void) {
+    return [NSArray arrayWithObjects:
+            [RBRingBufferBenchmarks class], 
+            [RBTimestampBenchmarks class], 
+            [RBLogFileBenchmarks class], 
+            [RBLoggerBenchmarks class], 
+            [RBLogReadingBenchmarks class], 
+            [RBReportBenchmarks class], 
+            nil];
+}
+
+/**
+ * Prints how to run the benchmarks.
+ */
+static void RBPrintUsage(void) {
+    fprintf(stderr, 
+            "Usage: RBReporterBenchmarks [--csv] [--quick] [--output <path>] [--suite <name>]... [--list]\n"
+            "  --csv      Writes CSV rows instead of JSON lines.\n"
+            "  --quick    Runs small sizes only, as a smoke test.\n"
+            "  --output   Writes results to the file instead of standard output.\n"
+            "  --suite    Runs only the named suite. May be repeated.\n"
+            "  --list     Lists the suites and exits.\n");
+}
+
+int main(int argc, const char * argv[]) {
+    
+    @autoreleasepool {
+        
+        RBBenchmarkFormat format = RBBenchmarkFormatJSON;
+        BOOL quick = NO;
+        NSString * outputPath = nil;
+        NSMutableSet * suiteNames = [NSMutableSet set];
+        NSFileHandle * fileHandle = nil;
+        RBBenchmarkReporter * reporter = nil;
+        
+        for (int i = 1; i < argc; i++) {
+            
+            NSString * argument = [NSString stringWithUTF8String:argv[i]];
+            
+            if ([argument isEqualToString:@"--csv"])
+                format = RBBenchmarkFormatCSV;
+            else if ([argument isEqualToString:@"--quick"])
+                quick = YES;
+            else if ([argument isEqualToString:@"--output"] && i + 1 < argc)
+                outputPath = [NSString stringWithUTF8String:argv[++i]];
+            else if ([argument isEqualToString:@"--suite"] && i + 1 < argc)
+                [suiteNames addObject:[NSString stringWithUTF8String:argv[++i]]];
+            else if ([argument isEqualToString:@"--list"]) {
+                
+                for (Class suiteClass in RBBenchmarkSuiteClasses())
+                    printf("%s\n", [[suiteClass suiteName] UTF8String]);
+                
+                return 0;
+            }
+            else {
+                RBPrintUsage();
+                return 2;
+            }
+        }
+        
+        if (outputPath) {
+            
+            [[NSFileManager defaultManager] createFileAtPath:outputPath contents:nil attributes:nil];
+            fileHandle = [NSFileHandle fileHandleForWritingAtPath:outputPath];
+            
+            if (!fileHandle) {
+                fprintf(stderr, "Can't write to %s\n", [outputPath UTF8String]);
+                return 1;
+            }
+        }
+        else {
+            fileHandle = [NSFileHandle fileHandleWithStandardOutput];
+        }
+        
+        reporter = [[RBBenchmarkReporter alloc] initWithFormat:format fileHandle:fileHandle];
+        [reporter setQuick:quick];
+        
+        for (Class suiteClass in RBBenchmarkSuiteClasses()) {
+            
+            if ([suiteNames count] > 0 && ![suiteNames containsObject:[suiteClass suiteName]])
+                continue;
+            
+            @autoreleasepool {
+                
+                id<RBBenchmarkSuite> suite = [suiteClass new];
+                
+                [reporter setSuiteName:[suiteClass suiteName]];
+                [suite runWithReporter:reporter];
+            }
+        }
+        
+        if (outputPath)
+            [fileHandle closeFile];
+    }
+    
+    return 0;
+}
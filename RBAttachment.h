@@ -42,4 +42,28 @@
  */
 - (NSString *)fileName;
 
+@optional
+
+/**
+ * The length of the attachment in bytes. Lets a consumer size its output 
+ * without reading the attachment.
+ *
+ * @return The length of the attachment.
+ */
+- (unsigned long long)length;
+
+/**
+ * Reads the attachment in chunks instead of loading it all into memory. 
+ * Consumers should prefer this over -data when it is available.
+ *
+ * @param block Called with each chunk, in order. The bytes are only valid 
+ * during the call. Set stop to YES to stop reading.
+ * @param error An error is returned by reference if the attachment can't be 
+ * read.
+ *
+ * @return YES if the attachment was read, NO otherwise.
+ */
+- (BOOL)enumerateChunksUsingBlock:(void (^)(const void * bytes, NSUInteger length, BOOL * stop))block 
+                            error:(NSError **)error;
+
 @end
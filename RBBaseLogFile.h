@@ -33,4 +33,77 @@ extern const NSInteger RBLogFileCreationError;
  */
 - (NSString *)filePath;
 
+/**
+ * Reads the contents of the log file in chunks. If the file has been 
+ * compressed by RBLogFileCompressor, the compressed contents are decompressed 
+ * transparently. Text still in the write buffer isn't included.
+ *
+ * @param block Called with each chunk. The bytes are only valid during the 
+ * call. Set stop to YES to stop reading.
+ * @param error An error is returned by reference if the file can't be read.
+ *
+ * @return YES if the file was read, NO otherwise.
+ */
+- (BOOL)enumerateContentsUsingBlock:(void (^)(const void * bytes, NSUInteger length, BOOL * stop))block 
+                              error:(NSError **)error;
+
+/**
+ * Returns whether or not the underlying file is currently open for writing.
+ *
+ * @return YES if the file is open, NO otherwise.
+ */
+- (BOOL)isOpen;
+
+/**
+ * Returns the size of the log file in bytes, including text that is still in 
+ * the write buffer. Only accurate while the file is open.
+ *
+ * @return The size of the log file.
+ */
+- (unsigned long long)fileSize;
+
+/**
+ * Opens the underlying file for appending, creating it if necessary. The file 
+ * is kept open until -closeFile is called or the log file is deallocated. Does
+ * nothing if the file is already open.
+ *
+ * @param error An error is returned by reference if the file can't be opened.
+ *
+ * @return YES if the file is open, NO otherwise.
+ */
+- (BOOL)openFile:(NSError **)error;
+
+/**
+ * Appends the given data to the write buffer. The buffer is written to the 
+ * underlying file once it grows past kLogFileBufferSize bytes or when -flush: 
+ * is called. Subclasses should use this rather than writing to the file 
+ * directly.
+ *
+ * @param data The bytes to append to the log file.
+ * @param error An error is returned by reference if the data can't be written.
+ *
+ * @return YES if the data was buffered or written, NO otherwise.
+ */
+- (BOOL)appendData:(NSData *)data error:(NSError **)error;
+
+/**
+ * Appends the formatted bytes of the given record to the given buffer. The 
+ * default implementation appends the message as UTF-8. Subclasses override 
+ * this to define their own line format.
+ *
+ * @param record The record to format.
+ * @param data The buffer to append to.
+ */
+- (void)appendRecord:(RBLogRecord *)record toData:(NSMutableData *)data;
+
+/**
+ * Called by -writeRecords:error: just before each record is formatted, with 
+ * the offset its bytes will start at in the underlying file. Does nothing by 
+ * default. Subclasses override this to index their files.
+ *
+ * @param record The record about to be appended.
+ * @param offset The offset of the record in the underlying file.
+ */
+- (void)willAppendRecord:(RBLogRecord *)record atOffset:(unsigned long long)offset;
+
 @end
@@ -6,54 +6,246 @@
 //  Copyright 2011 Robert Brown. All rights reserved.
 //
 
+#import <errno.h>
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
 #import "RBBaseLogFile.h"
+#import "RBLogFileCompressor.h"
 
 
 const NSInteger RBLogFileCreationError = 3000;
 
+/**
+ * The number of bytes the write buffer may hold before it is written to the 
+ * underlying file.
+ */
+static const NSUInteger kLogFileBufferSize = 16 * 1024;
 
-@interface RBBaseLogFile ()
+
+@interface RBBaseLogFile () {
+    
+    /// The descriptor of the open file, or -1 if the file isn't open.
+    int fileDescriptor;
+    
+    /// The number of bytes in the underlying file.
+    unsigned long long diskSize;
+}
 
 /**
  * A string representing the path to the underlying file.
  */
 @property (nonatomic, copy) NSString * filePath;
 
+/**
+ * Text that has been written to the log file but not yet to the underlying 
+ * file.
+ */
+@property (nonatomic, strong) NSMutableData * writeBuffer;
+
+/**
+ * Returns an error describing the current value of errno.
+ *
+ * @return An error in the POSIX domain.
+ */
++ (NSError *)errorWithErrno;
+
 @end
 
 
 @implementation RBBaseLogFile
 
-@synthesize filePath;
+@synthesize filePath, writeBuffer;
 
 - (id)initWithFilePath:(NSString *)path {
     
     if ((self = [super init])) {
         [self setFilePath:path];
+        [self setWriteBuffer:[NSMutableData dataWithCapacity:kLogFileBufferSize]];
+        fileDescriptor = -1;
     }
     
     return self;
 }
 
+- (void)dealloc {
+    [self closeFile];
+}
+
 - (BOOL)write:(NSString *)text {
     return [self write:text error:NULL];
 }
 
 - (BOOL)write:(NSString *)text error:(NSError **)error {
     
-    NSData * data = [text dataUsingEncoding:NSUTF8StringEncoding];
-    NSOutputStream * outFile = [NSOutputStream outputStreamToFileAtPath:[self filePath] 
-                                                                 append:YES];
-    [outFile open];
-    [outFile write:[data bytes] maxLength:[data length]];
-    [outFile close];
+    NSArray * records = [NSArray arrayWithObject:[RBLogRecord recordWithMessage:text]];
+    
+    return [self writeRecords:records error:error];
+}
+
+- (BOOL)writeRecords:(NSArray *)records error:(NSError **)error {
+    
+    if (![self openFile:error])
+        return NO;
+    
+    // Formats the whole batch into the buffer so it can go out in a single write.
+    NSMutableData * buffer = [self writeBuffer];
+    
+    for (RBLogRecord * record in records) {
+        [self willAppendRecord:record atOffset:diskSize + [buffer length]];
+        [self appendRecord:record toData:buffer];
+    }
+    
+    if ([buffer length] >= kLogFileBufferSize)
+        return [self flush:error];
     
     return YES;
 }
 
+- (void)appendRecord:(RBLogRecord *)record toData:(NSMutableData *)data {
+    
+    NSString * text = [record message];
+    
+    [data appendBytes:[text UTF8String] 
+               length:[text lengthOfBytesUsingEncoding:NSUTF8StringEncoding]];
+}
+
+- (void)willAppendRecord:(RBLogRecord *)record atOffset:(unsigned long long)offset {
+    // Overridden by subclasses that index their files.
+}
+
+- (BOOL)isOpen {
+    return fileDescriptor >= 0;
+}
+
+- (BOOL)openFile:(NSError **)error {
+    
+    if ([self isOpen])
+        return YES;
+    
+    // The descriptor is append-only so every write lands at the end of the file.
+    fileDescriptor = open([[self filePath] fileSystemRepresentation], 
+                          O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 
+                          0644);
+    
+    if (fileDescriptor < 0) {
+        
+        if (error != NULL)
+            *error = [[self class] errorWithErrno];
+        
+        return NO;
+    }
+    
+    // Tracks the size from here on so it never needs to be stat'ed again.
+    struct stat info;
+    diskSize = fstat(fileDescriptor, &info) == 0 ? (unsigned long long)info.st_size : 0;
+    
+    return YES;
+}
+
+- (unsigned long long)fileSize {
+    return diskSize + [[self writeBuffer] length];
+}
+
+- (BOOL)appendData:(NSData *)data error:(NSError **)error {
+    
+    [[self writeBuffer] appendData:data];
+    
+    if ([[self writeBuffer] length] >= kLogFileBufferSize)
+        return [self flush:error];
+    
+    return YES;
+}
+
+- (BOOL)flush:(NSError **)error {
+    
+    NSMutableData * buffer = [self writeBuffer];
+    
+    if ([buffer length] == 0)
+        return YES;
+    
+    if (![self openFile:error])
+        return NO;
+    
+    const char * bytes = [buffer bytes];
+    size_t remaining = [buffer length];
+    
+    // Writes may be partial or interrupted, so loops until everything is written.
+    while (remaining > 0) {
+        
+        ssize_t written = write(fileDescriptor, bytes, remaining);
+        
+        if (written < 0) {
+            
+            if (errno == EINTR)
+                continue;
+            
+            if (error != NULL)
+                *error = [[self class] errorWithErrno];
+            
+            // Keeps whatever wasn't written so it can be retried.
+            [buffer replaceBytesInRange:NSMakeRange(0, [buffer length] - remaining) 
+                              withBytes:NULL 
+                                 length:0];
+            
+            return NO;
+        }
+        
+        bytes += written;
+        remaining -= written;
+        diskSize += written;
+    }
+    
+    [buffer setLength:0];
+    
+    return YES;
+}
+
+- (void)closeFile {
+    
+    [self flush:NULL];
+    
+    if ([self isOpen]) {
+        close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+}
+
++ (NSError *)errorWithErrno {
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+}
+
 - (BOOL)underlyingFileExists {
     
-    return [[NSFileManager defaultManager] fileExistsAtPath:[self filePath]];
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    NSString * path = [self filePath];
+    
+    return ([fileManager fileExistsAtPath:path] || 
+            [fileManager fileExistsAtPath:[RBLogFileCompressor compressedPathForPath:path]]);
+}
+
+- (BOOL)enumerateContentsUsingBlock:(void (^)(const void *, NSUInteger, BOOL *))block error:(NSError **)error {
+    
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    NSString * path = [self filePath];
+    NSString * compressedPath = [RBLogFileCompressor compressedPathForPath:path];
+    __block BOOL stopped = NO;
+    
+    void (^chunkBlock)(const void *, NSUInteger, BOOL *) = ^(const void * bytes, NSUInteger length, BOOL * stop) {
+        block(bytes, length, stop);
+        stopped = *stop;
+    };
+    
+    // A compressed file is older than anything written to the plain file since.
+    if ([fileManager fileExistsAtPath:compressedPath] &&
+        ![RBLogFileCompressor enumerateChunksOfFileAtPath:compressedPath usingBlock:chunkBlock error:error])
+        return NO;
+    
+    if (!stopped && [fileManager fileExistsAtPath:path])
+        return [RBLogFileCompressor enumerateChunksOfFileAtPath:path usingBlock:chunkBlock error:error];
+    
+    return YES;
 }
 
 
@@ -0,0 +1,98 @@
+//
+// RBBinaryLogDecoder.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogRecord.h"
+
+/// The error code for a binary log file that can't be decoded.
+extern const NSInteger RBBinaryLogDecodingError;
+
+
+/**
+ * Reads log files written by RBBinaryLogFile and renders them as the text 
+ * RBExtendedLogFile would have written.
+ */
+@interface RBBinaryLogDecoder : NSObject
+
+/// The app name stored in the file header.
+@property (nonatomic, copy, readonly) NSString * appName;
+
+/// The app version stored in the file header.
+@property (nonatomic, copy, readonly) NSString * appVersion;
+
+/// The date the file was created, as stored in the file header.
+@property (nonatomic, copy, readonly) NSString * dateString;
+
+/**
+ * Standard initializer. Reads the file header.
+ *
+ * @param data The contents of a binary log file.
+ * @param error An error is returned by reference if the header is invalid.
+ *
+ * @return self, or nil if the data isn't a binary log file.
+ */
+- (id)initWithData:(NSData *)data error:(NSError **)error;
+
+/**
+ * Calls the given block with each record in the file, in order. A truncated 
+ * record at the end of the file, such as one cut off by a crash, is ignored.
+ *
+ * @param block The block to call. Set stop to YES to stop enumerating.
+ * @param error An error is returned by reference if a record is invalid.
+ *
+ * @return YES if every record was read, NO otherwise.
+ */
+- (BOOL)enumerateRecordsUsingBlock:(void (^)(RBLogRecord * record, BOOL * stop))block error:(NSError **)error;
+
+/**
+ * Renders the whole file, header included, in the extended log format.
+ *
+ * @param error An error is returned by reference if a record is invalid.
+ *
+ * @return The UTF-8 text of the log, or nil if it can't be decoded.
+ */
+- (NSData *)extendedLogData:(NSError **)error;
+
+/**
+ * Returns whether the given data starts like a binary log file.
+ *
+ * @param data The data to check.
+ *
+ * @return YES if the data is a binary log file, NO otherwise.
+ */
++ (BOOL)isBinaryLogData:(NSData *)data;
+
+/**
+ * Convenience method that renders the binary log file at the given path in the 
+ * extended log format. The file is memory mapped rather than read.
+ *
+ * @param path The path of the binary log file.
+ * @param error An error is returned by reference if the file can't be read.
+ *
+ * @return The UTF-8 text of the log, or nil if it can't be decoded.
+ */
++ (NSData *)extendedLogDataWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+@end
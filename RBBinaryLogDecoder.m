@@ -0,0 +1,251 @@
+//
+// RBBinaryLogDecoder.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <string.h>
+
+#import "RBBinaryLogDecoder.h"
+#import "RBBinaryLogFile.h"
+#import "RBExtendedLogFile.h"
+#import "NSError+RBExtras.h"
+
+const NSInteger RBBinaryLogDecodingError = 3001;
+
+
+@interface RBBinaryLogDecoder () {
+    
+    /// The offset of the first record.
+    NSUInteger recordsOffset;
+    
+    /// The format version from the file's header.
+    uint8_t version;
+}
+
+@property (nonatomic, copy, readwrite) NSString * appName;
+@property (nonatomic, copy, readwrite) NSString * appVersion;
+@property (nonatomic, copy, readwrite) NSString * dateString;
+
+/// The contents of the file.
+@property (nonatomic, strong) NSData * data;
+
+/**
+ * Returns an error for data that can't be decoded.
+ *
+ * @param offset The offset of the invalid bytes.
+ *
+ * @return The error.
+ */
++ (NSError *)decodingErrorAtOffset:(NSUInteger)offset;
+
+@end
+
+
+/**
+ * Reads an unsigned LEB128 varint.
+ *
+ * @param bytes The bytes to read from.
+ * @param length The number of bytes available.
+ * @param offset The offset to read at. Advanced past the varint.
+ * @param value The value is returned by reference.
+ *
+ * @return YES if a whole varint was read, NO if the bytes ran out.
+ */
+static BOOL RBReadVarint(const uint8_t * bytes, NSUInteger length, NSUInteger * offset, uint64_t * value) {
+    
+    uint64_t result = 0;
+    
+    for (NSUInteger shift = 0; shift < 64 && *offset < length; shift += 7) {
+        
+        uint8_t byte = bytes[(*offset)++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        
+        if (!(byte & 0x80)) {
+            *value = result;
+            return YES;
+        }
+    }
+    
+    return NO;
+}
+
+/**
+ * Reads a string prefixed by its length.
+ *
+ * @param bytes The bytes to read from.
+ * @param length The number of bytes available.
+ * @param offset The offset to read at. Advanced past the string.
+ *
+ * @return The string, or nil if the bytes ran out.
+ */
+static NSString * RBReadString(const uint8_t * bytes, NSUInteger length, NSUInteger * offset) {
+    
+    uint64_t stringLength = 0;
+    
+    if (!RBReadVarint(bytes, length, offset, &stringLength) || stringLength > length - *offset)
+        return nil;
+    
+    NSString * string = [[NSString alloc] initWithBytes:bytes + *offset
+                                                 length:(NSUInteger)stringLength
+                                               encoding:NSUTF8StringEncoding];
+    *offset += (NSUInteger)stringLength;
+    
+    return string;
+}
+
+
+@implementation RBBinaryLogDecoder
+
+@synthesize appName, appVersion, dateString, data;
+
+- (id)initWithData:(NSData *)theData error:(NSError **)error {
+    
+    if (![[self class] isBinaryLogData:theData]) {
+        
+        if (error != NULL)
+            *error = [[self class] decodingErrorAtOffset:0];
+        
+        return nil;
+    }
+    
+    if ((self = [super init])) {
+        
+        const uint8_t * bytes = [theData bytes];
+        NSUInteger length = [theData length];
+        NSUInteger offset = 5;
+        
+        [self setData:theData];
+        version = bytes[4];
+        [self setAppName:RBReadString(bytes, length, &offset)];
+        [self setAppVersion:RBReadString(bytes, length, &offset)];
+        [self setDateString:RBReadString(bytes, length, &offset)];
+        recordsOffset = offset;
+        
+        if (![self dateString]) {
+            
+            if (error != NULL)
+                *error = [[self class] decodingErrorAtOffset:offset];
+            
+            return nil;
+        }
+    }
+    
+    return self;
+}
+
+- (BOOL)enumerateRecordsUsingBlock:(void (^)(RBLogRecord *, BOOL *))block error:(NSError **)error {
+    
+    const uint8_t * bytes = [[self data] bytes];
+    NSUInteger length = [[self data] length];
+    NSUInteger offset = recordsOffset;
+    int64_t time = 0;
+    BOOL stop = NO;
+    
+    while (offset < length && !stop) {
+        
+        NSUInteger recordStart = offset;
+        uint64_t recordLength = 0;
+        
+        // A record cut off at the end of the file is treated as the end.
+        if (!RBReadVarint(bytes, length, &offset, &recordLength) || recordLength > length - offset)
+            break;
+        
+        NSUInteger recordEnd = offset + (NSUInteger)recordLength;
+        uint8_t tag = recordLength > 0 ? bytes[offset++] : 0;
+        uint64_t zigzag = 0;
+        
+        // Every record needs at least a tag and a time.
+        if (recordLength == 0 || !RBReadVarint(bytes, recordEnd, &offset, &zigzag)) {
+            
+            if (error != NULL)
+                *error = [[self class] decodingErrorAtOffset:recordStart];
+            
+            return NO;
+        }
+        
+        int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+        time = (tag & RB_BINARY_LOG_ABSOLUTE_TIME) ? delta : time + delta;
+        
+        NSString * message = [[NSString alloc] initWithBytes:bytes + offset
+                                                      length:recordEnd - offset
+                                                    encoding:NSUTF8StringEncoding];
+        
+        // Version 1 files didn't store levels.
+        RBLogLevel level = version < 2 ? RBLogLevelInfo : (tag & RB_BINARY_LOG_LEVEL_MASK) >> RB_BINARY_LOG_LEVEL_SHIFT;
+        RBLogRecord * record = [[RBLogRecord alloc] initWithMessage:message
+                                                               type:tag & RB_BINARY_LOG_TYPE_MASK
+                                                              level:level
+                                                          timestamp:time / 1000.0];
+        block(record, &stop);
+        offset = recordEnd;
+    }
+    
+    return YES;
+}
+
+- (NSData *)extendedLogData:(NSError **)error {
+    
+    NSString * header = [NSString stringWithFormat:
+                         @"#Name: %@\n#Version: %@\n#Date: %@\n#Fields: time string\n", 
+                         [self appName], 
+                         [self appVersion], 
+                         [self dateString]];
+    NSMutableData * text = [NSMutableData dataWithData:[header dataUsingEncoding:NSUTF8StringEncoding]];
+    
+    // Uses the extended log file's own line format without touching any file.
+    RBExtendedLogFile * formatter = [[RBExtendedLogFile alloc] initWithFilePath:nil];
+    
+    BOOL success = [self enumerateRecordsUsingBlock:^(RBLogRecord * record, BOOL * stop) {
+        [formatter appendRecord:record toData:text];
+    } error:error];
+    
+    return success ? text : nil;
+}
+
++ (BOOL)isBinaryLogData:(NSData *)theData {
+    
+    return [theData length] >= 5 && memcmp([theData bytes], RB_BINARY_LOG_MAGIC, 4) == 0;
+}
+
++ (NSData *)extendedLogDataWithContentsOfFile:(NSString *)path error:(NSError **)error {
+    
+    NSData * contents = [NSData dataWithContentsOfFile:path 
+                                               options:NSDataReadingMappedIfSafe 
+                                                 error:error];
+    
+    if (!contents)
+        return nil;
+    
+    RBBinaryLogDecoder * decoder = [[self alloc] initWithData:contents error:error];
+    
+    return [decoder extendedLogData:error];
+}
+
++ (NSError *)decodingErrorAtOffset:(NSUInteger)offset {
+    
+    NSString * description = [NSString stringWithFormat:@"Invalid binary log data at offset %lu.", (unsigned long)offset];
+    NSDictionary * userInfo = [NSDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey];
+    
+    return [NSError errorWithDomain:RBErrorDomain code:RBBinaryLogDecodingError userInfo:userInfo];
+}
+
+@end
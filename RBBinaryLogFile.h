@@ -0,0 +1,68 @@
+//
+// RBBinaryLogFile.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBBaseLogFile.h"
+
+/// The first bytes of every binary log file.
+#define RB_BINARY_LOG_MAGIC "RBLB"
+
+/// The version of the binary log format written by RBBinaryLogFile.
+#define RB_BINARY_LOG_VERSION 2
+
+/// The bits of a record's tag that hold its RBLogRecordType.
+#define RB_BINARY_LOG_TYPE_MASK 0x0F
+
+/// The bits of a record's tag that hold its RBLogLevel. Always 0 in version 1.
+#define RB_BINARY_LOG_LEVEL_MASK 0x70
+
+/// The shift of the level within a record's tag.
+#define RB_BINARY_LOG_LEVEL_SHIFT 4
+
+/// Set in a record's tag when its time is absolute rather than a delta.
+#define RB_BINARY_LOG_ABSOLUTE_TIME 0x80
+
+
+/**
+ * A log file that writes compact, length-prefixed binary records. Smaller and 
+ * cheaper to write than RBExtendedLogFile. Use RBBinaryLogDecoder to turn it 
+ * back into extended log text. 
+ *
+ * The file starts with RB_BINARY_LOG_MAGIC, a version byte, and the app name, 
+ * app version and date as varint-length-prefixed UTF-8 strings. Each record 
+ * is then:
+ *
+ *  - a varint with the number of bytes that follow in the record,
+ *  - a tag byte holding the RBLogRecordType, the RBLogLevel and flags,
+ *  - a zigzag varint with the time in milliseconds since the previous record, 
+ *    or since the reference date if RB_BINARY_LOG_ABSOLUTE_TIME is set,
+ *  - the message as UTF-8.
+ *
+ * The first record written after the file is opened always has an absolute 
+ * time, so the file can be appended to across launches.
+ */
+@interface RBBinaryLogFile : RBBaseLogFile
+
+@end
@@ -0,0 +1,156 @@
+//
+// RBBinaryLogFile.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <math.h>
+
+#import "RBBinaryLogFile.h"
+
+
+@interface RBBinaryLogFile () {
+    
+    /// The time of the last record written, in milliseconds since the reference date.
+    int64_t previousTime;
+    
+    /// Whether the next record needs an absolute time.
+    BOOL needsAbsoluteTime;
+}
+
+/**
+ * Writes the file header.
+ */
+- (void)writeHeaderData;
+
+@end
+
+
+/**
+ * Writes the given value as an unsigned LEB128 varint.
+ *
+ * @param value The value to write.
+ * @param buffer The buffer to write to. Must hold at least 10 bytes.
+ *
+ * @return The number of bytes written.
+ */
+static NSUInteger RBWriteVarint(uint64_t value, uint8_t * buffer) {
+    
+    NSUInteger length = 0;
+    
+    while (value >= 0x80) {
+        buffer[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    
+    buffer[length++] = (uint8_t)value;
+    
+    return length;
+}
+
+/**
+ * Appends the given string to the given buffer prefixed by its length.
+ *
+ * @param string The string to append.
+ * @param data The buffer to append to.
+ */
+static void RBAppendString(NSString * string, NSMutableData * data) {
+    
+    NSData * bytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+    uint8_t length[10];
+    
+    [data appendBytes:length length:RBWriteVarint([bytes length], length)];
+    [data appendData:bytes];
+}
+
+
+@implementation RBBinaryLogFile
+
+- (BOOL)openFile:(NSError **)error {
+    
+    if ([self isOpen])
+        return YES;
+    
+    if (![self underlyingFileExists])
+        [self writeHeaderData];
+    
+    // The previous time isn't known across launches, so restarts the deltas.
+    needsAbsoluteTime = YES;
+    
+    return [super openFile:error];
+}
+
+- (void)appendRecord:(RBLogRecord *)record toData:(NSMutableData *)data {
+    
+    NSString * message = [record message];
+    int64_t time = (int64_t)floor([record timestamp] * 1000.0);
+    int64_t delta = needsAbsoluteTime ? time : time - previousTime;
+    
+    // Zigzag encoding keeps small negative deltas small.
+    uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+    
+    uint8_t header[11];
+    NSUInteger headerLength = 0;
+    header[headerLength++] = (uint8_t)(([record type] & RB_BINARY_LOG_TYPE_MASK) | 
+                                       (([record level] << RB_BINARY_LOG_LEVEL_SHIFT) & RB_BINARY_LOG_LEVEL_MASK) | 
+                                       (needsAbsoluteTime ? RB_BINARY_LOG_ABSOLUTE_TIME : 0));
+    headerLength += RBWriteVarint(zigzag, header + headerLength);
+    
+    NSUInteger messageLength = [message lengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    uint8_t length[10];
+    
+    [data appendBytes:length length:RBWriteVarint(headerLength + messageLength, length)];
+    [data appendBytes:header length:headerLength];
+    
+    // Encodes the message straight into the buffer.
+    NSUInteger offset = [data length];
+    [data increaseLengthBy:messageLength];
+    [message getBytes:(uint8_t *)[data mutableBytes] + offset
+            maxLength:messageLength
+           usedLength:NULL
+             encoding:NSUTF8StringEncoding
+              options:0
+                range:NSMakeRange(0, [message length])
+       remainingRange:NULL];
+    
+    previousTime = time;
+    needsAbsoluteTime = NO;
+}
+
+- (void)writeHeaderData {
+    
+    NSDictionary * bundleInfo = [[NSBundle mainBundle] infoDictionary];
+    NSString * dateStr = [NSDateFormatter localizedStringFromDate:[NSDate date]
+                                                        dateStyle:NSDateFormatterMediumStyle
+                                                        timeStyle:NSDateFormatterNoStyle];
+    uint8_t version = RB_BINARY_LOG_VERSION;
+    NSMutableData * header = [NSMutableData data];
+    
+    [header appendBytes:RB_BINARY_LOG_MAGIC length:4];
+    [header appendBytes:&version length:1];
+    RBAppendString([bundleInfo objectForKey:@"CFBundleName"], header);
+    RBAppendString([bundleInfo objectForKey:@"CFBundleVersion"], header);
+    RBAppendString(dateStr, header);
+    
+    [self appendData:header error:NULL];
+}
+
+@end
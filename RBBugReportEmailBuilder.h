@@ -46,6 +46,12 @@
  */
 @property (nonatomic, copy) NSString * deviceHeader;
 
+/**
+ * Part of the bug report email message. This string is shown just before the 
+ * loggerMsg.
+ */
+@property (nonatomic, copy) NSString * loggerHeader;
+
 /**
  * Part of the bug report email message. This string is to give instructions how 
  * the user is to provide feedback.
@@ -64,6 +70,26 @@
  */
 @property (nonatomic, copy) NSString * deviceMsg;
 
+/**
+ * Part of the bug report email message. This string holds the logger's 
+ * counters, such as dropped messages and write latency, taken when the report 
+ * is created.
+ */
+@property (nonatomic, copy) NSString * loggerMsg;
+
+/**
+ * The number of recent log records to attach to the bug report. Defaults to 
+ * 1000. Set to 0 for no log attachment.
+ */
+@property (nonatomic, assign) NSUInteger recentLogRecordCount;
+
+/**
+ * The number of minutes of every logger's records to attach, interleaved by 
+ * timestamp, when loggers other than the default logger exist. Defaults to 
+ * 30. Set to 0 for no merged log attachment.
+ */
+@property (nonatomic, assign) NSUInteger mergedLogMinutes;
+
 
 /**
  * Creates a bug report email from the given error.
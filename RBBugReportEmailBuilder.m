@@ -24,6 +24,16 @@
 
 #import "RBBugReportEmailBuilder.h"
 #import "NSString+RBExtras.h"
+#import "RBLogTailAttachment.h"
+#import "RBMergedLogAttachment.h"
+#import "RBLogger.h"
+
+
+/// The number of recent log records attached by default.
+static const NSUInteger kDefaultRecentLogRecordCount = 1000;
+
+/// The minutes of merged logs attached by default.
+static const NSUInteger kDefaultMergedLogMinutes = 30;
 
 
 @interface RBBugReportEmailBuilder ()
@@ -43,7 +53,7 @@
 
 @implementation RBBugReportEmailBuilder
 
-@synthesize commentHeader, errorHeader, deviceHeader, commentMsg, errMsg, deviceMsg;
+@synthesize commentHeader, errorHeader, deviceHeader, loggerHeader, commentMsg, errMsg, deviceMsg, loggerMsg, recentLogRecordCount, mergedLogMinutes;
 
 - (id)init {
     return [self initWithErrorMessage:@""];
@@ -79,8 +89,12 @@
         [self setCommentHeader:@"[[Comments]]"];
         [self setErrorHeader:@"[[Error]]"];
         [self setDeviceHeader:@"[[Device Info]]"];
+        [self setLoggerHeader:@"[[Logger]]"];
         [self setCommentMsg:@"\n\n\n\n\n--------------------\nAdd any additional comments above, such as how to reproduce the bug.\n"];
         [self setDeviceMsg:[[self class] deviceInfoString]];
+        [self setLoggerMsg:[[RBLogger defaultLogger] statisticsReport]];
+        [self setRecentLogRecordCount:kDefaultRecentLogRecordCount];
+        [self setMergedLogMinutes:kDefaultMergedLogMinutes];
     }
 }
 
@@ -90,8 +104,24 @@
     NSString * commentSection = [NSString stringWithFormat:@"%@\n%@\n", [self commentHeader], [self commentMsg]];
     NSString * errorSection = [NSString stringWithFormat:@"%@\n%@\n", [self errorHeader], [self errMsg]];
     NSString * deviceInfoSection = [NSString stringWithFormat:@"%@\n%@\n", [self deviceHeader], [self deviceMsg]];
+    NSString * loggerSection = [NSString stringWithFormat:@"%@\n%@\n", [self loggerHeader], [self loggerMsg]];
+    
+    return [NSString stringWithFormat:@"%@\n%@\n%@\n%@\n", commentSection, errorSection, deviceInfoSection, loggerSection];
+}
+
+- (NSArray *)attachments {
+    
+    NSMutableArray * attachments = [NSMutableArray array];
+    
+    // Attaches the end of the log instead of whole log files.
+    if ([self recentLogRecordCount] > 0)
+        [attachments addObject:[RBLogTailAttachment attachmentWithLastRecords:[self recentLogRecordCount]]];
+    
+    // With more than one logger, the subsystems' logs are only useful side by side.
+    if ([self mergedLogMinutes] > 0 && [[RBLogger allLoggers] count] > 1)
+        [attachments addObject:[RBMergedLogAttachment attachmentWithLastMinutes:[self mergedLogMinutes]]];
     
-    return [NSString stringWithFormat:@"%@\n%@\n%@\n", commentSection, errorSection, deviceInfoSection];
+    return attachments;
 }
 
 + (NSString *)deviceInfoString {
@@ -0,0 +1,84 @@
+//
+// RBConsoleLogSink.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogSink.h"
+
+/**
+ * Whether the default logger mirrors records to the console with an 
+ * RBConsoleLogSink. Defaults to 1 when DEBUG is defined and 0 otherwise. 
+ * Define it in the project settings to change it per build configuration.
+ */
+#ifndef RB_CONSOLE_LOGGING
+#if DEBUG
+#define RB_CONSOLE_LOGGING 1
+#else
+#define RB_CONSOLE_LOGGING 0
+#endif
+#endif
+
+
+@class RBTimestampEncoder;
+
+
+/**
+ * A sink that writes records to stderr, one line per record with the UTC 
+ * time of day and level. Each batch is formatted and written with a single 
+ * write() on the sink's channel queue, so neither callers nor the loggerQueue 
+ * wait on the console.
+ */
+@interface RBConsoleLogSink : NSObject <RBLogSink>
+
+/**
+ * Initializes a sink writing to the given file descriptor.
+ *
+ * @param fileDescriptor The file descriptor to write to. Not closed by the 
+ * sink.
+ *
+ * @return self
+ */
+- (id)initWithFileDescriptor:(int)fileDescriptor;
+
+/**
+ * Formats records as console lines: "HH:mm:ss.SSS LEVEL message".
+ *
+ * @param records The RBLogRecords.
+ * @param encoder The encoder for the times of day.
+ *
+ * @return The lines as UTF-8.
+ */
++ (NSData *)linesForRecords:(NSArray *)records timeEncoder:(RBTimestampEncoder *)encoder;
+
+/**
+ * Writes all of the given data to a file descriptor, retrying short writes.
+ *
+ * @param data The data to write.
+ * @param fileDescriptor The file descriptor.
+ *
+ * @return YES if everything was written, NO if the write failed.
+ */
++ (BOOL)writeData:(NSData *)data toFileDescriptor:(int)fileDescriptor;
+
+@end
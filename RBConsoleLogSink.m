@@ -0,0 +1,117 @@
+//
+// RBConsoleLogSink.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <errno.h>
+#import <unistd.h>
+
+#import "RBConsoleLogSink.h"
+#import "RBLogRecord.h"
+#import "RBTimestampEncoder.h"
+
+
+@interface RBConsoleLogSink () {
+    
+    /// The file descriptor written to.
+    int fileDescriptor;
+}
+
+/**
+ * Formats the times of day. Only used on the channel queue.
+ */
+@property (nonatomic, strong) RBTimestampEncoder * timeEncoder;
+
+@end
+
+
+@implementation RBConsoleLogSink
+
+@synthesize timeEncoder;
+
+- (id)init {
+    return [self initWithFileDescriptor:STDERR_FILENO];
+}
+
+- (id)initWithFileDescriptor:(int)theFileDescriptor {
+    
+    if ((self = [super init])) {
+        fileDescriptor = theFileDescriptor;
+        [self setTimeEncoder:[RBTimestampEncoder new]];
+        [[self timeEncoder] setPrecision:RBTimestampPrecisionMilliseconds];
+    }
+    
+    return self;
+}
+
+- (void)writeRecords:(NSArray *)records {
+    
+    // Nothing useful can be done if the console is gone.
+    [[self class] writeData:[[self class] linesForRecords:records timeEncoder:[self timeEncoder]] 
+           toFileDescriptor:fileDescriptor];
+}
+
++ (NSData *)linesForRecords:(NSArray *)records timeEncoder:(RBTimestampEncoder *)encoder {
+    
+    NSMutableData * lines = [NSMutableData dataWithCapacity:[records count] * 64];
+    char time[RB_TIMESTAMP_MAX_LENGTH];
+    
+    for (RBLogRecord * record in records) {
+        
+        NSUInteger timeLength = [encoder encodeTime:[record timestamp] intoBuffer:time];
+        NSString * level = RBNameOfLogLevel([record level]);
+        NSData * message = [[record message] dataUsingEncoding:NSUTF8StringEncoding];
+        
+        [lines appendBytes:time length:timeLength];
+        [lines appendBytes:" " length:1];
+        [lines appendData:[level dataUsingEncoding:NSUTF8StringEncoding]];
+        [lines appendBytes:" " length:1];
+        [lines appendData:message];
+        [lines appendBytes:"\n" length:1];
+    }
+    
+    return lines;
+}
+
++ (BOOL)writeData:(NSData *)data toFileDescriptor:(int)theFileDescriptor {
+    
+    const char * bytes = [data bytes];
+    NSUInteger remaining = [data length];
+    
+    while (remaining > 0) {
+        
+        ssize_t written = write(theFileDescriptor, bytes, remaining);
+        
+        if (written < 0 && errno == EINTR)
+            continue;
+        
+        if (written <= 0)
+            return NO;
+        
+        bytes += written;
+        remaining -= (NSUInteger)written;
+    }
+    
+    return YES;
+}
+
+@end
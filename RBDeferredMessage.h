@@ -0,0 +1,89 @@
+//
+// RBDeferredMessage.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * A log message whose string is built later. Creating one copies the format 
+ * and the raw argument values (scalars, copies of C strings, retained 
+ * objects), which is much cheaper than formatting. -message formats them, 
+ * which the logger does on its loggerQueue, off the calling thread. Errors and 
+ * exceptions can be deferred the same way.
+ *
+ * Objects are described when the message is rendered, not when it is logged, 
+ * so mutable objects should be copied before they are logged.
+ */
+@interface RBDeferredMessage : NSObject
+
+/**
+ * Captures a format and its arguments. Formats with positional arguments 
+ * (%1$@), a '*' width or precision, or conversions that can't be copied 
+ * safely (%n, %ls) aren't supported. For those this returns nil and the 
+ * caller should format the message right away instead. The arguments are read 
+ * from a copy, so they can still be used for that.
+ *
+ * @param format The format, as for -[NSString initWithFormat:arguments:].
+ * @param arguments The arguments for the format.
+ *
+ * @return self, or nil if the format isn't supported.
+ */
+- (id)initWithFormat:(NSString *)format arguments:(va_list)arguments;
+
+/**
+ * Captures an error. The message is made with +[NSString stringWithError:].
+ *
+ * @param error The error.
+ *
+ * @return self
+ */
+- (id)initWithError:(NSError *)error;
+
+/**
+ * Captures an exception. Only the exception is retained; its return 
+ * addresses are symbolicated by RBStackRenderer when the message is rendered.
+ *
+ * @param exception The exception.
+ *
+ * @return self
+ */
+- (id)initWithException:(NSException *)exception;
+
+/**
+ * Renders the message. Not threadsafe, but a deferred message is only 
+ * rendered once, by whoever dequeues it.
+ *
+ * @return The message.
+ */
+- (NSString *)message;
+
+/**
+ * Returns a cheap stand-in for the message without rendering it: the format, 
+ * the error's domain or the exception's name. Threadsafe.
+ *
+ * @return The stand-in.
+ */
+- (NSString *)unrenderedMessage;
+
+@end
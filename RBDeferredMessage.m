@@ -0,0 +1,558 @@
+//
+// RBDeferredMessage.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <limits.h>
+#import <stdarg.h>
+#import <stdlib.h>
+#import <string.h>
+
+#import "RBDeferredMessage.h"
+#import "NSString+RBExtras.h"
+#import "RBStackRenderer.h"
+
+/// The number of arguments stored in the message itself before the rest are allocated.
+#define RB_DEFERRED_INLINE_ARGUMENTS 6
+
+
+/**
+ * How an argument was read from the va_list, and so how it is passed back 
+ * when rendering.
+ */
+typedef enum {
+    RBDeferredArgumentInt,
+    RBDeferredArgumentLong,
+    RBDeferredArgumentLongLong,
+    RBDeferredArgumentDouble,
+    RBDeferredArgumentLongDouble,
+    RBDeferredArgumentPointer,
+    RBDeferredArgumentCString,
+    RBDeferredArgumentCharacters,
+    RBDeferredArgumentObject,
+} RBDeferredArgumentKind;
+
+/**
+ * A captured argument and where its conversion specification is in the 
+ * UTF-8 format.
+ */
+typedef struct {
+    
+    /// How the argument was read.
+    RBDeferredArgumentKind kind;
+    
+    /// The byte offset of the '%' in the format.
+    uint32_t specStart;
+    
+    /// The length of the conversion specification, including the '%'.
+    uint32_t specLength;
+    
+    /// The value. C strings and characters are owned copies, objects are retained.
+    union {
+        int intValue;
+        long longValue;
+        long long longLongValue;
+        double doubleValue;
+        long double longDoubleValue;
+        const void * pointerValue;
+        char * cString;
+        unichar * characters;
+        CFTypeRef object;
+    } value;
+    
+} RBDeferredArgument;
+
+/**
+ * What a deferred message was created from.
+ */
+typedef enum {
+    RBDeferredMessageFormat,
+    RBDeferredMessageError,
+    RBDeferredMessageException,
+} RBDeferredMessageKind;
+
+
+/**
+ * Parses the conversion specification starting at the '%' at spec.
+ *
+ * @param spec The '%'.
+ * @param end The end of the format.
+ * @param kind How to read the argument is returned by reference.
+ * @param precision The precision is returned by reference, or -1 if there is 
+ * none.
+ *
+ * @return The length of the specification, or 0 if it isn't supported.
+ */
+static NSUInteger RBParseConversion(const char * spec, const char * end, RBDeferredArgumentKind * kind, NSInteger * precision) {
+    
+    const char * p = spec + 1;
+    
+    while (p < end && strchr("-+ #0'", *p))
+        p++;
+    
+    while (p < end && *p >= '0' && *p <= '9')
+        p++;
+    
+    *precision = -1;
+    
+    // A bare '.' is a precision of 0. Precisions past INT_MAX can't be printed anyway.
+    if (p < end && *p == '.') {
+        
+        p++;
+        *precision = 0;
+        
+        while (p < end && *p >= '0' && *p <= '9') {
+            
+            if (*precision <= INT_MAX)
+                *precision = *precision * 10 + (*p - '0');
+            
+            p++;
+        }
+    }
+    
+    // '*' and positional arguments would need the arguments read out of order.
+    if (p >= end || *p == '*' || *p == '$')
+        return 0;
+    
+    // Reads the length modifier: none, hh, h, l, ll, q, L, z, t or j.
+    char length[3] = { 0, 0, 0 };
+    
+    if (strchr("hlqLztj", *p)) {
+        
+        length[0] = *p++;
+        
+        if (p < end && (length[0] == 'h' || length[0] == 'l') && *p == length[0])
+            length[1] = *p++;
+    }
+    
+    if (p >= end)
+        return 0;
+    
+    BOOL isLong = length[0] == 'l' && length[1] == 0;
+    BOOL isLongLong = (length[0] == 'l' && length[1] == 'l') || length[0] == 'q';
+    BOOL isSizeLong = length[0] == 'z' || length[0] == 't' || length[0] == 'j';
+    
+    switch (*p) {
+            
+        case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+            
+            if (length[0] == 'L')
+                return 0;
+            
+            *kind = isLongLong ? RBDeferredArgumentLongLong : 
+                    (isLong || isSizeLong) ? RBDeferredArgumentLong : RBDeferredArgumentInt;
+            break;
+            
+        case 'D': case 'O': case 'U':
+            *kind = isLongLong ? RBDeferredArgumentLongLong : RBDeferredArgumentLong;
+            break;
+            
+        case 'c': case 'C':
+            *kind = RBDeferredArgumentInt;
+            break;
+            
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            *kind = length[0] == 'L' ? RBDeferredArgumentLongDouble : RBDeferredArgumentDouble;
+            break;
+            
+        case 'p':
+            *kind = RBDeferredArgumentPointer;
+            break;
+            
+        case 's':
+            
+            // Wide strings aren't copied.
+            if (length[0] != 0)
+                return 0;
+            
+            *kind = RBDeferredArgumentCString;
+            break;
+            
+        case 'S':
+            *kind = RBDeferredArgumentCharacters;
+            break;
+            
+        case '@':
+            *kind = RBDeferredArgumentObject;
+            break;
+            
+        default:
+            return 0;
+    }
+    
+    return p + 1 - spec;
+}
+
+
+@interface RBDeferredMessage () {
+    
+    /// What the message was created from.
+    RBDeferredMessageKind kind;
+    
+    /// The captured arguments. Points at inlineArguments unless there are many.
+    RBDeferredArgument * arguments;
+    
+    /// The number of captured arguments.
+    NSUInteger argumentCount;
+    
+    /// The number of arguments that fit in arguments.
+    NSUInteger argumentCapacity;
+    
+    /// Storage for the first few arguments.
+    RBDeferredArgument inlineArguments[RB_DEFERRED_INLINE_ARGUMENTS];
+}
+
+/**
+ * The format, or the error or exception.
+ */
+@property (nonatomic, strong) id source;
+
+/**
+ * Reads the next argument from the va_list and stores it.
+ *
+ * @param argumentKind How to read the argument.
+ * @param argumentList The arguments.
+ * @param start The offset of the conversion specification.
+ * @param length The length of the conversion specification.
+ * @param precision The precision of the conversion specification, or -1 if 
+ * there is none.
+ */
+- (void)captureArgumentOfKind:(RBDeferredArgumentKind)argumentKind 
+                         from:(va_list *)argumentList 
+                    specStart:(NSUInteger)start 
+                       length:(NSUInteger)length 
+                    precision:(NSInteger)precision;
+
+/**
+ * Formats a single captured argument with its conversion specification.
+ *
+ * @param argument The argument.
+ * @param format The UTF-8 format.
+ *
+ * @return The formatted argument.
+ */
+- (NSString *)renderArgument:(const RBDeferredArgument *)argument inFormat:(const char *)format;
+
+/**
+ * Renders a message made from a format.
+ *
+ * @return The message.
+ */
+- (NSString *)renderFormat;
+
+@end
+
+
+@implementation RBDeferredMessage
+
+@synthesize source;
+
+- (id)initWithFormat:(NSString *)format arguments:(va_list)argumentList {
+    
+    if ((self = [super init])) {
+        
+        kind = RBDeferredMessageFormat;
+        arguments = inlineArguments;
+        argumentCapacity = RB_DEFERRED_INLINE_ARGUMENTS;
+        [self setSource:format];
+        
+        // Constant format strings hand back their bytes without converting.
+        const char * bytes = [format UTF8String];
+        
+        if (!bytes)
+            return nil;
+        
+        const char * end = bytes + strlen(bytes);
+        const char * percent = bytes;
+        va_list copy;
+        
+        // Reads a copy so the caller can still use the arguments if this fails.
+        va_copy(copy, argumentList);
+        
+        while ((percent = memchr(percent, '%', end - percent))) {
+            
+            if (percent + 1 < end && percent[1] == '%') {
+                percent += 2;
+                continue;
+            }
+            
+            RBDeferredArgumentKind argumentKind;
+            NSInteger precision = -1;
+            NSUInteger length = RBParseConversion(percent, end, &argumentKind, &precision);
+            
+            if (length == 0) {
+                va_end(copy);
+                return nil;
+            }
+            
+            [self captureArgumentOfKind:argumentKind from:&copy specStart:percent - bytes length:length precision:precision];
+            percent += length;
+        }
+        
+        va_end(copy);
+    }
+    
+    return self;
+}
+
+- (id)initWithError:(NSError *)error {
+    
+    if ((self = [super init])) {
+        kind = RBDeferredMessageError;
+        [self setSource:error];
+    }
+    
+    return self;
+}
+
+- (id)initWithException:(NSException *)exception {
+    
+    if ((self = [super init])) {
+        kind = RBDeferredMessageException;
+        [self setSource:exception];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    for (NSUInteger i = 0; i < argumentCount; i++) {
+        
+        RBDeferredArgument * argument = &arguments[i];
+        
+        if (argument->kind == RBDeferredArgumentCString)
+            free(argument->value.cString);
+        else if (argument->kind == RBDeferredArgumentCharacters)
+            free(argument->value.characters);
+        else if (argument->kind == RBDeferredArgumentObject && argument->value.object)
+            CFRelease(argument->value.object);
+    }
+    
+    if (arguments != inlineArguments)
+        free(arguments);
+}
+
+- (void)captureArgumentOfKind:(RBDeferredArgumentKind)argumentKind 
+                         from:(va_list *)argumentList 
+                    specStart:(NSUInteger)start 
+                       length:(NSUInteger)length 
+                    precision:(NSInteger)precision {
+    
+    // Moves to the heap once the inline arguments are used up.
+    if (argumentCount == argumentCapacity) {
+        
+        RBDeferredArgument * grown = malloc(argumentCapacity * 2 * sizeof(RBDeferredArgument));
+        memcpy(grown, arguments, argumentCount * sizeof(RBDeferredArgument));
+        
+        if (arguments != inlineArguments)
+            free(arguments);
+        
+        arguments = grown;
+        argumentCapacity *= 2;
+    }
+    
+    RBDeferredArgument * argument = &arguments[argumentCount++];
+    argument->kind = argumentKind;
+    argument->specStart = (uint32_t)start;
+    argument->specLength = (uint32_t)length;
+    
+    switch (argumentKind) {
+            
+        case RBDeferredArgumentInt:
+            argument->value.intValue = va_arg(*argumentList, int);
+            break;
+            
+        case RBDeferredArgumentLong:
+            argument->value.longValue = va_arg(*argumentList, long);
+            break;
+            
+        case RBDeferredArgumentLongLong:
+            argument->value.longLongValue = va_arg(*argumentList, long long);
+            break;
+            
+        case RBDeferredArgumentDouble:
+            argument->value.doubleValue = va_arg(*argumentList, double);
+            break;
+            
+        case RBDeferredArgumentLongDouble:
+            argument->value.longDoubleValue = va_arg(*argumentList, long double);
+            break;
+            
+        case RBDeferredArgumentPointer:
+            argument->value.pointerValue = va_arg(*argumentList, const void *);
+            break;
+            
+        case RBDeferredArgumentCString: {
+            
+            // The caller's buffer may be gone by the time the message is rendered. 
+            // With a precision it needn't be terminated, so no more is read than printed.
+            const char * string = va_arg(*argumentList, const char *);
+            
+            if (!string)
+                argument->value.cString = NULL;
+            else if (precision >= 0)
+                argument->value.cString = strndup(string, (size_t)precision);
+            else
+                argument->value.cString = strdup(string);
+            
+            break;
+        }
+            
+        case RBDeferredArgumentCharacters: {
+            
+            const unichar * characters = va_arg(*argumentList, const unichar *);
+            unichar * copy = NULL;
+            
+            if (characters) {
+                
+                NSUInteger count = 0;
+                
+                while (characters[count])
+                    count++;
+                
+                copy = malloc((count + 1) * sizeof(unichar));
+                memcpy(copy, characters, (count + 1) * sizeof(unichar));
+            }
+            
+            argument->value.characters = copy;
+            break;
+        }
+            
+        case RBDeferredArgumentObject: {
+            
+            id object = va_arg(*argumentList, id);
+            argument->value.object = object ? CFBridgingRetain(object) : NULL;
+            break;
+        }
+    }
+}
+
+- (NSString *)message {
+    
+    switch (kind) {
+            
+        case RBDeferredMessageError:
+            return [NSString stringWithError:[self source]];
+            
+        case RBDeferredMessageException:
+            return [[RBStackRenderer sharedRenderer] descriptionOfException:[self source]];
+            
+        case RBDeferredMessageFormat:
+            break;
+    }
+    
+    return [self renderFormat];
+}
+
+- (NSString *)unrenderedMessage {
+    
+    switch (kind) {
+            
+        case RBDeferredMessageError:
+            return [(NSError *)[self source] domain];
+            
+        case RBDeferredMessageException:
+            return [(NSException *)[self source] name];
+            
+        case RBDeferredMessageFormat:
+            break;
+    }
+    
+    return [self source];
+}
+
+- (NSString *)renderFormat {
+    
+    const char * format = [[self source] UTF8String];
+    NSUInteger formatLength = strlen(format);
+    NSMutableString * result = [NSMutableString stringWithCapacity:formatLength];
+    NSUInteger position = 0;
+    
+    // Walks the literal text between the specifications, turning "%%" into "%".
+    for (NSUInteger i = 0; i <= argumentCount; i++) {
+        
+        NSUInteger literalEnd = i < argumentCount ? arguments[i].specStart : formatLength;
+        
+        while (position < literalEnd) {
+            
+            const char * percent = memchr(format + position, '%', literalEnd - position);
+            NSUInteger stop = percent ? (NSUInteger)(percent - format) + 1 : literalEnd;
+            NSString * literal = [[NSString alloc] initWithBytes:format + position 
+                                                          length:stop - position 
+                                                        encoding:NSUTF8StringEncoding];
+            
+            if (literal)
+                [result appendString:literal];
+            
+            position = percent ? stop + 1 : literalEnd;
+        }
+        
+        if (i < argumentCount) {
+            [result appendString:[self renderArgument:&arguments[i] inFormat:format]];
+            position = arguments[i].specStart + arguments[i].specLength;
+        }
+    }
+    
+    return result;
+}
+
+- (NSString *)renderArgument:(const RBDeferredArgument *)argument inFormat:(const char *)format {
+    
+    NSString * spec = [[NSString alloc] initWithBytes:format + argument->specStart 
+                                               length:argument->specLength 
+                                             encoding:NSUTF8StringEncoding];
+    
+    switch (argument->kind) {
+            
+        case RBDeferredArgumentInt:
+            return [NSString stringWithFormat:spec, argument->value.intValue];
+            
+        case RBDeferredArgumentLong:
+            return [NSString stringWithFormat:spec, argument->value.longValue];
+            
+        case RBDeferredArgumentLongLong:
+            return [NSString stringWithFormat:spec, argument->value.longLongValue];
+            
+        case RBDeferredArgumentDouble:
+            return [NSString stringWithFormat:spec, argument->value.doubleValue];
+            
+        case RBDeferredArgumentLongDouble:
+            return [NSString stringWithFormat:spec, argument->value.longDoubleValue];
+            
+        case RBDeferredArgumentPointer:
+            return [NSString stringWithFormat:spec, argument->value.pointerValue];
+            
+        case RBDeferredArgumentCString:
+            return [NSString stringWithFormat:spec, argument->value.cString];
+            
+        case RBDeferredArgumentCharacters:
+            return [NSString stringWithFormat:spec, argument->value.characters];
+            
+        case RBDeferredArgumentObject:
+            return [NSString stringWithFormat:spec, (__bridge id)argument->value.object];
+    }
+    
+    return @"";
+}
+
+@end
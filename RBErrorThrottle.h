@@ -0,0 +1,102 @@
+//
+// RBErrorThrottle.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RBLogger;
+
+
+/**
+ * Keeps errors and exceptions that repeat in a loop from flooding the log. 
+ * Each one is fingerprinted: errors by domain and code, exceptions by name 
+ * and the top frames of their call stack. Each fingerprint gets its own token 
+ * bucket. Within its limit a repeat is logged as usual; past it, only a 
+ * counter is bumped, and every summaryInterval a single line such as 
+ * "repeated 4,312× in 10 s" is logged in place of the dropped repeats.
+ *
+ * The fingerprints live in a fixed-size lock-free hash table. Checking a 
+ * repeat takes a few atomic operations, with no allocation, locking or 
+ * formatting. Once the table is full, new fingerprints aren't limited.
+ */
+@interface RBErrorThrottle : NSObject
+
+/**
+ * The number of repeats of one fingerprint allowed per second once its burst 
+ * is used up. Defaults to 1.
+ */
+@property (nonatomic, assign) double ratePerSecond;
+
+/**
+ * The number of repeats of one fingerprint allowed back to back. Defaults 
+ * to 5.
+ */
+@property (nonatomic, assign) NSUInteger burst;
+
+/**
+ * The seconds between summaries of dropped repeats. Defaults to 10. Only read 
+ * when the first repeat is dropped.
+ */
+@property (nonatomic, assign) NSTimeInterval summaryInterval;
+
+/**
+ * The logger summaries are logged to. Defaults to nil, which logs them to the 
+ * default logger.
+ */
+@property (nonatomic, strong) RBLogger * summaryLogger;
+
+/**
+ * Returns whether the given error should be logged, counting it as dropped 
+ * if not. Threadsafe.
+ *
+ * @param error The error.
+ *
+ * @return YES if the error is within its fingerprint's limit.
+ */
+- (BOOL)shouldLogError:(NSError *)error;
+
+/**
+ * Returns whether the given exception should be logged, counting it as 
+ * dropped if not. Threadsafe.
+ *
+ * @param exception The exception.
+ *
+ * @return YES if the exception is within its fingerprint's limit.
+ */
+- (BOOL)shouldLogException:(NSException *)exception;
+
+/**
+ * Logs a summary line for each fingerprint with dropped repeats and resets 
+ * the counts. Called every summaryInterval once something has been dropped. 
+ * Threadsafe.
+ */
+- (void)logSummaries;
+
+/**
+ * Returns the throttle used by RBReporter.
+ *
+ * @return The shared throttle.
+ */
++ (RBErrorThrottle *)sharedThrottle;
+
+@end
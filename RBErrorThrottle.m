@@ -0,0 +1,341 @@
+//
+// RBErrorThrottle.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <stdatomic.h>
+#import <stdlib.h>
+
+#import "RBErrorThrottle.h"
+#import "RBLogger.h"
+
+/// The number of fingerprints the table holds. Must be a power of two.
+#define RB_THROTTLE_TABLE_SIZE 1024
+
+/// The number of slots looked at before giving up on a fingerprint.
+#define RB_THROTTLE_MAX_PROBES 16
+
+/// The number of call stack frames in an exception's fingerprint.
+#define RB_THROTTLE_STACK_FRAMES 6
+
+/// The default repeats allowed per second.
+static const double kDefaultRatePerSecond = 1.0;
+
+/// The default repeats allowed back to back.
+static const NSUInteger kDefaultBurst = 5;
+
+/// The default seconds between summaries.
+static const NSTimeInterval kDefaultSummaryInterval = 10.0;
+
+/// The microseconds in a second.
+static const double kMicrosecondsPerSecond = 1000000.0;
+
+/// Marks a slot claimed by a thread that hasn't stored its example yet.
+static const uint64_t kClaimingFingerprint = UINT64_MAX;
+
+
+/**
+ * A fingerprint's entry in the table.
+ */
+typedef struct {
+    
+    /// The fingerprint, or 0 if the slot is free. Never changes once set, 
+    /// apart from kClaimingFingerprint while the example is being stored.
+    _Atomic(uint64_t) fingerprint;
+    
+    /// When the bucket will be full again, in microseconds (the GCRA form of 
+    /// a token bucket, which fits in one word).
+    _Atomic(int64_t) theoreticalArrival;
+    
+    /// The repeats dropped since the last summary.
+    _Atomic(uint64_t) dropped;
+    
+    /// A retained copy of the first error or exception seen, for summaries.
+    _Atomic(uintptr_t) example;
+    
+} RBThrottleSlot;
+
+
+/**
+ * Mixes the bits of a value (the splitmix64 finalizer).
+ */
+static inline uint64_t RBMixBits(uint64_t value) {
+    
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    
+    return value;
+}
+
+
+@interface RBErrorThrottle () {
+    
+    /// The fingerprints.
+    RBThrottleSlot slots[RB_THROTTLE_TABLE_SIZE];
+    
+    /// Whether the summary timer has been started.
+    _Atomic(bool) summariesScheduled;
+}
+
+/**
+ * The timer that logs summaries. Dispatch objects are only retained by ARC 
+ * when they are Objective-C objects; otherwise the timer's creation 
+ * reference is kept and released in -dealloc.
+ */
+#if OS_OBJECT_USE_OBJC
+@property (nonatomic, strong) dispatch_source_t summaryTimer;
+#else
+@property (nonatomic, assign) dispatch_source_t summaryTimer;
+#endif
+
+/**
+ * Checks a fingerprint against its bucket.
+ *
+ * @param fingerprint The fingerprint.
+ * @param example The error or exception, kept the first time the fingerprint 
+ * is seen.
+ *
+ * @return YES if the repeat should be logged.
+ */
+- (BOOL)shouldLogFingerprint:(uint64_t)fingerprint example:(id)example;
+
+/**
+ * Starts the summary timer, once.
+ */
+- (void)scheduleSummaries;
+
+/**
+ * Returns a short description of an error or exception for a summary line.
+ *
+ * @param example The error or exception.
+ *
+ * @return The description.
+ */
++ (NSString *)descriptionOfExample:(id)example;
+
+@end
+
+
+@implementation RBErrorThrottle
+
+@synthesize ratePerSecond, burst, summaryInterval, summaryLogger, summaryTimer;
+
+- (id)init {
+    
+    if ((self = [super init])) {
+        
+        [self setRatePerSecond:kDefaultRatePerSecond];
+        [self setBurst:kDefaultBurst];
+        [self setSummaryInterval:kDefaultSummaryInterval];
+        atomic_init(&summariesScheduled, false);
+        
+        for (NSUInteger i = 0; i < RB_THROTTLE_TABLE_SIZE; i++) {
+            atomic_init(&slots[i].fingerprint, 0);
+            atomic_init(&slots[i].theoreticalArrival, 0);
+            atomic_init(&slots[i].dropped, 0);
+            atomic_init(&slots[i].example, 0);
+        }
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    for (NSUInteger i = 0; i < RB_THROTTLE_TABLE_SIZE; i++) {
+        
+        uintptr_t example = atomic_load_explicit(&slots[i].example, memory_order_relaxed);
+        
+        if (example)
+            CFRelease((CFTypeRef)example);
+    }
+    
+    if (summaryTimer) {
+        dispatch_source_cancel(summaryTimer);
+#if !OS_OBJECT_USE_OBJC
+        dispatch_release(summaryTimer);
+#endif
+    }
+}
+
+- (BOOL)shouldLogError:(NSError *)error {
+    
+    uint64_t fingerprint = RBMixBits([[error domain] hash] ^ RBMixBits((uint64_t)[error code]));
+    
+    return [self shouldLogFingerprint:fingerprint example:error];
+}
+
+- (BOOL)shouldLogException:(NSException *)exception {
+    
+    // The call stack tells apart the same exception thrown from different places.
+    NSArray * stack = [exception callStackReturnAddresses];
+    NSUInteger frameCount = MIN([stack count], (NSUInteger)RB_THROTTLE_STACK_FRAMES);
+    uint64_t fingerprint = RBMixBits([[exception name] hash]);
+    
+    for (NSUInteger i = 0; i < frameCount; i++)
+        fingerprint = RBMixBits(fingerprint ^ [[stack objectAtIndex:i] unsignedLongLongValue]);
+    
+    return [self shouldLogFingerprint:fingerprint example:exception];
+}
+
+- (BOOL)shouldLogFingerprint:(uint64_t)fingerprint example:(id)example {
+    
+    // 0 marks a free slot, and kClaimingFingerprint a slot being claimed.
+    if (fingerprint == 0 || fingerprint == kClaimingFingerprint)
+        fingerprint = 1;
+    
+    RBThrottleSlot * slot = NULL;
+    
+    for (NSUInteger probe = 0; probe < RB_THROTTLE_MAX_PROBES && !slot; probe++) {
+        
+        RBThrottleSlot * candidate = &slots[(fingerprint + probe) & (RB_THROTTLE_TABLE_SIZE - 1)];
+        uint64_t current = atomic_load_explicit(&candidate->fingerprint, memory_order_acquire);
+        
+        if (current == 0) {
+            
+            // Claims the free slot unless another thread just took it. The example 
+            // is stored before the fingerprint is published, so any thread that 
+            // finds the fingerprint, and any summary of it, finds the example too.
+            if (atomic_compare_exchange_strong(&candidate->fingerprint, &current, kClaimingFingerprint)) {
+                
+                atomic_store_explicit(&candidate->example, (uintptr_t)CFBridgingRetain(example), memory_order_relaxed);
+                atomic_store_explicit(&candidate->fingerprint, fingerprint, memory_order_release);
+                
+                slot = candidate;
+                break;
+            }
+        }
+        
+        // Waits out another thread's claim, which is only a retain and two stores.
+        while (current == kClaimingFingerprint)
+            current = atomic_load_explicit(&candidate->fingerprint, memory_order_acquire);
+        
+        if (current == fingerprint)
+            slot = candidate;
+    }
+    
+    // The table is full around this fingerprint, so it can't be limited.
+    if (!slot)
+        return YES;
+    
+    int64_t now = (int64_t)(CFAbsoluteTimeGetCurrent() * kMicrosecondsPerSecond);
+    int64_t interval = (int64_t)(kMicrosecondsPerSecond / MAX([self ratePerSecond], 0.001));
+    int64_t tolerance = interval * (int64_t)([self burst] > 0 ? [self burst] - 1 : 0);
+    int64_t arrival = atomic_load_explicit(&slot->theoreticalArrival, memory_order_relaxed);
+    
+    for (;;) {
+        
+        int64_t start = MAX(arrival, now);
+        
+        // The bucket is empty. Only bumps the counter.
+        if (start - now > tolerance) {
+            
+            if (atomic_fetch_add_explicit(&slot->dropped, 1, memory_order_relaxed) == 0)
+                [self scheduleSummaries];
+            
+            return NO;
+        }
+        
+        if (atomic_compare_exchange_weak_explicit(&slot->theoreticalArrival, &arrival, start + interval,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+            return YES;
+    }
+}
+
+- (void)scheduleSummaries {
+    
+    if (atomic_load_explicit(&summariesScheduled, memory_order_relaxed) ||
+        atomic_exchange(&summariesScheduled, true))
+        return;
+    
+    dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0);
+    dispatch_source_t timer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, queue);
+    uint64_t interval = (uint64_t)([self summaryInterval] * NSEC_PER_SEC);
+    
+    dispatch_source_set_timer(timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)interval), interval, NSEC_PER_SEC);
+    
+    __unsafe_unretained RBErrorThrottle * throttle = self;
+    dispatch_source_set_event_handler(timer, ^{
+        [throttle logSummaries];
+    });
+    
+    [self setSummaryTimer:timer];
+    dispatch_resume(timer);
+}
+
+- (void)logSummaries {
+    
+    NSTimeInterval interval = [self summaryInterval];
+    RBLogger * logger = [self summaryLogger] ? [self summaryLogger] : [RBLogger defaultLogger];
+    
+    for (NSUInteger i = 0; i < RB_THROTTLE_TABLE_SIZE; i++) {
+        
+        RBThrottleSlot * slot = &slots[i];
+        
+        uint64_t fingerprint = atomic_load_explicit(&slot->fingerprint, memory_order_acquire);
+        
+        if (fingerprint == 0 || fingerprint == kClaimingFingerprint)
+            continue;
+        
+        uint64_t dropped = atomic_exchange_explicit(&slot->dropped, 0, memory_order_relaxed);
+        
+        if (dropped == 0)
+            continue;
+        
+        id example = (__bridge id)(void *)atomic_load_explicit(&slot->example, memory_order_relaxed);
+        NSString * count = [NSNumberFormatter localizedStringFromNumber:[NSNumber numberWithUnsignedLongLong:dropped]
+                                                            numberStyle:NSNumberFormatterDecimalStyle];
+        NSString * summary = [NSString stringWithFormat:@"%@ repeated %@× in %.0f s", 
+                              [[self class] descriptionOfExample:example], count, interval];
+        
+        [logger logMessage:summary level:RBLogLevelWarn];
+    }
+}
+
++ (NSString *)descriptionOfExample:(id)example {
+    
+    if ([example isKindOfClass:[NSError class]])
+        return [NSString stringWithFormat:@"Error %@ %ld", [example domain], (long)[example code]];
+    
+    if ([example isKindOfClass:[NSException class]])
+        return [NSString stringWithFormat:@"Exception %@: %@", [example name], [example reason]];
+    
+    return @"Error";
+}
+
++ (RBErrorThrottle *)sharedThrottle {
+    
+    static RBErrorThrottle * _sharedThrottle = nil;
+    
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        _sharedThrottle = [self new];
+    });
+    
+    return _sharedThrottle;
+}
+
+@end
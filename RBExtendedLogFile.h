@@ -25,6 +25,66 @@
 #import <Foundation/Foundation.h>
 
 #import "RBBaseLogFile.h"
+#import "RBTimestampEncoder.h"
+
+
+/**
+ * A line of an extended log file, pointing into the bytes it was parsed from.
+ */
+typedef struct {
+    
+    /// NO for header lines and lines that can't be parsed.
+    BOOL isRecord;
+    
+    /// The seconds since midnight the line was logged at.
+    CFTimeInterval timeOfDay;
+    
+    /// The message, still escaped.
+    const char * message;
+    
+    /// The number of bytes in the message.
+    NSUInteger messageLength;
+    
+    /// Whether the message contains doubled quotes that need unescaping.
+    BOOL hasDoubledQuotes;
+    
+} RBExtendedLogLine;
+
+/**
+ * Parses the line at the start of the given bytes. Messages may span several 
+ * lines of text; a message only ends at an undoubled quote followed by a 
+ * newline.
+ *
+ * @param bytes The bytes to parse.
+ * @param length The number of bytes.
+ * @param line The parsed line is returned by reference.
+ *
+ * @return The number of bytes in the line, including its newline, or 0 if the 
+ * bytes end before the line does.
+ */
+extern NSUInteger RBParseExtendedLogLine(const char * bytes, NSUInteger length, RBExtendedLogLine * line);
+
+/**
+ * Returns whether the given bytes look like the start of a line: a time 
+ * followed by a space or a fraction of a second. Used to find lines when 
+ * starting in the middle of a file. A message spanning several lines could 
+ * fool it, so callers should parse forward from what it finds.
+ *
+ * @param bytes The bytes to check.
+ * @param length The number of bytes available.
+ *
+ * @return YES if the bytes look like the start of a line, NO otherwise.
+ */
+extern BOOL RBLooksLikeExtendedLogLineStart(const char * bytes, NSUInteger length);
+
+/**
+ * Returns the message of a parsed line with its doubled quotes collapsed.
+ *
+ * @param line The parsed line.
+ *
+ * @return The message.
+ */
+extern NSString * RBMessageOfExtendedLogLine(const RBExtendedLogLine * line);
 
 
 /**
@@ -32,4 +92,11 @@
  */
 @interface RBExtendedLogFile : RBBaseLogFile
 
+/**
+ * The precision of the time written before each line. Defaults to 
+ * RBTimestampPrecisionSeconds (HH:mm:ss). Finer precisions append the 
+ * fraction of the second, which orders lines logged within the same second.
+ */
+@property (nonatomic, assign) RBTimestampPrecision timePrecision;
+
 @end
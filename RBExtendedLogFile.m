@@ -22,20 +22,60 @@
 // THE SOFTWARE.
 //
 
+#import <string.h>
+
 #import "RBExtendedLogFile.h"
+#import "RBLogOffsetIndex.h"
 #import "NSError+RBExtras.h"
 
+/// The format of the times in the log file, as written by RBTimestampEncoder.
 NSString * const kLogFileTimeFormat = @"HH:mm:ss";
 
+/**
+ * Skips a line that isn't a record.
+ *
+ * @param bytes The start of the line.
+ * @param cursor Where to look for the end of the line from.
+ * @param end The end of the bytes.
+ * @param line Marked as not a record.
+ *
+ * @return The number of bytes in the line, including its newline, or 0 if the 
+ * bytes end before the line does.
+ */
+static NSUInteger RBSkipExtendedLogLine(const char * bytes, const char * cursor, const char * end, RBExtendedLogLine * line);
+
 
 @interface RBExtendedLogFile ()
 
 /**
- * A lazy loaded date formatter for formmating the times in the log file. Change 
- * kLogFileTimeFormat to change the time format used in the log file. The date
- * formatter is stored in an ivar since it is a heavy object.
+ * Encodes the times in the log file. Much cheaper than an NSDateFormatter and 
+ * produces the same text.
  */
-@property (nonatomic, strong) NSDateFormatter * timeFormatter;
+@property (nonatomic, strong) RBTimestampEncoder * timeEncoder;
+
+/**
+ * Scratch space for the UTF-8 bytes of messages that can't be read in place. 
+ * Reused between lines so it only grows.
+ */
+@property (nonatomic, strong) NSMutableData * utf8Buffer;
+
+/**
+ * The sparse index of line offsets kept next to the file. Lets RBLogQuery 
+ * seek to a time instead of scanning from the start.
+ */
+@property (nonatomic, strong) RBLogOffsetIndex * offsetIndex;
+
+/**
+ * Returns the UTF-8 bytes of the given string without creating any objects. 
+ * The bytes are read in place when the string stores them contiguously, 
+ * otherwise they are copied into utf8Buffer.
+ *
+ * @param text The string to encode.
+ * @param length The number of bytes is returned by reference.
+ *
+ * @return The UTF-8 bytes of the string. Only valid until the next call.
+ */
+- (const char *)UTF8BytesOfString:(NSString *)text length:(NSUInteger *)length;
 
 /**
  * Attempts to create the file if it isn't already. 
@@ -57,42 +97,132 @@ NSString * const kLogFileTimeFormat = @"HH:mm:ss";
 
 @implementation RBExtendedLogFile
 
-@synthesize timeFormatter;
+@synthesize timeEncoder, utf8Buffer, offsetIndex;
 
 - (id)initWithFilePath:(NSString *)theFilePath {
     
     if ((self = [super initWithFilePath:theFilePath])) {
-        
+        [self setTimeEncoder:[RBTimestampEncoder new]];
+        [self setUtf8Buffer:[NSMutableData data]];
+        [self setOffsetIndex:[[RBLogOffsetIndex alloc] initWithLogFilePath:theFilePath]];
     }
     
     return self;
 }
 
-- (BOOL)write:(NSString *)text error:(NSError **)error {
+- (RBTimestampPrecision)timePrecision {
+    return [[self timeEncoder] precision];
+}
+
+- (void)setTimePrecision:(RBTimestampPrecision)precision {
+    [[self timeEncoder] setPrecision:precision];
+}
+
+- (void)willAppendRecord:(RBLogRecord *)record atOffset:(unsigned long long)offset {
+    [[self offsetIndex] noteRecordWithTimestamp:[record timestamp] atOffset:offset];
+}
+
+- (void)appendRecord:(RBLogRecord *)record toData:(NSMutableData *)data {
+    
+    // Writes the time the message was logged.
+    char time[RB_TIMESTAMP_MAX_LENGTH];
+    NSUInteger timeLength = [[self timeEncoder] encodeTime:[record timestamp] intoBuffer:time];
+    [data appendBytes:time length:timeLength];
+    [data appendBytes:" \"" length:2];
+    
+    // Copies the message in one pass. Quotes in strings are doubled as defined 
+    // by the extended log file format. memchr() is vectorized, so long 
+    // messages without quotes are mostly a single scan and copy.
+    NSUInteger length = 0;
+    const char * bytes = [self UTF8BytesOfString:[record message] length:&length];
+    const char * end = bytes + length;
     
-    // Creates the file, if necessary.
+    while (bytes < end) {
+        
+        const char * quote = memchr(bytes, '"', end - bytes);
+        
+        if (!quote) {
+            [data appendBytes:bytes length:end - bytes];
+            break;
+        }
+        
+        // Copies up to and including the quote, then adds the second quote.
+        [data appendBytes:bytes length:quote - bytes + 1];
+        [data appendBytes:"\"" length:1];
+        bytes = quote + 1;
+    }
+    
+    [data appendBytes:"\"\n" length:2];
+}
+
+- (const char *)UTF8BytesOfString:(NSString *)text length:(NSUInteger *)length {
+    
+    if (!text) {
+        *length = 0;
+        return "";
+    }
+    
+    // Many strings already store UTF-8 (or ASCII) bytes and can be read in place. 
+    // The pointer is NUL terminated, so it is only used when its length matches 
+    // the string's: one byte per character and no embedded NUL to cut it short.
+    const char * bytes = CFStringGetCStringPtr((__bridge CFStringRef)text, kCFStringEncodingUTF8);
+    
+    if (bytes) {
+        
+        size_t byteLength = strlen(bytes);
+        
+        if (byteLength == [text length]) {
+            *length = byteLength;
+            return bytes;
+        }
+    }
+    
+    NSMutableData * buffer = [self utf8Buffer];
+    NSUInteger maxLength = [text maximumLengthOfBytesUsingEncoding:NSUTF8StringEncoding];
+    
+    if ([buffer length] < maxLength)
+        [buffer setLength:maxLength];
+    
+    [text getBytes:[buffer mutableBytes]
+         maxLength:maxLength
+        usedLength:length
+          encoding:NSUTF8StringEncoding
+           options:0
+             range:NSMakeRange(0, [text length])
+    remainingRange:NULL];
+    
+    return [buffer bytes];
+}
+
+- (BOOL)openFile:(NSError **)error {
+    
+    if ([self isOpen])
+        return YES;
+    
+    // Creates the file and its header, if necessary, before opening it.
     if (![self createFile:error])
         return NO;
     
-    // Quotes in strings are doubled as defined by the extended log file format.
-    text = [text stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""];
-    
-    // Formats the log message.
-    NSString * now = [[self timeFormatter] stringFromDate:[NSDate date]];
-    NSString * logMsg = [NSString stringWithFormat:@"%@ \"%@\"\n", now, text];
+    return [super openFile:error];
+}
+
+- (BOOL)flush:(NSError **)error {
     
-    // Writes the formatted log message to the file.
-    NSData * logData = [logMsg dataUsingEncoding:NSUTF8StringEncoding];
+    if (![super flush:error])
+        return NO;
     
-    NSOutputStream * outFile = [NSOutputStream outputStreamToFileAtPath:[self filePath] 
-                                                                 append:YES];
-    [outFile open];
-    [outFile write:[logData bytes] maxLength:[logData length]];
-    [outFile close];
+    // The index only points at lines that are already in the file.
+    [[self offsetIndex] flush:NULL];
     
     return YES;
 }
 
+- (void)closeFile {
+    
+    [super closeFile];
+    [[self offsetIndex] close];
+}
+
 - (BOOL)createFile:(NSError **)error {
     
     NSFileManager * fileManager = [NSFileManager defaultManager];
@@ -117,6 +247,7 @@ NSString * const kLogFileTimeFormat = @"HH:mm:ss";
             return NO;
         }
         else {
+            [[self offsetIndex] reset];
             [self writeHeaderData];
         }
     }
@@ -142,28 +273,144 @@ NSString * const kLogFileTimeFormat = @"HH:mm:ss";
                             fieldStr];
     NSData * headerData = [headerStr dataUsingEncoding:NSUTF8StringEncoding];
     
-    NSOutputStream * outFile = [NSOutputStream outputStreamToFileAtPath:[self filePath] 
-                                                                 append:YES];
-    [outFile open];
-    [outFile write:[headerData bytes] maxLength:[headerData length]];
-    [outFile close];
+    [self appendData:headerData error:NULL];
 }
 
-- (NSDateFormatter *)timeFormatter {
+#pragma mark - Memory Management
+
+
+@end
+
+
+NSUInteger RBParseExtendedLogLine(const char * bytes, NSUInteger length, RBExtendedLogLine * line) {
+    
+    const char * end = bytes + length;
+    const char * cursor = bytes;
+    int fields[3] = { 0, 0, 0 };
+    
+    memset(line, 0, sizeof(*line));
     
-    // The formatter is lazy loaded.
-    if (!timeFormatter) {
+    // Parses HH:mm:ss. Anything else, such as a header line, is skipped.
+    for (int field = 0; field < 3; field++) {
         
-        timeFormatter = [[NSDateFormatter alloc] init];
-        [timeFormatter setDateFormat:kLogFileTimeFormat];
-        [timeFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+        if (end - cursor < 2)
+            return 0;
+        
+        if (cursor[0] < '0' || cursor[0] > '9' || cursor[1] < '0' || cursor[1] > '9')
+            return RBSkipExtendedLogLine(bytes, cursor, end, line);
+        
+        fields[field] = (cursor[0] - '0') * 10 + (cursor[1] - '0');
+        cursor += 2;
+        
+        if (field < 2) {
+            
+            if (cursor >= end)
+                return 0;
+            
+            if (*cursor++ != ':')
+                return RBSkipExtendedLogLine(bytes, cursor, end, line);
+        }
     }
     
-    return  timeFormatter;
+    line->timeOfDay = fields[0] * 3600 + fields[1] * 60 + fields[2];
+    
+    // Parses the optional fraction of a second.
+    if (cursor < end && *cursor == '.') {
+        
+        double scale = 0.1;
+        
+        for (cursor++; cursor < end && *cursor >= '0' && *cursor <= '9'; cursor++) {
+            line->timeOfDay += (*cursor - '0') * scale;
+            scale /= 10.0;
+        }
+    }
+    
+    if (end - cursor < 2)
+        return 0;
+    
+    if (cursor[0] != ' ' || cursor[1] != '"')
+        return RBSkipExtendedLogLine(bytes, cursor, end, line);
+    
+    cursor += 2;
+    line->message = cursor;
+    
+    // Finds the closing quote. Quotes inside the message are doubled.
+    while (YES) {
+        
+        const char * quote = memchr(cursor, '"', end - cursor);
+        
+        if (!quote || quote + 1 >= end)
+            return 0;
+        
+        if (quote[1] == '"') {
+            line->hasDoubledQuotes = YES;
+            cursor = quote + 2;
+            continue;
+        }
+        
+        if (quote[1] != '\n')
+            return RBSkipExtendedLogLine(bytes, quote, end, line);
+        
+        line->messageLength = quote - line->message;
+        line->isRecord = YES;
+        
+        return quote + 2 - bytes;
+    }
 }
 
 
-#pragma mark - Memory Management
+static NSUInteger RBSkipExtendedLogLine(const char * bytes, const char * cursor, const char * end, RBExtendedLogLine * line) {
+    
+    const char * newline = memchr(cursor, '\n', end - cursor);
+    
+    if (!newline)
+        return 0;
+    
+    line->isRecord = NO;
+    
+    return newline + 1 - bytes;
+}
 
 
-@end
+NSString * RBMessageOfExtendedLogLine(const RBExtendedLogLine * line) {
+    
+    if (!line->hasDoubledQuotes)
+        return [[NSString alloc] initWithBytes:line->message length:line->messageLength encoding:NSUTF8StringEncoding];
+    
+    // Collapses each doubled quote back into one.
+    NSMutableData * unescaped = [NSMutableData dataWithLength:line->messageLength];
+    char * output = [unescaped mutableBytes];
+    const char * bytes = line->message;
+    const char * end = bytes + line->messageLength;
+    NSUInteger length = 0;
+    
+    while (bytes < end) {
+        
+        const char * quote = memchr(bytes, '"', end - bytes);
+        const char * copyEnd = quote ? quote + 1 : end;
+        
+        memcpy(output + length, bytes, copyEnd - bytes);
+        length += copyEnd - bytes;
+        bytes = quote ? quote + 2 : end;
+    }
+    
+    return [[NSString alloc] initWithBytes:output length:length encoding:NSUTF8StringEncoding];
+}
+
+
+BOOL RBLooksLikeExtendedLogLineStart(const char * bytes, NSUInteger length) {
+    
+    // HH:mm:ss followed by a space or a fraction of a second.
+    if (length < 9)
+        return NO;
+    
+    for (NSUInteger i = 0; i < 8; i++) {
+        
+        BOOL isDigit = bytes[i] >= '0' && bytes[i] <= '9';
+        
+        if ((i == 2 || i == 5) ? bytes[i] != ':' : !isDigit)
+            return NO;
+    }
+    
+    return bytes[8] == ' ' || bytes[8] == '.';
+}
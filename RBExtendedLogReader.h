@@ -0,0 +1,193 @@
+//
+// RBExtendedLogReader.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBExtendedLogFile.h"
+#import "RBLogRecord.h"
+
+/// The error code for a file that isn't an extended log file.
+extern const NSInteger RBExtendedLogReadingError;
+
+
+/**
+ * Reads back what RBExtendedLogFile writes without copying it. The file is 
+ * memory-mapped (compressed files are decompressed into memory once), and 
+ * lines are handed out as RBExtendedLogLine views that point into the mapping. 
+ * No objects are created per line; messages are only unescaped into strings 
+ * when asked for. Views are only valid while the reader is alive.
+ *
+ * Readers are immutable, so one reader may be used from several threads.
+ */
+@interface RBExtendedLogReader : NSObject
+
+/// The contents of the log file. Usually mapped.
+@property (nonatomic, strong, readonly) NSData * data;
+
+/**
+ * The absolute time of the midnight (UTC) starting the file's day. Lines only 
+ * store the time of day, so this is added to make absolute times.
+ */
+@property (nonatomic, assign, readonly) CFAbsoluteTime dayStart;
+
+/// The number of bytes in the header. The first line starts here.
+@property (nonatomic, assign, readonly) NSUInteger headerLength;
+
+/// The app name from the #Name header line, or nil.
+@property (nonatomic, copy, readonly) NSString * appName;
+
+/// The app version from the #Version header line, or nil.
+@property (nonatomic, copy, readonly) NSString * appVersion;
+
+/// The date from the #Date header line, or nil.
+@property (nonatomic, copy, readonly) NSString * dateString;
+
+/// The fields from the #Fields header line, or nil.
+@property (nonatomic, copy, readonly) NSString * fields;
+
+/**
+ * Standard initializer. Parses the header, which is a few short lines, so the 
+ * first line can be found without scanning the file.
+ *
+ * @param data The contents of an extended log file.
+ * @param dayStart The absolute time of the midnight starting the file's day.
+ *
+ * @return self
+ */
+- (id)initWithData:(NSData *)data dayStart:(CFAbsoluteTime)dayStart;
+
+/**
+ * Reads the log file at the given path. The day is taken from the file's 
+ * name, as RBLogger names it; other names get a day start of 0.
+ *
+ * @param path The path of the log file. May be compressed.
+ * @param error An error is returned by reference if the file can't be read or 
+ * is a binary log file.
+ *
+ * @return self, or nil if the file can't be read.
+ */
+- (id)initWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+/**
+ * Parses the line at the given offset.
+ *
+ * @param line The line is returned by reference.
+ * @param offset The offset of the start of a line.
+ *
+ * @return The number of bytes in the line, or 0 if there is no complete line 
+ * at the offset.
+ */
+- (NSUInteger)readLine:(RBExtendedLogLine *)line atOffset:(NSUInteger)offset;
+
+/**
+ * Calls the given block with each record line from the first line to the end 
+ * of the file. Header and malformed lines are skipped.
+ *
+ * @param block Called with each line and its offset. Set stop to YES to stop.
+ */
+- (void)enumerateLinesUsingBlock:(void (^)(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop))block;
+
+/**
+ * Calls the given block with each record line that starts in the given range 
+ * of offsets. The start must be the start of a line.
+ *
+ * @param start The offset of the first line.
+ * @param end The offset to stop at. Lines starting before it may end after it.
+ * @param block Called with each line and its offset. Set stop to YES to stop.
+ */
+- (void)enumerateLinesFromOffset:(NSUInteger)start 
+                        toOffset:(NSUInteger)end 
+                      usingBlock:(void (^)(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop))block;
+
+/**
+ * Returns the absolute time of the given line.
+ *
+ * @param line A line from this reader.
+ *
+ * @return The time the line was logged.
+ */
+- (CFAbsoluteTime)timestampOfLine:(const RBExtendedLogLine *)line;
+
+/**
+ * Returns the range of the given line's escaped message in the data.
+ *
+ * @param line A line from this reader.
+ *
+ * @return The byte range of the message.
+ */
+- (NSRange)messageRangeOfLine:(const RBExtendedLogLine *)line;
+
+/**
+ * Returns the unescaped message of the given line. Creates a string, so only 
+ * call it for lines that are needed.
+ *
+ * @param line A line from this reader.
+ *
+ * @return The message.
+ */
+- (NSString *)messageOfLine:(const RBExtendedLogLine *)line;
+
+/**
+ * Returns a record for the given line.
+ *
+ * @param line A line from this reader.
+ *
+ * @return A record with the line's message and absolute time. Its level is 
+ * RBLogLevelUnknown.
+ */
+- (RBLogRecord *)recordForLine:(const RBExtendedLogLine *)line;
+
+/**
+ * Returns the contents of the log file at the given path. Plain files are 
+ * mapped; compressed files are decompressed into memory.
+ *
+ * @param path The path of the log file. May be compressed.
+ * @param error An error is returned by reference if the file can't be read.
+ *
+ * @return The contents of the file, or nil if it can't be read.
+ */
++ (NSData *)contentsOfLogFileAtPath:(NSString *)path error:(NSError **)error;
+
+/**
+ * Returns the path a log file can be read from. A file may be compressed 
+ * between looking up its path and reading it, so this checks for both the 
+ * plain and the compressed file.
+ *
+ * @param path The path of the log file, plain or compressed.
+ *
+ * @return The path of the file that exists, or nil if neither does.
+ */
++ (NSString *)readablePathForLogFilePath:(NSString *)path;
+
+/**
+ * Returns the absolute time of the midnight starting the day in the given log 
+ * file's name.
+ *
+ * @param path The path of the log file, plain or compressed.
+ *
+ * @return The start of the file's day, or 0 if the name has no day.
+ */
++ (CFAbsoluteTime)dayStartForLogFilePath:(NSString *)path;
+
+@end
@@ -0,0 +1,244 @@
+//
+// RBExtendedLogReader.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBExtendedLogReader.h"
+#import "RBLogSegment.h"
+#import "RBLogFileCompressor.h"
+#import "RBBinaryLogDecoder.h"
+#import "NSError+RBExtras.h"
+
+#import <string.h>
+
+const NSInteger RBExtendedLogReadingError = 3003;
+
+
+@interface RBExtendedLogReader ()
+
+@property (nonatomic, strong, readwrite) NSData * data;
+@property (nonatomic, assign, readwrite) CFAbsoluteTime dayStart;
+@property (nonatomic, assign, readwrite) NSUInteger headerLength;
+@property (nonatomic, copy, readwrite) NSString * appName;
+@property (nonatomic, copy, readwrite) NSString * appVersion;
+@property (nonatomic, copy, readwrite) NSString * dateString;
+@property (nonatomic, copy, readwrite) NSString * fields;
+
+/**
+ * Parses the '#' lines at the start of the file and sets headerLength to the 
+ * offset just past them.
+ */
+- (void)parseHeader;
+
+/**
+ * Returns an error for a file that isn't an extended log file.
+ *
+ * @param path The path of the file.
+ *
+ * @return An error in RBErrorDomain.
+ */
++ (NSError *)readingErrorForPath:(NSString *)path;
+
+@end
+
+
+@implementation RBExtendedLogReader
+
+@synthesize data, dayStart, headerLength, appName, appVersion, dateString, fields;
+
+- (id)initWithData:(NSData *)theData dayStart:(CFAbsoluteTime)theDayStart {
+    
+    NSParameterAssert(theData);
+    
+    if ((self = [super init])) {
+        
+        [self setData:theData];
+        [self setDayStart:theDayStart];
+        [self parseHeader];
+    }
+    
+    return self;
+}
+
+- (id)initWithContentsOfFile:(NSString *)path error:(NSError **)error {
+    
+    NSData * contents = [[self class] contentsOfLogFileAtPath:path error:error];
+    
+    if (!contents)
+        return nil;
+    
+    if ([RBBinaryLogDecoder isBinaryLogData:contents]) {
+        
+        if (error != NULL)
+            *error = [[self class] readingErrorForPath:path];
+        
+        return nil;
+    }
+    
+    return [self initWithData:contents dayStart:[[self class] dayStartForLogFilePath:path]];
+}
+
+- (void)parseHeader {
+    
+    const char * bytes = [[self data] bytes];
+    NSUInteger length = [[self data] length];
+    NSUInteger offset = 0;
+    
+    // The header is a handful of '#' lines, so this is a few memchr() calls whatever the file size.
+    while (offset < length && bytes[offset] == '#') {
+        
+        const char * newline = memchr(bytes + offset, '\n', length - offset);
+        
+        if (!newline)
+            break;
+        
+        NSUInteger lineLength = newline - (bytes + offset);
+        NSString * line = [[NSString alloc] initWithBytes:bytes + offset + 1 
+                                                   length:lineLength - 1 
+                                                 encoding:NSUTF8StringEncoding];
+        NSRange colon = [line rangeOfString:@": "];
+        
+        if (colon.location != NSNotFound) {
+            
+            NSString * key = [line substringToIndex:colon.location];
+            NSString * value = [line substringFromIndex:NSMaxRange(colon)];
+            
+            if ([key isEqualToString:@"Name"])
+                [self setAppName:value];
+            else if ([key isEqualToString:@"Version"])
+                [self setAppVersion:value];
+            else if ([key isEqualToString:@"Date"])
+                [self setDateString:value];
+            else if ([key isEqualToString:@"Fields"])
+                [self setFields:value];
+        }
+        
+        offset += lineLength + 1;
+    }
+    
+    [self setHeaderLength:offset];
+}
+
+- (NSUInteger)readLine:(RBExtendedLogLine *)line atOffset:(NSUInteger)offset {
+    
+    NSUInteger length = [[self data] length];
+    
+    if (offset >= length)
+        return 0;
+    
+    return RBParseExtendedLogLine((const char *)[[self data] bytes] + offset, length - offset, line);
+}
+
+- (void)enumerateLinesUsingBlock:(void (^)(const RBExtendedLogLine *, NSUInteger, BOOL *))block {
+    [self enumerateLinesFromOffset:[self headerLength] toOffset:[[self data] length] usingBlock:block];
+}
+
+- (void)enumerateLinesFromOffset:(NSUInteger)start 
+                        toOffset:(NSUInteger)end 
+                      usingBlock:(void (^)(const RBExtendedLogLine *, NSUInteger, BOOL *))block {
+    
+    const char * bytes = [[self data] bytes];
+    NSUInteger length = [[self data] length];
+    NSUInteger offset = MAX(start, [self headerLength]);
+    RBExtendedLogLine line;
+    BOOL stop = NO;
+    
+    end = MIN(end, length);
+    
+    while (!stop && offset < end) {
+        
+        // Lines may run past the end of the range, but not past the end of the data.
+        NSUInteger lineLength = RBParseExtendedLogLine(bytes + offset, length - offset, &line);
+        
+        if (lineLength == 0)
+            break;
+        
+        if (line.isRecord)
+            block(&line, offset, &stop);
+        
+        offset += lineLength;
+    }
+}
+
+- (CFAbsoluteTime)timestampOfLine:(const RBExtendedLogLine *)line {
+    return [self dayStart] + line->timeOfDay;
+}
+
+- (NSRange)messageRangeOfLine:(const RBExtendedLogLine *)line {
+    return NSMakeRange(line->message - (const char *)[[self data] bytes], line->messageLength);
+}
+
+- (NSString *)messageOfLine:(const RBExtendedLogLine *)line {
+    return RBMessageOfExtendedLogLine(line);
+}
+
+- (RBLogRecord *)recordForLine:(const RBExtendedLogLine *)line {
+    
+    // Extended log files don't store levels.
+    return [[RBLogRecord alloc] initWithMessage:RBMessageOfExtendedLogLine(line) 
+                                           type:RBLogRecordTypeMessage 
+                                          level:RBLogLevelUnknown 
+                                      timestamp:[self timestampOfLine:line]];
+}
+
++ (NSData *)contentsOfLogFileAtPath:(NSString *)path error:(NSError **)error {
+    
+    if (![[path pathExtension] isEqualToString:RBCompressedLogFileExtension])
+        return [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+    
+    NSMutableData * contents = [NSMutableData data];
+    BOOL read = [RBLogFileCompressor enumerateChunksOfFileAtPath:path usingBlock:^(const void * bytes, NSUInteger length, BOOL * stop) {
+        [contents appendBytes:bytes length:length];
+    } error:error];
+    
+    return read ? contents : nil;
+}
+
++ (NSString *)readablePathForLogFilePath:(NSString *)path {
+    
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    
+    if ([fileManager fileExistsAtPath:path])
+        return path;
+    
+    BOOL compressed = [[path pathExtension] isEqualToString:RBCompressedLogFileExtension];
+    NSString * otherPath = compressed ? [path stringByDeletingPathExtension] : [RBLogFileCompressor compressedPathForPath:path];
+    
+    return [fileManager fileExistsAtPath:otherPath] ? otherPath : nil;
+}
+
++ (CFAbsoluteTime)dayStartForLogFilePath:(NSString *)path {
+    
+    RBLogSegment * segment = [RBLogSegment segmentWithFileName:[path lastPathComponent]];
+    
+    return segment ? [RBLogSegment startTimeOfDay:[segment day]] : 0;
+}
+
++ (NSError *)readingErrorForPath:(NSString *)path {
+    
+    NSString * description = [NSString stringWithFormat:@"Log file %@ is not an extended log file.", [path lastPathComponent]];
+    NSDictionary * userInfo = [NSDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey];
+    
+    return [NSError errorWithDomain:RBErrorDomain code:RBExtendedLogReadingError userInfo:userInfo];
+}
+
+@end
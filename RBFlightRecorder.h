@@ -0,0 +1,100 @@
+//
+// RBFlightRecorder.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogRecord.h"
+
+
+/**
+ * A fixed-size circular log kept in a memory-mapped file. Messages are copied 
+ * into it on the calling thread as they are logged, before they are queued 
+ * for the log file. Recording is a lock-free reservation and a memcpy into 
+ * the mapping, with no system call. The pages belong to the kernel's page 
+ * cache, so they survive the process crashing and the last messages before a 
+ * crash can be recovered on the next launch, even those that never made it 
+ * out of the logger's queue.
+ *
+ * Each record starts with a commit word holding its position in the stream 
+ * plus one, stored last. Records torn by a crash, or overwritten by newer 
+ * ones, don't match their position and are skipped on recovery. Once a 
+ * record has reached the log file, or was dropped on purpose, the logger 
+ * retires it by setting a flag in its commit word, so recovery only returns 
+ * the records that were still in flight. Records are retired one by one 
+ * rather than up to a time or position, since messages from different threads 
+ * reach the log file in a different order than they were recorded.
+ */
+@interface RBFlightRecorder : NSObject
+
+/// The path of the mapped file.
+@property (nonatomic, copy, readonly) NSString * path;
+
+/// The number of bytes of records the file holds.
+@property (nonatomic, assign, readonly) NSUInteger capacity;
+
+/**
+ * Opens or creates the file and maps it. Records left by an earlier launch 
+ * stay in place until -recoverRecords is called.
+ *
+ * @param path The path of the file.
+ * @param capacity The number of bytes of records to hold. Rounded up to a 
+ * multiple of 8.
+ * @param error The error is returned by reference if the file can't be mapped.
+ *
+ * @return self, or nil if the file can't be mapped.
+ */
+- (id)initWithPath:(NSString *)path capacity:(NSUInteger)capacity error:(NSError **)error;
+
+/**
+ * Copies a message into the file. Long messages are truncated. Threadsafe 
+ * and lock-free.
+ *
+ * @param msg The message.
+ * @param type What the message was created from.
+ * @param level How severe the message is.
+ * @param timestamp The absolute time the message was logged.
+ *
+ * @return An ID for the record to pass to -retireRecord:. Never 0.
+ */
+- (uint64_t)recordMessage:(NSString *)msg type:(RBLogRecordType)type level:(RBLogLevel)level timestamp:(CFAbsoluteTime)timestamp;
+
+/**
+ * Notes that a record no longer needs recovering, because it has reached the 
+ * log file or was dropped. Does nothing if the record has already been 
+ * overwritten. Threadsafe and lock-free.
+ *
+ * @param recordID The ID returned by -recordMessage:type:level:timestamp:, or 
+ * 0 for none.
+ */
+- (void)retireRecord:(uint64_t)recordID;
+
+/**
+ * Returns the intact records that were never retired, then empties the file. 
+ * Must be called before anything new is recorded.
+ *
+ * @return The RBLogRecords, oldest first.
+ */
+- (NSArray *)recoverRecords;
+
+@end
@@ -0,0 +1,321 @@
+//
+// RBFlightRecorder.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <fcntl.h>
+#import <stdatomic.h>
+#import <string.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+#import "RBFlightRecorder.h"
+
+/// The first bytes of a flight recorder file.
+#define RB_FLIGHT_RECORDER_MAGIC "RBFR"
+
+/// The version of the flight recorder layout. Version 1 kept a persisted time.
+#define RB_FLIGHT_RECORDER_VERSION 2
+
+/// The bit set in a record's commit word once it has been retired.
+#define RB_FLIGHT_RECORD_RETIRED (1ULL << 63)
+
+/// Messages longer than this many UTF-8 bytes are truncated.
+#define RB_FLIGHT_RECORD_MAX_MESSAGE 1024
+
+/// The smallest capacity accepted, so the longest record always fits.
+#define RB_FLIGHT_RECORDER_MIN_CAPACITY 4096
+
+
+/**
+ * The start of the file.
+ */
+typedef struct {
+    
+    /// RB_FLIGHT_RECORDER_MAGIC.
+    char magic[4];
+    
+    /// RB_FLIGHT_RECORDER_VERSION.
+    uint32_t version;
+    
+    /// The number of bytes of records after the header.
+    uint64_t capacity;
+    
+    /// The total number of bytes ever reserved. Records live at this modulo capacity.
+    _Atomic(uint64_t) writePosition;
+    
+    /// Pads the header to 64 bytes.
+    uint8_t reserved[40];
+    
+} RBFlightRecorderHeader;
+
+/**
+ * The start of each record. The UTF-8 message follows, then padding to a 
+ * multiple of 8 bytes.
+ */
+typedef struct {
+    
+    /// The record's position plus one, stored once the rest is written. 
+    /// RB_FLIGHT_RECORD_RETIRED is added once it no longer needs recovering.
+    _Atomic(uint64_t) commit;
+    
+    /// The absolute time the message was logged.
+    double timestamp;
+    
+    /// The number of message bytes.
+    uint32_t length;
+    
+    /// The RBLogLevel.
+    uint8_t level;
+    
+    /// The RBLogRecordType.
+    uint8_t type;
+    
+    /// Unused.
+    uint16_t reserved;
+    
+} RBFlightRecordHeader;
+
+
+/**
+ * Returns the bytes a record with the given message length takes up.
+ */
+static inline uint64_t RBFlightRecordSize(uint64_t length) {
+    return (sizeof(RBFlightRecordHeader) + length + 7) & ~(uint64_t)7;
+}
+
+/**
+ * Reserves room for a record. Records never wrap around the end of the 
+ * file; one that doesn't fit before the end starts the next lap instead, and 
+ * the gap is skipped on recovery.
+ *
+ * @return The position of the reserved record.
+ */
+static uint64_t RBReserveFlightRecord(RBFlightRecorderHeader * header, uint64_t capacity, uint64_t size) {
+    
+    uint64_t position = atomic_load_explicit(&header->writePosition, memory_order_relaxed);
+    uint64_t start = 0;
+    
+    do {
+        
+        start = position;
+        
+        if (start % capacity + size > capacity)
+            start += capacity - start % capacity;
+        
+    } while (!atomic_compare_exchange_weak_explicit(&header->writePosition, &position, start + size,
+                                                    memory_order_relaxed,
+                                                    memory_order_relaxed));
+    
+    return start;
+}
+
+
+@interface RBFlightRecorder () {
+    
+    /// The mapped file.
+    void * mapping;
+    
+    /// The length of the mapping.
+    size_t mappingLength;
+    
+    /// The header at the start of the mapping.
+    RBFlightRecorderHeader * header;
+    
+    /// The records, after the header.
+    uint8_t * records;
+}
+
+@property (nonatomic, copy, readwrite) NSString * path;
+@property (nonatomic, assign, readwrite) NSUInteger capacity;
+
+/**
+ * Clears the records and writes a fresh header.
+ */
+- (void)reset;
+
+@end
+
+
+@implementation RBFlightRecorder
+
+@synthesize path, capacity;
+
+- (id)initWithPath:(NSString *)thePath capacity:(NSUInteger)theCapacity error:(NSError **)error {
+    
+    if ((self = [super init])) {
+        
+        [self setPath:thePath];
+        [self setCapacity:(MAX(theCapacity, RB_FLIGHT_RECORDER_MIN_CAPACITY) + 7) & ~(NSUInteger)7];
+        mappingLength = sizeof(RBFlightRecorderHeader) + [self capacity];
+        
+        int fileDescriptor = open([thePath fileSystemRepresentation], O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        struct stat info;
+        
+        if (fileDescriptor >= 0 && fstat(fileDescriptor, &info) == 0 && (size_t)info.st_size != mappingLength)
+            ftruncate(fileDescriptor, (off_t)mappingLength);
+        
+        if (fileDescriptor >= 0)
+            mapping = mmap(NULL, mappingLength, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+        
+        if (fileDescriptor < 0 || mapping == MAP_FAILED) {
+            
+            int code = errno;
+            
+            if (fileDescriptor >= 0)
+                close(fileDescriptor);
+            
+            if (error != NULL)
+                *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:nil];
+            
+            return nil;
+        }
+        
+        // The mapping keeps the file open.
+        close(fileDescriptor);
+        
+        header = mapping;
+        records = (uint8_t *)mapping + sizeof(RBFlightRecorderHeader);
+        
+        // Starts over if the file isn't one of ours or was made with another capacity.
+        if (memcmp(header->magic, RB_FLIGHT_RECORDER_MAGIC, 4) != 0 ||
+            header->version != RB_FLIGHT_RECORDER_VERSION ||
+            header->capacity != [self capacity])
+            [self reset];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    if (mapping && mapping != MAP_FAILED)
+        munmap(mapping, mappingLength);
+}
+
+- (uint64_t)recordMessage:(NSString *)msg type:(RBLogRecordType)type level:(RBLogLevel)level timestamp:(CFAbsoluteTime)timestamp {
+    
+    // Encodes into the stack first, since the size must be known to reserve room.
+    char bytes[RB_FLIGHT_RECORD_MAX_MESSAGE];
+    NSUInteger length = 0;
+    
+    [msg getBytes:bytes
+        maxLength:RB_FLIGHT_RECORD_MAX_MESSAGE
+       usedLength:&length
+         encoding:NSUTF8StringEncoding
+          options:0
+            range:NSMakeRange(0, [msg length])
+   remainingRange:NULL];
+    
+    uint64_t position = RBReserveFlightRecord(header, [self capacity], RBFlightRecordSize(length));
+    RBFlightRecordHeader * record = (RBFlightRecordHeader *)(records + position % [self capacity]);
+    
+    record->timestamp = timestamp;
+    record->length = (uint32_t)length;
+    record->level = (uint8_t)level;
+    record->type = (uint8_t)type;
+    memcpy(record + 1, bytes, length);
+    
+    atomic_store_explicit(&record->commit, position + 1, memory_order_release);
+    
+    return position + 1;
+}
+
+- (void)retireRecord:(uint64_t)recordID {
+    
+    if (recordID == 0)
+        return;
+    
+    RBFlightRecordHeader * record = (RBFlightRecordHeader *)(records + (recordID - 1) % [self capacity]);
+    uint64_t expected = recordID;
+    
+    // Fails harmlessly if a newer record has taken the space. A writer still 
+    // filling that space overwrites the flag along with the rest.
+    atomic_compare_exchange_strong_explicit(&record->commit, &expected, recordID | RB_FLIGHT_RECORD_RETIRED,
+                                            memory_order_relaxed,
+                                            memory_order_relaxed);
+}
+
+- (NSArray *)recoverRecords {
+    
+    NSMutableArray * recovered = [NSMutableArray array];
+    uint64_t recordCapacity = [self capacity];
+    uint64_t end = atomic_load_explicit(&header->writePosition, memory_order_acquire);
+    uint64_t position = end > recordCapacity ? end - recordCapacity : 0;
+    
+    // Only the last capacity bytes can hold intact records. Anything that 
+    // doesn't look like a committed record at its position is skipped 8 bytes 
+    // at a time until the next one.
+    while (position + sizeof(RBFlightRecordHeader) <= end) {
+        
+        uint64_t offset = position % recordCapacity;
+        
+        if (offset + sizeof(RBFlightRecordHeader) > recordCapacity) {
+            position += recordCapacity - offset;
+            continue;
+        }
+        
+        RBFlightRecordHeader * record = (RBFlightRecordHeader *)(records + offset);
+        uint64_t size = RBFlightRecordSize(record->length);
+        uint64_t commit = atomic_load_explicit(&record->commit, memory_order_acquire);
+        
+        if ((commit & ~RB_FLIGHT_RECORD_RETIRED) != position + 1 ||
+            record->length > RB_FLIGHT_RECORD_MAX_MESSAGE ||
+            offset + size > recordCapacity ||
+            position + size > end) {
+            
+            position += 8;
+            continue;
+        }
+        
+        // Retired records are already in the log file or were dropped.
+        if (!(commit & RB_FLIGHT_RECORD_RETIRED)) {
+            
+            NSString * msg = [[NSString alloc] initWithBytes:record + 1 
+                                                      length:record->length 
+                                                    encoding:NSUTF8StringEncoding];
+            
+            [recovered addObject:[[RBLogRecord alloc] initWithMessage:msg 
+                                                                 type:record->type 
+                                                                level:record->level 
+                                                            timestamp:record->timestamp]];
+        }
+        
+        position += size;
+    }
+    
+    [self reset];
+    
+    return recovered;
+}
+
+- (void)reset {
+    
+    memset(mapping, 0, mappingLength);
+    memcpy(header->magic, RB_FLIGHT_RECORDER_MAGIC, 4);
+    header->version = RB_FLIGHT_RECORDER_VERSION;
+    header->capacity = [self capacity];
+    atomic_init(&header->writePosition, 0);
+}
+
+@end
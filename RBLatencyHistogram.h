@@ -0,0 +1,103 @@
+//
+// RBLatencyHistogram.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * A summary of the durations in a histogram. Times are in seconds. 
+ * Percentiles are the upper bound of the bucket they fall in, so they can be 
+ * up to twice the real value, but never more than max.
+ */
+typedef struct {
+    
+    /// The number of durations recorded.
+    unsigned long long count;
+    
+    /// The sum of the durations.
+    NSTimeInterval total;
+    
+    /// The median duration.
+    NSTimeInterval p50;
+    
+    /// The 99th percentile duration.
+    NSTimeInterval p99;
+    
+    /// The longest duration.
+    NSTimeInterval max;
+    
+} RBLatencySummary;
+
+
+/**
+ * Counts durations in power of two buckets of microseconds, from under 1 µs 
+ * to days. Recording a duration is a few relaxed atomic adds with no locking 
+ * or allocation, so it can be done from any thread on a hot path. Reads are 
+ * not a consistent snapshot, but each count is exact.
+ */
+@interface RBLatencyHistogram : NSObject
+
+/**
+ * Counts a duration. Threadsafe.
+ *
+ * @param duration The duration in seconds. Negative durations count as 0.
+ */
+- (void)recordDuration:(NSTimeInterval)duration;
+
+/**
+ * Counts the time since the given start time. Threadsafe.
+ *
+ * @param start A time from CFAbsoluteTimeGetCurrent().
+ */
+- (void)recordDurationSince:(CFAbsoluteTime)start;
+
+/**
+ * Returns the duration below which the given fraction of the recorded 
+ * durations fall. Threadsafe.
+ *
+ * @param fraction A fraction between 0 and 1, e.g. 0.99.
+ *
+ * @return The upper bound of the bucket the percentile falls in, or 0 if 
+ * nothing has been recorded.
+ */
+- (NSTimeInterval)durationAtPercentile:(double)fraction;
+
+/**
+ * Returns the count, total, median, 99th percentile and max. Threadsafe.
+ *
+ * @return The summary.
+ */
+- (RBLatencySummary)summary;
+
+/**
+ * Returns a one line description of a summary, such as 
+ * "12,034 × p50 64 µs, p99 1.0 ms, max 3.2 ms".
+ *
+ * @param summary The summary.
+ *
+ * @return The description.
+ */
++ (NSString *)descriptionOfSummary:(RBLatencySummary)summary;
+
+@end
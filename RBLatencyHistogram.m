@@ -0,0 +1,175 @@
+//
+// RBLatencyHistogram.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <math.h>
+#import <stdatomic.h>
+
+#import "RBLatencyHistogram.h"
+
+/// The number of buckets. The last one holds everything from 2^46 µs on.
+#define RB_HISTOGRAM_BUCKET_COUNT 48
+
+/// The microseconds in a second.
+static const double kMicrosecondsPerSecond = 1000000.0;
+
+
+@interface RBLatencyHistogram () {
+    
+    /// Bucket 0 counts durations under 1 µs, bucket i those in [2^(i-1), 2^i) µs.
+    _Atomic(uint64_t) buckets[RB_HISTOGRAM_BUCKET_COUNT];
+    
+    /// The number of durations recorded.
+    _Atomic(uint64_t) count;
+    
+    /// The sum of the durations in µs.
+    _Atomic(uint64_t) totalMicroseconds;
+    
+    /// The longest duration in µs.
+    _Atomic(uint64_t) maxMicroseconds;
+}
+
+/**
+ * Returns a duration in seconds as a short string in µs, ms or s.
+ *
+ * @param duration The duration.
+ *
+ * @return The string.
+ */
++ (NSString *)stringWithDuration:(NSTimeInterval)duration;
+
+@end
+
+
+@implementation RBLatencyHistogram
+
+- (id)init {
+    
+    if ((self = [super init])) {
+        
+        for (NSUInteger i = 0; i < RB_HISTOGRAM_BUCKET_COUNT; i++)
+            atomic_init(&buckets[i], 0);
+        
+        atomic_init(&count, 0);
+        atomic_init(&totalMicroseconds, 0);
+        atomic_init(&maxMicroseconds, 0);
+    }
+    
+    return self;
+}
+
+- (void)recordDuration:(NSTimeInterval)duration {
+    
+    uint64_t microseconds = duration > 0.0 ? (uint64_t)(duration * kMicrosecondsPerSecond) : 0;
+    NSUInteger bucket = microseconds ? (NSUInteger)(64 - __builtin_clzll(microseconds)) : 0;
+    
+    bucket = MIN(bucket, (NSUInteger)(RB_HISTOGRAM_BUCKET_COUNT - 1));
+    
+    atomic_fetch_add_explicit(&buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&totalMicroseconds, microseconds, memory_order_relaxed);
+    
+    // Only writes when the max grows, which quickly becomes rare.
+    uint64_t max = atomic_load_explicit(&maxMicroseconds, memory_order_relaxed);
+    
+    while (microseconds > max &&
+           !atomic_compare_exchange_weak_explicit(&maxMicroseconds, &max, microseconds,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed));
+}
+
+- (void)recordDurationSince:(CFAbsoluteTime)start {
+    [self recordDuration:CFAbsoluteTimeGetCurrent() - start];
+}
+
+- (NSTimeInterval)durationAtPercentile:(double)fraction {
+    
+    uint64_t snapshot[RB_HISTOGRAM_BUCKET_COUNT];
+    uint64_t total = 0;
+    
+    // Sums the buckets read rather than using count, which may have moved on.
+    for (NSUInteger i = 0; i < RB_HISTOGRAM_BUCKET_COUNT; i++) {
+        snapshot[i] = atomic_load_explicit(&buckets[i], memory_order_relaxed);
+        total += snapshot[i];
+    }
+    
+    if (total == 0)
+        return 0.0;
+    
+    uint64_t rank = (uint64_t)ceil(MIN(MAX(fraction, 0.0), 1.0) * (double)total);
+    uint64_t seen = 0;
+    NSUInteger bucket = 0;
+    
+    for (bucket = 0; bucket < RB_HISTOGRAM_BUCKET_COUNT - 1; bucket++) {
+        
+        seen += snapshot[bucket];
+        
+        if (seen >= MAX(rank, (uint64_t)1))
+            break;
+    }
+    
+    double upperBound = ldexp(1.0, (int)bucket) / kMicrosecondsPerSecond;
+    double max = atomic_load_explicit(&maxMicroseconds, memory_order_relaxed) / kMicrosecondsPerSecond;
+    
+    return MIN(upperBound, max);
+}
+
+- (RBLatencySummary)summary {
+    
+    RBLatencySummary summary;
+    
+    summary.count = atomic_load_explicit(&count, memory_order_relaxed);
+    summary.total = atomic_load_explicit(&totalMicroseconds, memory_order_relaxed) / kMicrosecondsPerSecond;
+    summary.p50 = [self durationAtPercentile:0.5];
+    summary.p99 = [self durationAtPercentile:0.99];
+    summary.max = atomic_load_explicit(&maxMicroseconds, memory_order_relaxed) / kMicrosecondsPerSecond;
+    
+    return summary;
+}
+
++ (NSString *)descriptionOfSummary:(RBLatencySummary)summary {
+    
+    NSString * count = [NSNumberFormatter localizedStringFromNumber:[NSNumber numberWithUnsignedLongLong:summary.count]
+                                                        numberStyle:NSNumberFormatterDecimalStyle];
+    
+    if (summary.count == 0)
+        return count;
+    
+    return [NSString stringWithFormat:@"%@ × p50 %@, p99 %@, max %@", count,
+            [self stringWithDuration:summary.p50],
+            [self stringWithDuration:summary.p99],
+            [self stringWithDuration:summary.max]];
+}
+
++ (NSString *)stringWithDuration:(NSTimeInterval)duration {
+    
+    if (duration < 0.001)
+        return [NSString stringWithFormat:@"%.0f µs", duration * kMicrosecondsPerSecond];
+    
+    if (duration < 1.0)
+        return [NSString stringWithFormat:@"%.1f ms", duration * 1000.0];
+    
+    return [NSString stringWithFormat:@"%.2f s", duration];
+}
+
+@end
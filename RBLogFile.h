@@ -24,6 +24,8 @@
 
 #import <Foundation/Foundation.h>
 
+#import "RBLogRecord.h"
+
 /**
  * Protocol for log files. These log file objects are wrappers around files on 
  * the local system or a server.
@@ -61,4 +63,38 @@
  */
 - (BOOL)underlyingFileExists;
 
+@optional
+
+/**
+ * Appends the given records to the underlying log file in order, using the 
+ * time stored in each record. The records may be buffered until -flush: is 
+ * called. This should not be called directly. Use RBLogger so that all writes 
+ * are synchronized and thread safe.
+ *
+ * @param records An array of RBLogRecords to write.
+ * @param error An error is returned by reference if the records can't be 
+ * written.
+ *
+ * @return YES if the write was successful, NO otherwise.
+ */
+- (BOOL)writeRecords:(NSArray *)records error:(NSError **)error;
+
+/**
+ * Writes any buffered text to the underlying file. Log files may hold written 
+ * text in memory and keep the underlying file open between writes. This 
+ * should not be called directly. Use RBLogger so that all writes are 
+ * synchronized and thread safe.
+ *
+ * @param error An error is returned by reference if the text can't be written.
+ *
+ * @return YES if the flush was successful, NO otherwise.
+ */
+- (BOOL)flush:(NSError **)error;
+
+/**
+ * Flushes any buffered text and releases the underlying file. The next write 
+ * reopens the file.
+ */
+- (void)closeFile;
+
 @end
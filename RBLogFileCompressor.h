@@ -0,0 +1,83 @@
+//
+// RBLogFileCompressor.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/// The error code for failing to compress or decompress a log file.
+extern const NSInteger RBLogFileCompressionError;
+
+/// The extension added to the paths of compressed log files.
+extern NSString * const RBCompressedLogFileExtension;
+
+
+/**
+ * Compresses finished log files with gzip and reads them back. Files are 
+ * streamed through a fixed-size buffer, so the whole file is never in memory. 
+ * Requires libz.
+ */
+@interface RBLogFileCompressor : NSObject
+
+/**
+ * Compresses the file at the given path into a gzip file at the same path with 
+ * RBCompressedLogFileExtension appended, then deletes the original. The 
+ * compressed file only appears once it is complete. If a compressed file 
+ * already exists at that path, it isn't replaced: the new data is added to the 
+ * end of it as another gzip member, so it reads back as the old contents 
+ * followed by the new. That suits text logs, whose header lines readers skip 
+ * anywhere in a file; binary log files can only be decoded from one header, 
+ * so the logger never compresses two files to the same path.
+ *
+ * @param path The path of the file to compress.
+ * @param error An error is returned by reference if the file can't be 
+ * compressed. The original file is kept in that case.
+ *
+ * @return YES if the file was compressed, NO otherwise.
+ */
++ (BOOL)compressFileAtPath:(NSString *)path error:(NSError **)error;
+
+/**
+ * Reads the file at the given path in chunks. Gzip files are decompressed 
+ * transparently; other files are read as they are.
+ *
+ * @param path The path of the file to read.
+ * @param block Called with each chunk. The bytes are only valid during the 
+ * call. Set stop to YES to stop reading.
+ * @param error An error is returned by reference if the file can't be read.
+ *
+ * @return YES if the file was read, NO otherwise.
+ */
++ (BOOL)enumerateChunksOfFileAtPath:(NSString *)path 
+                         usingBlock:(void (^)(const void * bytes, NSUInteger length, BOOL * stop))block 
+                              error:(NSError **)error;
+
+/**
+ * Returns the path a file is compressed to.
+ *
+ * @param path The path of the uncompressed file.
+ *
+ * @return The path of the compressed file.
+ */
++ (NSString *)compressedPathForPath:(NSString *)path;
+
+@end
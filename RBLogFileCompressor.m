@@ -0,0 +1,197 @@
+//
+// RBLogFileCompressor.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <errno.h>
+#import <fcntl.h>
+#import <unistd.h>
+#import <zlib.h>
+
+#import "RBLogFileCompressor.h"
+#import "NSError+RBExtras.h"
+
+const NSInteger RBLogFileCompressionError = 3002;
+
+NSString * const RBCompressedLogFileExtension = @"gz";
+
+/// The size of the chunks files are streamed in.
+static const NSUInteger kCompressionChunkSize = 64 * 1024;
+
+
+@interface RBLogFileCompressor ()
+
+/**
+ * Returns an error for a file that can't be compressed or decompressed.
+ *
+ * @param path The path of the file.
+ *
+ * @return The error.
+ */
++ (NSError *)compressionErrorForPath:(NSString *)path;
+
+@end
+
+
+@implementation RBLogFileCompressor
+
++ (BOOL)compressFileAtPath:(NSString *)path error:(NSError **)error {
+    
+    NSString * compressedPath = [self compressedPathForPath:path];
+    NSString * tempPath = [compressedPath stringByAppendingPathExtension:@"tmp"];
+    
+    int input = open([path fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+    
+    if (input < 0) {
+        
+        if (error != NULL)
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        
+        return NO;
+    }
+    
+    // A file compressed earlier, such as the same day before a relaunch, is kept 
+    // by appending the new data to a copy of it as another gzip member. 
+    // gzread() reads concatenated members back as one stream.
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    BOOL appending = [fileManager fileExistsAtPath:compressedPath];
+    
+    unlink([tempPath fileSystemRepresentation]);
+    
+    if (appending && ![fileManager copyItemAtPath:compressedPath toPath:tempPath error:error]) {
+        close(input);
+        return NO;
+    }
+    
+    gzFile output = gzopen([tempPath fileSystemRepresentation], appending ? "ab" : "wb");
+    
+    if (!output) {
+        
+        close(input);
+        unlink([tempPath fileSystemRepresentation]);
+        
+        if (error != NULL)
+            *error = [self compressionErrorForPath:path];
+        
+        return NO;
+    }
+    
+    gzbuffer(output, (unsigned)kCompressionChunkSize);
+    
+    // Streams the file through one chunk-sized buffer.
+    char * buffer = malloc(kCompressionChunkSize);
+    BOOL success = YES;
+    ssize_t length = 0;
+    
+    while ((length = read(input, buffer, kCompressionChunkSize)) != 0) {
+        
+        if (length < 0) {
+            
+            if (errno == EINTR)
+                continue;
+            
+            success = NO;
+            break;
+        }
+        
+        if (gzwrite(output, buffer, (unsigned)length) != length) {
+            success = NO;
+            break;
+        }
+    }
+    
+    free(buffer);
+    close(input);
+    
+    if (gzclose(output) != Z_OK)
+        success = NO;
+    
+    // Only replaces the original, and any earlier compressed file, once the new one is complete.
+    if (success)
+        success = rename([tempPath fileSystemRepresentation], [compressedPath fileSystemRepresentation]) == 0;
+    
+    if (!success) {
+        
+        unlink([tempPath fileSystemRepresentation]);
+        
+        if (error != NULL)
+            *error = [self compressionErrorForPath:path];
+        
+        return NO;
+    }
+    
+    unlink([path fileSystemRepresentation]);
+    
+    return YES;
+}
+
++ (BOOL)enumerateChunksOfFileAtPath:(NSString *)path 
+                         usingBlock:(void (^)(const void *, NSUInteger, BOOL *))block 
+                              error:(NSError **)error {
+    
+    // gzread() passes files that aren't gzipped through unchanged.
+    gzFile input = gzopen([path fileSystemRepresentation], "rb");
+    
+    if (!input) {
+        
+        if (error != NULL)
+            *error = [self compressionErrorForPath:path];
+        
+        return NO;
+    }
+    
+    gzbuffer(input, (unsigned)kCompressionChunkSize);
+    
+    char * buffer = malloc(kCompressionChunkSize);
+    BOOL stop = NO;
+    int length = 0;
+    
+    while (!stop && (length = gzread(input, buffer, (unsigned)kCompressionChunkSize)) > 0)
+        block(buffer, length, &stop);
+    
+    free(buffer);
+    gzclose(input);
+    
+    if (length < 0) {
+        
+        if (error != NULL)
+            *error = [self compressionErrorForPath:path];
+        
+        return NO;
+    }
+    
+    return YES;
+}
+
++ (NSString *)compressedPathForPath:(NSString *)path {
+    return [path stringByAppendingPathExtension:RBCompressedLogFileExtension];
+}
+
++ (NSError *)compressionErrorForPath:(NSString *)path {
+    
+    NSString * description = [NSString stringWithFormat:@"Log file %@ could not be compressed or decompressed.", [path lastPathComponent]];
+    NSDictionary * userInfo = [NSDictionary dictionaryWithObject:description forKey:NSLocalizedDescriptionKey];
+    
+    return [NSError errorWithDomain:RBErrorDomain code:RBLogFileCompressionError userInfo:userInfo];
+}
+
+@end
@@ -28,11 +28,17 @@
 
 
 /**
- * Creates all of the log files for RBLogger. -newLogFileWithPath: should be 
- * changed to use the log file of choice for the application. 
+ * Creates all of the log files for RBLogger. Set logFileClass, or change 
+ * -newLogFileWithPath:, to use the log file of choice for the application. 
  */
 @interface RBLogFileFactory : NSObject
 
+/**
+ * The class of the log files created. Must be RBBaseLogFile or a subclass, 
+ * such as RBExtendedLogFile (the default) or RBBinaryLogFile.
+ */
+@property (nonatomic, assign) Class logFileClass;
+
 /**
  * Returns an RBLogFile that has been implicitly retained by the caller.
  *
@@ -29,8 +29,19 @@
 
 @implementation RBLogFileFactory
 
+@synthesize logFileClass;
+
+- (id)init {
+    
+    if ((self = [super init])) {
+        [self setLogFileClass:[RBExtendedLogFile class]];
+    }
+    
+    return self;
+}
+
 - (id<RBLogFile>)newLogFileWithPath:(NSString *)path {
-    return [[RBExtendedLogFile alloc] initWithFilePath:path];
+    return [[[self logFileClass] alloc] initWithFilePath:path];
 }
 
 #pragma mark - Singleton methods
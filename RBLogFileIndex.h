@@ -0,0 +1,143 @@
+//
+// RBLogFileIndex.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogSegment.h"
+
+
+/**
+ * Keeps track of the log files in the log file directory, their sizes and the 
+ * times they cover, so the logger can enforce size limits, purge old files and 
+ * find the files for a time range without stat'ing the directory. The index is 
+ * saved to a small property list in the directory. When the index is created, 
+ * it is loaded from that file and checked against the directory listing; only 
+ * files missing from it are stat'ed. After that, the logger reports every 
+ * change. Not threadsafe; RBLogger only uses it on its loggerQueue.
+ */
+@interface RBLogFileIndex : NSObject
+
+/// The directory the index describes.
+@property (nonatomic, copy, readonly) NSString * directory;
+
+/// The total size of all the log files, in bytes.
+@property (nonatomic, assign, readonly) unsigned long long totalByteCount;
+
+/**
+ * Standard initializer. Loads the saved index, if any, and reconciles it with 
+ * the files in the given directory.
+ *
+ * @param directory The log file directory.
+ *
+ * @return self
+ */
+- (id)initWithDirectory:(NSString *)directory;
+
+/**
+ * Returns all of the segments, ordered from oldest to newest.
+ *
+ * @return An array of RBLogSegments.
+ */
+- (NSArray *)segments;
+
+/**
+ * Returns the oldest segment.
+ *
+ * @return The oldest segment, or nil if there are no log files.
+ */
+- (RBLogSegment *)oldestSegment;
+
+/**
+ * Returns the segment for the given log file name.
+ *
+ * @param fileName The name of the uncompressed log file.
+ *
+ * @return The segment, or nil if there is no such log file.
+ */
+- (RBLogSegment *)segmentWithFileName:(NSString *)fileName;
+
+/**
+ * Returns the newest segment of the given day.
+ *
+ * @param day The UTC day, formatted as yyyy-MM-dd.
+ *
+ * @return The segment, or nil if the day has no log files.
+ */
+- (RBLogSegment *)lastSegmentForDay:(NSString *)day;
+
+/**
+ * Records that the given number of bytes were written to a log file. Adds the 
+ * log file to the index if it isn't there already.
+ *
+ * @param count The number of bytes written.
+ * @param fileName The name of the uncompressed log file.
+ */
+- (void)addByteCount:(unsigned long long)count toSegmentWithFileName:(NSString *)fileName;
+
+/**
+ * Records that a log file was compressed. Does nothing if the log file isn't 
+ * in the index.
+ *
+ * @param byteCount The size of the compressed file.
+ * @param fileName The name of the uncompressed log file.
+ */
+- (void)setCompressedByteCount:(unsigned long long)byteCount forSegmentWithFileName:(NSString *)fileName;
+
+/**
+ * Records that messages logged between the given times were written to a log 
+ * file. Does nothing if the log file isn't in the index.
+ *
+ * @param first The time of the first message written.
+ * @param last The time of the last message written.
+ * @param fileName The name of the uncompressed log file.
+ */
+- (void)includeTimestampsFrom:(CFAbsoluteTime)first to:(CFAbsoluteTime)last inSegmentWithFileName:(NSString *)fileName;
+
+/**
+ * Returns the segments that may contain messages logged between the given 
+ * times. Costs a binary search plus the number of segments returned.
+ *
+ * @param start The absolute time of the start of the range.
+ * @param end The absolute time of the end of the range.
+ *
+ * @return An array of RBLogSegments, ordered from oldest to newest.
+ */
+- (NSArray *)segmentsFromTime:(CFAbsoluteTime)start toTime:(CFAbsoluteTime)end;
+
+/**
+ * Saves the index to the log file directory if it has changed since it was 
+ * last saved or loaded.
+ *
+ * @return YES if the index is saved, NO otherwise.
+ */
+- (BOOL)saveIfNeeded;
+
+/**
+ * Records that a log file was deleted.
+ *
+ * @param segment The segment of the deleted log file.
+ */
+- (void)removeSegment:(RBLogSegment *)segment;
+
+@end
@@ -0,0 +1,340 @@
+//
+// RBLogFileIndex.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogFileIndex.h"
+
+/// The name of the file the index is saved to.
+static NSString * const kIndexFileName = @"LogFileIndex.plist";
+
+
+@interface RBLogFileIndex ()
+
+@property (nonatomic, copy, readwrite) NSString * directory;
+@property (nonatomic, assign, readwrite) unsigned long long totalByteCount;
+
+/// The segments, always sorted from oldest to newest.
+@property (nonatomic, strong) NSMutableArray * sortedSegments;
+
+/// The segments keyed by the names of their uncompressed log files.
+@property (nonatomic, strong) NSMutableDictionary * segmentsByFileName;
+
+/// Whether the index has changed since it was last saved.
+@property (nonatomic, assign, getter=isDirty) BOOL dirty;
+
+/**
+ * Adds the given segment, keeping the segments sorted.
+ *
+ * @param segment The segment to add.
+ */
+- (void)insertSegment:(RBLogSegment *)segment;
+
+/**
+ * Loads the segments from the saved index.
+ *
+ * @return YES if a saved index was loaded, NO otherwise.
+ */
+- (BOOL)loadSavedIndex;
+
+/**
+ * Makes the index match the files in the directory. Only files that aren't 
+ * in the index are stat'ed.
+ */
+- (void)reconcileWithDirectory;
+
+/**
+ * Returns the path of the saved index.
+ *
+ * @return The path of the saved index.
+ */
+- (NSString *)indexPath;
+
+@end
+
+
+@implementation RBLogFileIndex
+
+@synthesize directory, totalByteCount, sortedSegments, segmentsByFileName, dirty;
+
+- (id)initWithDirectory:(NSString *)theDirectory {
+    
+    if ((self = [super init])) {
+        
+        [self setDirectory:theDirectory];
+        [self setSortedSegments:[NSMutableArray array]];
+        [self setSegmentsByFileName:[NSMutableDictionary dictionary]];
+        
+        if (![self loadSavedIndex])
+            [self setDirty:YES];
+        
+        [self reconcileWithDirectory];
+    }
+    
+    return self;
+}
+
+- (BOOL)loadSavedIndex {
+    
+    NSData * data = [NSData dataWithContentsOfFile:[self indexPath]];
+    
+    if (!data)
+        return NO;
+    
+    NSArray * propertyLists = [NSPropertyListSerialization propertyListWithData:data
+                                                                        options:NSPropertyListImmutable
+                                                                         format:NULL
+                                                                          error:NULL];
+    
+    if (![propertyLists isKindOfClass:[NSArray class]])
+        return NO;
+    
+    for (NSDictionary * propertyList in propertyLists) {
+        
+        RBLogSegment * segment = [RBLogSegment segmentWithPropertyList:propertyList];
+        
+        if (segment && ![self segmentWithFileName:[segment fileName]]) {
+            [self insertSegment:segment];
+            [self setTotalByteCount:[self totalByteCount] + [segment byteCount]];
+        }
+    }
+    
+    return YES;
+}
+
+- (void)reconcileWithDirectory {
+    
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    NSArray * files = [fileManager contentsOfDirectoryAtPath:[self directory] error:NULL];
+    NSMutableSet * foundFileNames = [NSMutableSet setWithCapacity:[files count]];
+    
+    for (NSString * file in files) {
+        
+        RBLogSegment * segment = [RBLogSegment segmentWithFileName:file];
+        
+        if (!segment)
+            continue;
+        
+        RBLogSegment * existing = [self segmentWithFileName:[segment fileName]];
+        
+        // Files the saved index already knows about aren't stat'ed again.
+        if (existing && [[existing diskFileName] isEqualToString:file]) {
+            [foundFileNames addObject:[segment fileName]];
+            continue;
+        }
+        
+        NSString * path = [[self directory] stringByAppendingPathComponent:file];
+        unsigned long long size = [[fileManager attributesOfItemAtPath:path error:NULL] fileSize];
+        
+        // A segment may have both a compressed and an uncompressed file.
+        if (existing && [foundFileNames containsObject:[segment fileName]]) {
+            [existing setByteCount:[existing byteCount] + size];
+            [existing setCompressed:NO];
+            [self setTotalByteCount:[self totalByteCount] + size];
+        }
+        else {
+            
+            if (existing)
+                [self removeSegment:existing];
+            
+            [segment setByteCount:size];
+            [self insertSegment:segment];
+            [self setTotalByteCount:[self totalByteCount] + size];
+        }
+        
+        [foundFileNames addObject:[segment fileName]];
+        [self setDirty:YES];
+    }
+    
+    // Forgets files that were deleted behind the index's back.
+    for (RBLogSegment * segment in [self segments]) {
+        
+        if (![foundFileNames containsObject:[segment fileName]])
+            [self removeSegment:segment];
+    }
+}
+
+- (NSArray *)segments {
+    return [[self sortedSegments] copy];
+}
+
+- (RBLogSegment *)oldestSegment {
+    
+    NSArray * segments = [self sortedSegments];
+    
+    return [segments count] > 0 ? [segments objectAtIndex:0] : nil;
+}
+
+- (RBLogSegment *)segmentWithFileName:(NSString *)fileName {
+    return [[self segmentsByFileName] objectForKey:fileName];
+}
+
+- (RBLogSegment *)lastSegmentForDay:(NSString *)day {
+    
+    // The newest segments are at the end, so this only walks back over one day.
+    for (RBLogSegment * segment in [[self sortedSegments] reverseObjectEnumerator]) {
+        
+        NSComparisonResult result = [[segment day] compare:day];
+        
+        if (result == NSOrderedSame)
+            return segment;
+        
+        if (result == NSOrderedAscending)
+            break;
+    }
+    
+    return nil;
+}
+
+- (void)addByteCount:(unsigned long long)count toSegmentWithFileName:(NSString *)fileName {
+    
+    RBLogSegment * segment = [self segmentWithFileName:fileName];
+    
+    if (!segment) {
+        
+        segment = [RBLogSegment segmentWithFileName:fileName];
+        
+        if (!segment)
+            return;
+        
+        [self insertSegment:segment];
+    }
+    
+    [segment setByteCount:[segment byteCount] + count];
+    [self setTotalByteCount:[self totalByteCount] + count];
+    [self setDirty:YES];
+}
+
+- (void)setCompressedByteCount:(unsigned long long)byteCount forSegmentWithFileName:(NSString *)fileName {
+    
+    RBLogSegment * segment = [self segmentWithFileName:fileName];
+    
+    if (!segment)
+        return;
+    
+    [self setTotalByteCount:[self totalByteCount] - [segment byteCount] + byteCount];
+    [segment setByteCount:byteCount];
+    [segment setCompressed:YES];
+    [self setDirty:YES];
+}
+
+- (void)includeTimestampsFrom:(CFAbsoluteTime)first to:(CFAbsoluteTime)last inSegmentWithFileName:(NSString *)fileName {
+    
+    [[self segmentWithFileName:fileName] includeTimestampsFrom:first to:last];
+    [self setDirty:YES];
+}
+
+- (NSArray *)segmentsFromTime:(CFAbsoluteTime)start toTime:(CFAbsoluteTime)end {
+    
+    NSArray * segments = [self sortedSegments];
+    NSUInteger low = 0;
+    NSUInteger high = [segments count];
+    
+    // Segments are sorted by day, so finds the first one that ends after the start.
+    while (low < high) {
+        
+        NSUInteger middle = low + (high - low) / 2;
+        
+        if ([[segments objectAtIndex:middle] endTime] < start)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    
+    NSMutableArray * matches = [NSMutableArray array];
+    
+    for (NSUInteger i = low; i < [segments count]; i++) {
+        
+        RBLogSegment * segment = [segments objectAtIndex:i];
+        
+        if ([segment startTime] > end)
+            break;
+        
+        if ([segment endTime] >= start)
+            [matches addObject:segment];
+    }
+    
+    return matches;
+}
+
+- (BOOL)saveIfNeeded {
+    
+    if (![self isDirty])
+        return YES;
+    
+    NSMutableArray * propertyLists = [NSMutableArray arrayWithCapacity:[[self sortedSegments] count]];
+    
+    for (RBLogSegment * segment in [self sortedSegments])
+        [propertyLists addObject:[segment propertyList]];
+    
+    NSData * data = [NSPropertyListSerialization dataWithPropertyList:propertyLists
+                                                               format:NSPropertyListBinaryFormat_v1_0
+                                                              options:0
+                                                                error:NULL];
+    
+    if (![data writeToFile:[self indexPath] atomically:YES])
+        return NO;
+    
+    [self setDirty:NO];
+    
+    return YES;
+}
+
+- (void)removeSegment:(RBLogSegment *)segment {
+    
+    RBLogSegment * existing = [self segmentWithFileName:[segment fileName]];
+    
+    if (!existing)
+        return;
+    
+    [self setTotalByteCount:[self totalByteCount] - [existing byteCount]];
+    [[self sortedSegments] removeObjectIdenticalTo:existing];
+    [[self segmentsByFileName] removeObjectForKey:[existing fileName]];
+    [self setDirty:YES];
+}
+
+- (void)insertSegment:(RBLogSegment *)segment {
+    
+    NSMutableArray * segments = [self sortedSegments];
+    
+    // New segments are almost always the newest, so checks the end first.
+    NSUInteger index = [segments count];
+    
+    if (index > 0 && [[segments lastObject] compare:segment] == NSOrderedDescending) {
+        
+        index = [segments indexOfObject:segment
+                          inSortedRange:NSMakeRange(0, [segments count])
+                                options:NSBinarySearchingInsertionIndex
+                        usingComparator:^NSComparisonResult(id obj1, id obj2) {
+                            return [obj1 compare:obj2];
+                        }];
+    }
+    
+    [segments insertObject:segment atIndex:index];
+    [[self segmentsByFileName] setObject:segment forKey:[segment fileName]];
+}
+
+- (NSString *)indexPath {
+    return [[self directory] stringByAppendingPathComponent:kIndexFileName];
+}
+
+@end
@@ -0,0 +1,125 @@
+//
+// RBLogLevel.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <stdatomic.h>
+
+
+/// Level values usable in preprocessor conditions. See RBLogLevel.
+#define RB_LOG_LEVEL_UNKNOWN -1
+#define RB_LOG_LEVEL_TRACE 0
+#define RB_LOG_LEVEL_DEBUG 1
+#define RB_LOG_LEVEL_INFO  2
+#define RB_LOG_LEVEL_WARN  3
+#define RB_LOG_LEVEL_ERROR 4
+#define RB_LOG_LEVEL_FAULT 5
+
+/**
+ * The lowest level compiled into the app. Logging macros below this level 
+ * compile to nothing. Defaults to RB_LOG_LEVEL_TRACE when DEBUG is defined 
+ * and RB_LOG_LEVEL_INFO otherwise. Define it in the project settings to 
+ * change it.
+ */
+#ifndef RB_LOG_LEVEL_FLOOR
+#if DEBUG
+#define RB_LOG_LEVEL_FLOOR RB_LOG_LEVEL_TRACE
+#else
+#define RB_LOG_LEVEL_FLOOR RB_LOG_LEVEL_INFO
+#endif
+#endif
+
+
+/**
+ * How severe a log message is.
+ */
+typedef enum {
+    
+    /// The level wasn't stored, as in records read back from extended log 
+    /// files. Never logged at.
+    RBLogLevelUnknown = RB_LOG_LEVEL_UNKNOWN,
+    
+    /// Step-by-step detail, only useful while tracking down a bug.
+    RBLogLevelTrace = RB_LOG_LEVEL_TRACE,
+    
+    /// Detail useful while debugging.
+    RBLogLevelDebug = RB_LOG_LEVEL_DEBUG,
+    
+    /// Normal events worth keeping in the log.
+    RBLogLevelInfo = RB_LOG_LEVEL_INFO,
+    
+    /// Something unexpected that the app recovered from.
+    RBLogLevelWarn = RB_LOG_LEVEL_WARN,
+    
+    /// An operation failed.
+    RBLogLevelError = RB_LOG_LEVEL_ERROR,
+    
+    /// A bug or a failure the app can't recover from.
+    RBLogLevelFault = RB_LOG_LEVEL_FAULT,
+    
+} RBLogLevel;
+
+
+/**
+ * The runtime threshold. Use RBLogLevelIsEnabled() and RBSetLogLevelThreshold() 
+ * rather than touching it directly.
+ */
+extern _Atomic(int) RBLogLevelThresholdStorage;
+
+/**
+ * Returns whether messages at the given level are logged. This is a single 
+ * relaxed atomic load, so it is cheap enough to check before building a 
+ * message. Threadsafe.
+ *
+ * @param level The level to check.
+ *
+ * @return YES if the level is at or above the runtime threshold.
+ */
+static inline BOOL RBLogLevelIsEnabled(RBLogLevel level) {
+    return (int)level >= atomic_load_explicit(&RBLogLevelThresholdStorage, memory_order_relaxed);
+}
+
+/**
+ * Sets the lowest level that is logged. Defaults to RB_LOG_LEVEL_FLOOR. 
+ * Threadsafe.
+ *
+ * @param level The new threshold.
+ */
+void RBSetLogLevelThreshold(RBLogLevel level);
+
+/**
+ * Returns the lowest level that is logged. Threadsafe.
+ *
+ * @return The current threshold.
+ */
+RBLogLevel RBLogLevelThreshold(void);
+
+/**
+ * Returns a short upper case name for the given level, such as "WARN". 
+ * RBLogLevelUnknown is "UNKNOWN".
+ *
+ * @param level The level.
+ *
+ * @return The name of the level.
+ */
+NSString * RBNameOfLogLevel(RBLogLevel level);
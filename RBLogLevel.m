@@ -0,0 +1,52 @@
+//
+// RBLogLevel.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogLevel.h"
+
+
+_Atomic(int) RBLogLevelThresholdStorage = RB_LOG_LEVEL_FLOOR;
+
+
+void RBSetLogLevelThreshold(RBLogLevel level) {
+    atomic_store_explicit(&RBLogLevelThresholdStorage, (int)level, memory_order_relaxed);
+}
+
+RBLogLevel RBLogLevelThreshold(void) {
+    return (RBLogLevel)atomic_load_explicit(&RBLogLevelThresholdStorage, memory_order_relaxed);
+}
+
+NSString * RBNameOfLogLevel(RBLogLevel level) {
+    
+    switch (level) {
+        case RBLogLevelUnknown: return @"UNKNOWN";
+        case RBLogLevelTrace: return @"TRACE";
+        case RBLogLevelDebug: return @"DEBUG";
+        case RBLogLevelInfo:  return @"INFO";
+        case RBLogLevelWarn:  return @"WARN";
+        case RBLogLevelError: return @"ERROR";
+        case RBLogLevelFault: return @"FAULT";
+    }
+    
+    return @"INFO";
+}
@@ -0,0 +1,107 @@
+//
+// RBLogMergeReader.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@class RBLogger;
+@class RBLogRecord;
+
+
+/**
+ * Reads the log files of several loggers as one log. Each logger's records 
+ * in a time range are read with RBLogQuery, and the loggers' records are 
+ * interleaved by timestamp, so a report shows what every subsystem was doing 
+ * at the same moment. Threads can enqueue messages slightly out of time 
+ * order, so each logger's records are sorted first. The sorts are stable and 
+ * records with the same timestamp keep the order of the loggers. If a record 
+ * refers to an exception stack written in full before the range, the record 
+ * with the full stack is read too and comes first.
+ *
+ * Each logger's pending messages are written first, so none of the methods 
+ * may be called from a loggerQueue.
+ */
+@interface RBLogMergeReader : NSObject
+
+/// The loggers read, in the order ties are broken.
+@property (nonatomic, copy, readonly) NSArray * loggers;
+
+/**
+ * Standard initializer.
+ *
+ * @param loggers The RBLoggers to read.
+ *
+ * @return self
+ */
+- (id)initWithLoggers:(NSArray *)loggers;
+
+/**
+ * Calls the given block with each record logged in the range by any of the 
+ * loggers, oldest first.
+ *
+ * @param startDate The start of the range.
+ * @param endDate The end of the range.
+ * @param block Called with each record and its logger. Set stop to YES to 
+ * stop reading.
+ * @param error An error is returned by reference if a file can't be read.
+ *
+ * @return YES if the files were read, NO otherwise.
+ */
+- (BOOL)enumerateRecordsFromDate:(NSDate *)startDate 
+                          toDate:(NSDate *)endDate 
+                      usingBlock:(void (^)(RBLogger * logger, RBLogRecord * record, BOOL * stop))block 
+                           error:(NSError **)error;
+
+/**
+ * Returns the records logged in the range by any of the loggers, oldest first.
+ *
+ * @param startDate The start of the range.
+ * @param endDate The end of the range.
+ * @param error An error is returned by reference if a file can't be read.
+ *
+ * @return An array of RBLogRecords, or nil if a file can't be read.
+ */
+- (NSArray *)recordsFromDate:(NSDate *)startDate toDate:(NSDate *)endDate error:(NSError **)error;
+
+/**
+ * Returns the records logged in the range as UTF-8 lines of the form 
+ * "2011-06-02 14:03:07.512 Network WARN message", oldest first. Times are UTC, 
+ * and only have milliseconds if the file they were read from stores them. 
+ * Extended log files don't store levels, so their lines show UNKNOWN.
+ *
+ * @param startDate The start of the range.
+ * @param endDate The end of the range.
+ * @param error An error is returned by reference if a file can't be read.
+ *
+ * @return The lines, or nil if a file can't be read.
+ */
+- (NSData *)linesFromDate:(NSDate *)startDate toDate:(NSDate *)endDate error:(NSError **)error;
+
+/**
+ * Returns a reader for every logger created so far.
+ *
+ * @return A reader.
+ */
++ (RBLogMergeReader *)readerForAllLoggers;
+
+@end
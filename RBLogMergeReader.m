@@ -0,0 +1,281 @@
+//
+// RBLogMergeReader.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <float.h>
+#import <math.h>
+#import <stdlib.h>
+
+#import "RBLogMergeReader.h"
+#import "RBLogger.h"
+#import "RBLogRecord.h"
+#import "RBLogQuery.h"
+#import "RBStackRenderer.h"
+#import "RBTimestampEncoder.h"
+
+/// The seconds in a day.
+static const NSTimeInterval kSecondsPerDay = 86400.0;
+
+
+@interface RBLogMergeReader ()
+
+@property (nonatomic, copy, readwrite) NSArray * loggers;
+
+/**
+ * Returns the records of log files, before a start time, that write out in 
+ * full the exception stacks the given records only refer to by ID. The 
+ * logger writes each stack in full earlier in the same file, but that may be 
+ * before the range read.
+ *
+ * @param records One logger's records in the range, in time order.
+ * @param paths The paths of the files they were read from.
+ * @param start The absolute time the range starts at.
+ * @param error An error is returned by reference if a file can't be read.
+ *
+ * @return The records, oldest first, or nil if a file can't be read.
+ */
+- (NSArray *)recordsWithStacksReferencedInRecords:(NSArray *)records 
+                                logFilesAtPaths:(NSArray *)paths 
+                                      startTime:(CFAbsoluteTime)start 
+                                          error:(NSError **)error;
+
+@end
+
+
+@implementation RBLogMergeReader
+
+@synthesize loggers;
+
+- (id)init {
+    return [self initWithLoggers:[NSArray array]];
+}
+
+- (id)initWithLoggers:(NSArray *)theLoggers {
+    
+    if ((self = [super init])) {
+        [self setLoggers:theLoggers];
+    }
+    
+    return self;
+}
+
+- (BOOL)enumerateRecordsFromDate:(NSDate *)startDate 
+                          toDate:(NSDate *)endDate 
+                      usingBlock:(void (^)(RBLogger * logger, RBLogRecord * record, BOOL * stop))block 
+                           error:(NSError **)error {
+    
+    NSArray * theLoggers = [self loggers];
+    NSUInteger loggerCount = [theLoggers count];
+    NSMutableArray * recordLists = [NSMutableArray arrayWithCapacity:loggerCount];
+    RBLogQuery * query = [[RBLogQuery alloc] initWithStartTime:[startDate timeIntervalSinceReferenceDate]
+                                                       endTime:[endDate timeIntervalSinceReferenceDate]];
+    
+    NSComparator byTimestamp = ^NSComparisonResult(RBLogRecord * first, RBLogRecord * second) {
+        
+        if ([first timestamp] < [second timestamp])
+            return NSOrderedAscending;
+        
+        return [first timestamp] > [second timestamp] ? NSOrderedDescending : NSOrderedSame;
+    };
+    
+    for (RBLogger * logger in theLoggers) {
+        
+        NSArray * paths = [logger logFilePathsFromDate:startDate toDate:endDate];
+        NSArray * records = [query recordsInLogFilesAtPaths:paths error:error];
+        
+        if (!records)
+            return NO;
+        
+        NSArray * stackRecords = [self recordsWithStacksReferencedInRecords:records 
+                                                            logFilesAtPaths:paths 
+                                                                  startTime:[query startTime] 
+                                                                      error:error];
+        
+        if (!stackRecords)
+            return NO;
+        
+        // Threads can enqueue messages slightly out of time order, so each list is 
+        // sorted. The sort is stable, so records logged at the same time keep the 
+        // order they were written in.
+        NSArray * list = [stackRecords arrayByAddingObjectsFromArray:records];
+        [recordLists addObject:[list sortedArrayWithOptions:NSSortStable usingComparator:byTimestamp]];
+    }
+    
+    // A k-way merge of the sorted lists. There are only ever a few loggers, so 
+    // a linear scan for the oldest head beats a heap.
+    NSUInteger * positions = calloc(MAX(loggerCount, (NSUInteger)1), sizeof(NSUInteger));
+    BOOL stop = NO;
+    
+    while (!stop) {
+        
+        RBLogRecord * oldest = nil;
+        NSUInteger oldestList = 0;
+        
+        for (NSUInteger i = 0; i < loggerCount; i++) {
+            
+            NSArray * records = [recordLists objectAtIndex:i];
+            
+            if (positions[i] >= [records count])
+                continue;
+            
+            RBLogRecord * head = [records objectAtIndex:positions[i]];
+            
+            if (!oldest || [head timestamp] < [oldest timestamp]) {
+                oldest = head;
+                oldestList = i;
+            }
+        }
+        
+        if (!oldest)
+            break;
+        
+        positions[oldestList]++;
+        block([theLoggers objectAtIndex:oldestList], oldest, &stop);
+    }
+    
+    free(positions);
+    
+    return YES;
+}
+
+- (NSArray *)recordsFromDate:(NSDate *)startDate toDate:(NSDate *)endDate error:(NSError **)error {
+    
+    NSMutableArray * merged = [NSMutableArray array];
+    BOOL success = [self enumerateRecordsFromDate:startDate 
+                                           toDate:endDate 
+                                       usingBlock:^(RBLogger * logger, RBLogRecord * record, BOOL * stop) {
+                                           [merged addObject:record];
+                                       } 
+                                            error:error];
+    
+    return success ? merged : nil;
+}
+
+- (NSData *)linesFromDate:(NSDate *)startDate toDate:(NSDate *)endDate error:(NSError **)error {
+    
+    NSMutableData * lines = [NSMutableData data];
+    RBTimestampEncoder * encoder = [RBTimestampEncoder new];
+    NSDateFormatter * dayFormatter = [NSDateFormatter new];
+    __block double lastDay = -1.0;
+    __block NSData * dayBytes = nil;
+    
+    [dayFormatter setDateFormat:@"yyyy-MM-dd"];
+    [dayFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+    [dayFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"]];
+    
+    BOOL success = [self enumerateRecordsFromDate:startDate 
+                                           toDate:endDate 
+                                       usingBlock:^(RBLogger * logger, RBLogRecord * record, BOOL * stop) {
+                                           
+        // The day only changes at midnight, so it is formatted once per day.
+        double day = floor([record timestamp] / kSecondsPerDay);
+        
+        if (day != lastDay) {
+            NSDate * date = [NSDate dateWithTimeIntervalSinceReferenceDate:[record timestamp]];
+            dayBytes = [[dayFormatter stringFromDate:date] dataUsingEncoding:NSUTF8StringEncoding];
+            lastDay = day;
+        }
+        
+        // Files written at the default precision only store whole seconds, so 
+        // those times are written without a fraction rather than with a made-up one.
+        BOOL wholeSecond = [record timestamp] == floor([record timestamp]);
+        [encoder setPrecision:wholeSecond ? RBTimestampPrecisionSeconds : RBTimestampPrecisionMilliseconds];
+        
+        char time[RB_TIMESTAMP_MAX_LENGTH];
+        NSUInteger timeLength = [encoder encodeTime:[record timestamp] intoBuffer:time];
+        NSString * prefix = [NSString stringWithFormat:@" %@ %@ ", [logger name], RBNameOfLogLevel([record level])];
+        
+        [lines appendData:dayBytes];
+        [lines appendBytes:" " length:1];
+        [lines appendBytes:time length:timeLength];
+        [lines appendData:[prefix dataUsingEncoding:NSUTF8StringEncoding]];
+        [lines appendData:[[record message] dataUsingEncoding:NSUTF8StringEncoding]];
+        [lines appendBytes:"\n" length:1];
+    } 
+                                            error:error];
+    
+    return success ? lines : nil;
+}
+
+- (NSArray *)recordsWithStacksReferencedInRecords:(NSArray *)records 
+                                logFilesAtPaths:(NSArray *)paths 
+                                      startTime:(CFAbsoluteTime)start 
+                                          error:(NSError **)error {
+    
+    NSMutableSet * writtenStacks = [NSMutableSet set];
+    NSMutableSet * missingStacks = [NSMutableSet set];
+    
+    for (RBLogRecord * record in records) {
+        
+        NSString * stackID = [RBStackRenderer stackIDOfDescription:[record message]];
+        
+        if (stackID) {
+            [writtenStacks addObject:stackID];
+            continue;
+        }
+        
+        stackID = [RBStackRenderer referencedStackIDOfDescription:[record message]];
+        
+        if (stackID && ![writtenStacks containsObject:stackID])
+            [missingStacks addObject:stackID];
+    }
+    
+    NSMutableArray * found = [NSMutableArray array];
+    
+    if ([missingStacks count] == 0)
+        return found;
+    
+    // Everything before the range, as far back as the files go.
+    RBLogQuery * earlier = [[RBLogQuery alloc] initWithStartTime:-DBL_MAX endTime:start];
+    
+    for (NSString * path in paths) {
+        
+        BOOL success = [earlier enumerateRecordsInLogFileAtPath:path usingBlock:^(RBLogRecord * record, BOOL * stop) {
+            
+            NSString * stackID = [RBStackRenderer stackIDOfDescription:[record message]];
+            
+            // Records exactly at the start are already in the range.
+            if ([record timestamp] >= start || !stackID || ![missingStacks containsObject:stackID])
+                return;
+            
+            [found addObject:record];
+            [missingStacks removeObject:stackID];
+            *stop = [missingStacks count] == 0;
+        } 
+                                                          error:error];
+        
+        if (!success)
+            return nil;
+        
+        if ([missingStacks count] == 0)
+            break;
+    }
+    
+    return found;
+}
+
++ (RBLogMergeReader *)readerForAllLoggers {
+    return [[self alloc] initWithLoggers:[RBLogger allLoggers]];
+}
+
+@end
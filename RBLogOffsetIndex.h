@@ -0,0 +1,120 @@
+//
+// RBLogOffsetIndex.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+/// The extension added to a log file's path to name its offset index.
+extern NSString * const RBLogOffsetIndexExtension;
+
+
+/**
+ * A sparse index of a text log file, kept in a small sidecar file next to it. 
+ * Every kOffsetIndexInterval bytes of log, an entry records the offset of a 
+ * line and the latest time of any line before it, so a reader can seek close 
+ * to a time instead of scanning the file from the start. Entries are added as 
+ * the log file is written and only reach the sidecar after the lines they 
+ * point to have reached the log file. Not threadsafe; RBLogger only writes it 
+ * on its loggerQueue.
+ */
+@interface RBLogOffsetIndex : NSObject
+
+/**
+ * The path of the log file the index describes.
+ */
+@property (nonatomic, copy, readonly) NSString * logFilePath;
+
+/**
+ * Standard initializer. The sidecar isn't touched until the first record is 
+ * noted.
+ *
+ * @param path The path of the log file.
+ *
+ * @return self
+ */
+- (id)initWithLogFilePath:(NSString *)path;
+
+/**
+ * Notes that a record with the given time starts at the given offset of the 
+ * log file. Adds an entry when the offset is far enough past the last one.
+ *
+ * @param timestamp The time the record was logged.
+ * @param offset The offset of the record's line in the log file.
+ */
+- (void)noteRecordWithTimestamp:(CFAbsoluteTime)timestamp atOffset:(unsigned long long)offset;
+
+/**
+ * Appends any new entries to the sidecar. Should only be called once the log 
+ * file has been flushed.
+ *
+ * @param error An error is returned by reference if the entries can't be 
+ * written.
+ *
+ * @return YES if the entries were written, NO otherwise.
+ */
+- (BOOL)flush:(NSError **)error;
+
+/**
+ * Closes the sidecar. Entries that haven't been flushed are discarded.
+ */
+- (void)close;
+
+/**
+ * Deletes the sidecar and forgets all entries. Used when the log file is 
+ * created, so a stale index never describes a new file.
+ */
+- (void)reset;
+
+/**
+ * Returns an offset in the given log file from which every line logged at or 
+ * after the given time can be found. Costs one read of the sidecar and a 
+ * binary search.
+ *
+ * @param time The absolute time to seek to.
+ * @param path The path of the log file.
+ *
+ * @return The offset to start reading from. 0 if the file has no index.
+ */
++ (unsigned long long)offsetBeforeTime:(CFAbsoluteTime)time forLogFileAtPath:(NSString *)path;
+
+/**
+ * Returns the offsets of the lines in the given log file's index. Each one is 
+ * the start of a line, so they are safe places to split the file.
+ *
+ * @param path The path of the log file.
+ *
+ * @return An array of NSNumbers, in increasing order. Empty if the file has no 
+ * index.
+ */
++ (NSArray *)lineOffsetsForLogFileAtPath:(NSString *)path;
+
+/**
+ * Returns the path of the sidecar for the given log file.
+ *
+ * @param path The path of the log file.
+ *
+ * @return The path of the sidecar.
+ */
++ (NSString *)indexPathForLogFilePath:(NSString *)path;
+
+@end
@@ -0,0 +1,247 @@
+//
+// RBLogOffsetIndex.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogOffsetIndex.h"
+
+#import <fcntl.h>
+#import <float.h>
+#import <unistd.h>
+
+NSString * const RBLogOffsetIndexExtension = @"idx";
+
+/// The number of log bytes between index entries.
+static const unsigned long long kOffsetIndexInterval = 64 * 1024;
+
+/**
+ * An entry in the sidecar. Written in the device's byte order, since log files 
+ * are only read on the device that wrote them or after being decoded there.
+ */
+typedef struct {
+    
+    /// The latest time of any line before the offset.
+    CFAbsoluteTime maxTimestampBefore;
+    
+    /// The offset of a line in the log file.
+    uint64_t offset;
+    
+} RBLogOffsetIndexEntry;
+
+
+@interface RBLogOffsetIndex () {
+    
+    /// The descriptor of the open sidecar, or -1.
+    int fileDescriptor;
+    
+    /// Whether the state of an existing sidecar has been loaded.
+    BOOL loaded;
+    
+    /// The offset at or after which the next entry is added.
+    unsigned long long nextEntryOffset;
+    
+    /// The latest time of any record noted so far.
+    CFAbsoluteTime maxTimestamp;
+}
+
+@property (nonatomic, copy, readwrite) NSString * logFilePath;
+
+/**
+ * Entries that haven't been written to the sidecar yet.
+ */
+@property (nonatomic, strong) NSMutableData * pendingEntries;
+
+/**
+ * Continues from the last entry of an existing sidecar, if there is one.
+ */
+- (void)loadState;
+
+@end
+
+
+@implementation RBLogOffsetIndex
+
+@synthesize logFilePath, pendingEntries;
+
+- (id)initWithLogFilePath:(NSString *)path {
+    
+    if ((self = [super init])) {
+        
+        [self setLogFilePath:path];
+        [self setPendingEntries:[NSMutableData data]];
+        fileDescriptor = -1;
+        nextEntryOffset = kOffsetIndexInterval;
+        maxTimestamp = -DBL_MAX;
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self close];
+}
+
+- (void)noteRecordWithTimestamp:(CFAbsoluteTime)timestamp atOffset:(unsigned long long)offset {
+    
+    if (!loaded)
+        [self loadState];
+    
+    if (offset >= nextEntryOffset) {
+        
+        RBLogOffsetIndexEntry entry = { maxTimestamp, offset };
+        
+        [[self pendingEntries] appendBytes:&entry length:sizeof(entry)];
+        nextEntryOffset = offset + kOffsetIndexInterval;
+    }
+    
+    // A running maximum keeps the entries sorted even if a few records are out of order.
+    if (timestamp > maxTimestamp)
+        maxTimestamp = timestamp;
+}
+
+- (BOOL)flush:(NSError **)error {
+    
+    NSMutableData * entries = [self pendingEntries];
+    
+    if ([entries length] == 0)
+        return YES;
+    
+    if (fileDescriptor < 0) {
+        
+        NSString * path = [[self class] indexPathForLogFilePath:[self logFilePath]];
+        fileDescriptor = open([path fileSystemRepresentation], O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        
+        if (fileDescriptor < 0) {
+            
+            if (error != NULL)
+                *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            
+            return NO;
+        }
+    }
+    
+    // Entries are small, so they either go out in one write or are retried whole.
+    ssize_t written = 0;
+    
+    do {
+        written = write(fileDescriptor, [entries bytes], [entries length]);
+    } while (written < 0 && errno == EINTR);
+    
+    if (written != (ssize_t)[entries length]) {
+        
+        if (error != NULL)
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:(written < 0 ? errno : EIO) userInfo:nil];
+        
+        return NO;
+    }
+    
+    [entries setLength:0];
+    
+    return YES;
+}
+
+- (void)close {
+    
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+}
+
+- (void)reset {
+    
+    [self close];
+    [[self pendingEntries] setLength:0];
+    unlink([[[self class] indexPathForLogFilePath:[self logFilePath]] fileSystemRepresentation]);
+    
+    loaded = YES;
+    nextEntryOffset = kOffsetIndexInterval;
+    maxTimestamp = -DBL_MAX;
+}
+
+- (void)loadState {
+    
+    loaded = YES;
+    
+    NSString * path = [[self class] indexPathForLogFilePath:[self logFilePath]];
+    int input = open([path fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+    
+    if (input < 0)
+        return;
+    
+    // Only the last whole entry is needed.
+    off_t end = lseek(input, 0, SEEK_END);
+    off_t last = end - end % (off_t)sizeof(RBLogOffsetIndexEntry) - (off_t)sizeof(RBLogOffsetIndexEntry);
+    RBLogOffsetIndexEntry entry;
+    
+    if (last >= 0 && pread(input, &entry, sizeof(entry), last) == sizeof(entry)) {
+        nextEntryOffset = entry.offset + kOffsetIndexInterval;
+        maxTimestamp = entry.maxTimestampBefore;
+    }
+    
+    close(input);
+}
+
++ (unsigned long long)offsetBeforeTime:(CFAbsoluteTime)time forLogFileAtPath:(NSString *)path {
+    
+    NSData * data = [NSData dataWithContentsOfFile:[self indexPathForLogFilePath:path] 
+                                           options:NSDataReadingMappedIfSafe 
+                                             error:NULL];
+    const RBLogOffsetIndexEntry * entries = [data bytes];
+    NSUInteger low = 0;
+    NSUInteger high = [data length] / sizeof(RBLogOffsetIndexEntry);
+    
+    // Finds the first entry with a line at or after the time somewhere before it.
+    while (low < high) {
+        
+        NSUInteger middle = low + (high - low) / 2;
+        
+        if (entries[middle].maxTimestampBefore < time)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    
+    // Everything before the entry preceding that one was logged before the time.
+    return low > 0 ? entries[low - 1].offset : 0;
+}
+
++ (NSArray *)lineOffsetsForLogFileAtPath:(NSString *)path {
+    
+    NSData * data = [NSData dataWithContentsOfFile:[self indexPathForLogFilePath:path] 
+                                           options:NSDataReadingMappedIfSafe 
+                                             error:NULL];
+    const RBLogOffsetIndexEntry * entries = [data bytes];
+    NSUInteger count = [data length] / sizeof(RBLogOffsetIndexEntry);
+    NSMutableArray * offsets = [NSMutableArray arrayWithCapacity:count];
+    
+    for (NSUInteger i = 0; i < count; i++)
+        [offsets addObject:[NSNumber numberWithUnsignedLongLong:entries[i].offset]];
+    
+    return offsets;
+}
+
++ (NSString *)indexPathForLogFilePath:(NSString *)path {
+    return [path stringByAppendingPathExtension:RBLogOffsetIndexExtension];
+}
+
+@end
@@ -0,0 +1,87 @@
+//
+// RBLogQuery.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogRecord.h"
+
+
+/**
+ * Reads the records logged between two times out of log files. Extended log 
+ * files are read with RBExtendedLogReader from the offset their 
+ * RBLogOffsetIndex gives for the start time, and reading stops at the first 
+ * line more than a second after the end time, so a query costs about one 
+ * index lookup plus the bytes it returns. Records can be written slightly 
+ * out of time order, and the second lets those logged just before the end 
+ * still be found. Compressed files are decompressed into memory first, but 
+ * lines before the indexed offset aren't parsed. Binary log files are decoded 
+ * and filtered.
+ *
+ * Extended log files only store the time of day, to the precision of the 
+ * logger's timePrecision. The day comes from the file's name, so the files 
+ * must be named like the logger names them.
+ */
+@interface RBLogQuery : NSObject
+
+/// The absolute time of the start of the range.
+@property (nonatomic, assign, readonly) CFAbsoluteTime startTime;
+
+/// The absolute time of the end of the range.
+@property (nonatomic, assign, readonly) CFAbsoluteTime endTime;
+
+/**
+ * Standard initializer.
+ *
+ * @param start The absolute time of the start of the range, inclusive.
+ * @param end The absolute time of the end of the range, inclusive.
+ *
+ * @return self
+ */
+- (id)initWithStartTime:(CFAbsoluteTime)start endTime:(CFAbsoluteTime)end;
+
+/**
+ * Calls the given block with each record in the range from the given log 
+ * file, in the order they were written.
+ *
+ * @param path The path of the log file. May be compressed.
+ * @param block Called with each record. Set stop to YES to stop reading.
+ * @param error An error is returned by reference if the file can't be read.
+ *
+ * @return YES if the file was read, NO otherwise.
+ */
+- (BOOL)enumerateRecordsInLogFileAtPath:(NSString *)path 
+                             usingBlock:(void (^)(RBLogRecord * record, BOOL * stop))block 
+                                  error:(NSError **)error;
+
+/**
+ * Returns the records in the range from the given log files.
+ *
+ * @param paths The paths of the log files, from oldest to newest.
+ * @param error An error is returned by reference if a file can't be read.
+ *
+ * @return An array of RBLogRecords, or nil if a file can't be read.
+ */
+- (NSArray *)recordsInLogFilesAtPaths:(NSArray *)paths error:(NSError **)error;
+
+@end
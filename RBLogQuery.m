@@ -0,0 +1,156 @@
+//
+// RBLogQuery.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogQuery.h"
+#import "RBLogOffsetIndex.h"
+#import "RBLogFileCompressor.h"
+#import "RBBinaryLogDecoder.h"
+#import "RBExtendedLogReader.h"
+
+/// The seconds a record can be written after later ones. Threads timestamp 
+/// records before they enqueue them, so records race each other into the queue.
+static const CFTimeInterval kOutOfOrderSlack = 1.0;
+
+
+@interface RBLogQuery ()
+
+@property (nonatomic, assign, readwrite) CFAbsoluteTime startTime;
+@property (nonatomic, assign, readwrite) CFAbsoluteTime endTime;
+
+/**
+ * Decodes a binary log file and passes the records in the range to the block.
+ *
+ * @param contents The contents of the file.
+ * @param block Called with each record in the range.
+ * @param error An error is returned by reference if the file can't be decoded.
+ *
+ * @return YES if the file was decoded, NO otherwise.
+ */
+- (BOOL)enumerateBinaryRecordsInData:(NSData *)contents 
+                          usingBlock:(void (^)(RBLogRecord * record, BOOL * stop))block 
+                               error:(NSError **)error;
+
+@end
+
+
+@implementation RBLogQuery
+
+@synthesize startTime, endTime;
+
+- (id)initWithStartTime:(CFAbsoluteTime)start endTime:(CFAbsoluteTime)end {
+    
+    if ((self = [super init])) {
+        [self setStartTime:start];
+        [self setEndTime:end];
+    }
+    
+    return self;
+}
+
+- (NSArray *)recordsInLogFilesAtPaths:(NSArray *)paths error:(NSError **)error {
+    
+    NSMutableArray * records = [NSMutableArray array];
+    
+    for (NSString * path in paths) {
+        
+        BOOL success = [self enumerateRecordsInLogFileAtPath:path usingBlock:^(RBLogRecord * record, BOOL * stop) {
+            [records addObject:record];
+        } error:error];
+        
+        if (!success)
+            return nil;
+    }
+    
+    return records;
+}
+
+- (BOOL)enumerateRecordsInLogFileAtPath:(NSString *)path 
+                             usingBlock:(void (^)(RBLogRecord *, BOOL *))block 
+                                  error:(NSError **)error {
+    
+    NSString * readPath = [RBExtendedLogReader readablePathForLogFilePath:path];
+    
+    // Nothing to read if the file was purged.
+    if (!readPath)
+        return YES;
+    
+    NSData * contents = [RBExtendedLogReader contentsOfLogFileAtPath:readPath error:error];
+    
+    if (!contents)
+        return NO;
+    
+    if ([RBBinaryLogDecoder isBinaryLogData:contents])
+        return [self enumerateBinaryRecordsInData:contents usingBlock:block error:error];
+    
+    // The offset index describes the plain file, which a compressed file decompresses to.
+    NSString * plainPath = readPath;
+    
+    if ([[readPath pathExtension] isEqualToString:RBCompressedLogFileExtension])
+        plainPath = [readPath stringByDeletingPathExtension];
+    
+    RBExtendedLogReader * reader = [[RBExtendedLogReader alloc] initWithData:contents 
+                                                                    dayStart:[RBExtendedLogReader dayStartForLogFilePath:readPath]];
+    unsigned long long offset = [RBLogOffsetIndex offsetBeforeTime:[self startTime] forLogFileAtPath:plainPath];
+    CFAbsoluteTime start = [self startTime];
+    CFAbsoluteTime end = [self endTime];
+    CFAbsoluteTime stopTime = end + kOutOfOrderSlack;
+    
+    [reader enumerateLinesFromOffset:(NSUInteger)MIN(offset, (unsigned long long)[contents length]) 
+                            toOffset:[contents length] 
+                          usingBlock:^(const RBExtendedLogLine * line, NSUInteger lineOffset, BOOL * stop) {
+                              
+                              CFAbsoluteTime timestamp = [reader timestampOfLine:line];
+                              
+                              // A line just past the end may be followed by one logged 
+                              // in the range, so reading only stops once lines are past 
+                              // the end by more than records can be out of order.
+                              if (timestamp > stopTime)
+                                  *stop = YES;
+                              else if (timestamp >= start && timestamp <= end)
+                                  block([reader recordForLine:line], stop);
+                          }];
+    
+    return YES;
+}
+
+- (BOOL)enumerateBinaryRecordsInData:(NSData *)contents 
+                          usingBlock:(void (^)(RBLogRecord *, BOOL *))block 
+                               error:(NSError **)error {
+    
+    RBBinaryLogDecoder * decoder = [[RBBinaryLogDecoder alloc] initWithData:contents error:error];
+    
+    if (!decoder)
+        return NO;
+    
+    return [decoder enumerateRecordsUsingBlock:^(RBLogRecord * record, BOOL * stop) {
+        
+        if ([record timestamp] > [self endTime] + kOutOfOrderSlack)
+            *stop = YES;
+        else if ([record timestamp] >= [self startTime] && [record timestamp] <= [self endTime])
+            block(record, stop);
+        
+    } error:error];
+}
+
+@end
@@ -0,0 +1,116 @@
+//
+// RBLogRecord.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogLevel.h"
+
+
+/**
+ * What a log record was created from.
+ */
+typedef enum {
+    
+    /// A plain message.
+    RBLogRecordTypeMessage,
+    
+    /// An NSError.
+    RBLogRecordTypeError,
+    
+    /// An NSException.
+    RBLogRecordTypeException,
+    
+} RBLogRecordType;
+
+
+/**
+ * A single message waiting to be written to a log file. Records capture the 
+ * time the message was logged so that batching writes doesn't change the 
+ * times in the log file.
+ */
+@interface RBLogRecord : NSObject
+
+/**
+ * The unformatted message to write to the log file.
+ */
+@property (nonatomic, copy, readonly) NSString * message;
+
+/**
+ * The absolute time (see CFAbsoluteTimeGetCurrent()) the message was logged.
+ */
+@property (nonatomic, assign, readonly) CFAbsoluteTime timestamp;
+
+/**
+ * What the message was created from.
+ */
+@property (nonatomic, assign, readonly) RBLogRecordType type;
+
+/**
+ * How severe the message is.
+ */
+@property (nonatomic, assign, readonly) RBLogLevel level;
+
+/**
+ * Designated initializer.
+ *
+ * @param msg The unformatted message.
+ * @param type What the message was created from.
+ * @param level How severe the message is.
+ * @param time The absolute time the message was logged.
+ *
+ * @return self
+ */
+- (id)initWithMessage:(NSString *)msg type:(RBLogRecordType)type level:(RBLogLevel)level timestamp:(CFAbsoluteTime)time;
+
+/**
+ * Initializes a record at RBLogLevelInfo.
+ *
+ * @param msg The unformatted message.
+ * @param type What the message was created from.
+ * @param time The absolute time the message was logged.
+ *
+ * @return self
+ */
+- (id)initWithMessage:(NSString *)msg type:(RBLogRecordType)type timestamp:(CFAbsoluteTime)time;
+
+/**
+ * Initializes a record of type RBLogRecordTypeMessage at RBLogLevelInfo.
+ *
+ * @param msg The unformatted message.
+ * @param time The absolute time the message was logged.
+ *
+ * @return self
+ */
+- (id)initWithMessage:(NSString *)msg timestamp:(CFAbsoluteTime)time;
+
+/**
+ * Returns a record for the given message logged at the current time.
+ *
+ * @param msg The unformatted message.
+ *
+ * @return A record for the message.
+ */
++ (RBLogRecord *)recordWithMessage:(NSString *)msg;
+
+@end
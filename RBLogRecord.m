@@ -0,0 +1,66 @@
+//
+// RBLogRecord.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogRecord.h"
+
+
+@interface RBLogRecord ()
+
+@property (nonatomic, copy, readwrite) NSString * message;
+@property (nonatomic, assign, readwrite) CFAbsoluteTime timestamp;
+@property (nonatomic, assign, readwrite) RBLogRecordType type;
+@property (nonatomic, assign, readwrite) RBLogLevel level;
+
+@end
+
+
+@implementation RBLogRecord
+
+@synthesize message, timestamp, type, level;
+
+- (id)initWithMessage:(NSString *)msg type:(RBLogRecordType)theType level:(RBLogLevel)theLevel timestamp:(CFAbsoluteTime)time {
+    
+    if ((self = [super init])) {
+        [self setMessage:msg];
+        [self setType:theType];
+        [self setLevel:theLevel];
+        [self setTimestamp:time];
+    }
+    
+    return self;
+}
+
+- (id)initWithMessage:(NSString *)msg type:(RBLogRecordType)theType timestamp:(CFAbsoluteTime)time {
+    return [self initWithMessage:msg type:theType level:RBLogLevelInfo timestamp:time];
+}
+
+- (id)initWithMessage:(NSString *)msg timestamp:(CFAbsoluteTime)time {
+    return [self initWithMessage:msg type:RBLogRecordTypeMessage timestamp:time];
+}
+
++ (RBLogRecord *)recordWithMessage:(NSString *)msg {
+    return [[self alloc] initWithMessage:msg timestamp:CFAbsoluteTimeGetCurrent()];
+}
+
+@end
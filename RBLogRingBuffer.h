@@ -0,0 +1,113 @@
+//
+// RBLogRingBuffer.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogRecord.h"
+
+@class RBDeferredMessage;
+
+
+/**
+ * A bounded, lock-free queue of log messages. Any number of threads may 
+ * enqueue at the same time. Slots are allocated up front and hold the UTF-8 
+ * bytes of short messages inline, so enqueuing a message costs a copy of its 
+ * bytes and an atomic update of the tail. Longer messages are copied into the 
+ * slot as a string object instead. The buffer never blocks; when it is full, 
+ * enqueuing fails and the caller decides what to drop.
+ */
+@interface RBLogRingBuffer : NSObject
+
+/**
+ * Standard initializer.
+ *
+ * @param capacity The number of slots. Rounded up to a power of two.
+ *
+ * @return self
+ */
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ * Copies the given message into the next free slot. Threadsafe and lock-free.
+ *
+ * @param msg The message to enqueue.
+ * @param type What the message was created from.
+ * @param level How severe the message is.
+ * @param timestamp The absolute time the message was logged.
+ * @param tag A value handed back when the message is dequeued or discarded, 
+ * such as the message's flight recorder ID.
+ *
+ * @return YES if the message was enqueued, NO if the buffer is full.
+ */
+- (BOOL)enqueueMessage:(NSString *)msg type:(RBLogRecordType)type level:(RBLogLevel)level timestamp:(CFAbsoluteTime)timestamp tag:(uint64_t)tag;
+
+/**
+ * Stores the given deferred message in the next free slot. It is rendered by 
+ * -dequeueRecordWithTag:, on the consumer's thread. Threadsafe and lock-free.
+ *
+ * @param msg The deferred message to enqueue.
+ * @param type What the message was created from.
+ * @param level How severe the message is.
+ * @param timestamp The absolute time the message was logged.
+ * @param tag A value handed back when the message is dequeued or discarded.
+ *
+ * @return YES if the message was enqueued, NO if the buffer is full.
+ */
+- (BOOL)enqueueDeferredMessage:(RBDeferredMessage *)msg type:(RBLogRecordType)type level:(RBLogLevel)level timestamp:(CFAbsoluteTime)timestamp tag:(uint64_t)tag;
+
+/**
+ * Removes the oldest message from the buffer. Threadsafe and lock-free.
+ *
+ * @param tag The message's tag is returned by reference. May be NULL.
+ *
+ * @return The oldest message as a record, or nil if the buffer is empty.
+ */
+- (RBLogRecord *)dequeueRecordWithTag:(uint64_t *)tag;
+
+/**
+ * Removes the oldest message from the buffer without creating a record for 
+ * it. Threadsafe and lock-free.
+ *
+ * @param tag The message's tag is returned by reference. May be NULL.
+ *
+ * @return YES if a message was removed, NO if the buffer is empty.
+ */
+- (BOOL)discardOldestWithTag:(uint64_t *)tag;
+
+/**
+ * Returns the number of slots in the buffer.
+ *
+ * @return The number of slots in the buffer.
+ */
+- (NSUInteger)capacity;
+
+/**
+ * Returns the number of messages in the buffer. The value is approximate 
+ * while other threads are enqueuing or dequeuing.
+ *
+ * @return The number of messages in the buffer.
+ */
+- (NSUInteger)count;
+
+@end
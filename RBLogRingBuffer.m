@@ -0,0 +1,355 @@
+//
+// RBLogRingBuffer.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <stdatomic.h>
+#import <stdlib.h>
+#import <string.h>
+
+#import "RBLogRingBuffer.h"
+#import "RBDeferredMessage.h"
+
+/**
+ * The number of message bytes each slot holds inline. Messages that don't fit 
+ * are stored as string objects instead.
+ */
+#define RB_RING_SLOT_INLINE_SIZE 232
+
+/**
+ * A single slot in the ring. The sequence number tells producers and the 
+ * consumer whose turn it is to use the slot (see Dmitry Vyukov's bounded 
+ * MPMC queue).
+ */
+typedef struct {
+    
+    /// The position the slot is ready for.
+    _Atomic(size_t) sequence;
+    
+    /// The absolute time the message was logged.
+    CFAbsoluteTime timestamp;
+    
+    /// The caller's tag for the message.
+    uint64_t tag;
+    
+    /// The number of inline bytes used.
+    uint32_t length;
+    
+    /// What the message was created from.
+    RBLogRecordType type;
+    
+    /// How severe the message is.
+    RBLogLevel level;
+    
+    /// Whether overflow holds an RBDeferredMessage rather than a string.
+    BOOL deferred;
+    
+    /// A retained copy of the message if it didn't fit inline, a retained 
+    /// RBDeferredMessage, or NULL.
+    CFTypeRef overflow;
+    
+    /// The UTF-8 bytes of the message.
+    char bytes[RB_RING_SLOT_INLINE_SIZE];
+    
+} RBLogRingSlot;
+
+
+@interface RBLogRingBuffer () {
+    
+    /// The preallocated slots.
+    RBLogRingSlot * slots;
+    
+    /// capacity - 1. The capacity is always a power of two.
+    size_t mask;
+    
+    /// The next position to enqueue at. Kept on its own cache line.
+    _Atomic(size_t) tail __attribute__((aligned(64)));
+    
+    /// The next position to dequeue from. Kept on its own cache line.
+    _Atomic(size_t) head __attribute__((aligned(64)));
+}
+
+/**
+ * Claims the next free slot for a producer. The caller must fill the slot and 
+ * then publish it by storing position + 1 in its sequence.
+ *
+ * @param claimedPosition The claimed position is returned by reference.
+ *
+ * @return The claimed slot, or NULL if the buffer is full.
+ */
+- (RBLogRingSlot *)claimFreeSlot:(size_t *)claimedPosition;
+
+/**
+ * Claims the oldest filled slot. The caller must call -releaseSlot:atPosition: 
+ * once it is done reading the slot.
+ *
+ * @param position The claimed position is returned by reference.
+ *
+ * @return The claimed slot, or NULL if the buffer is empty.
+ */
+- (RBLogRingSlot *)claimOldestSlot:(size_t *)position;
+
+/**
+ * Hands a slot claimed by -claimOldestSlot: back to the producers.
+ *
+ * @param slot The slot to release.
+ * @param position The position the slot was claimed at.
+ */
+- (void)releaseSlot:(RBLogRingSlot *)slot atPosition:(size_t)position;
+
+@end
+
+
+@implementation RBLogRingBuffer
+
+- (id)initWithCapacity:(NSUInteger)capacity {
+    
+    if ((self = [super init])) {
+        
+        // Rounds up to a power of two so positions map to slots with a mask.
+        size_t size = 2;
+        
+        while (size < capacity)
+            size <<= 1;
+        
+        mask = size - 1;
+        slots = calloc(size, sizeof(RBLogRingSlot));
+        
+        for (size_t i = 0; i < size; i++)
+            atomic_init(&slots[i].sequence, i);
+        
+        atomic_init(&tail, 0);
+        atomic_init(&head, 0);
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    
+    while ([self discardOldestWithTag:NULL])
+        ;
+    
+    free(slots);
+}
+
+- (BOOL)enqueueMessage:(NSString *)msg type:(RBLogRecordType)type level:(RBLogLevel)level timestamp:(CFAbsoluteTime)timestamp tag:(uint64_t)tag {
+    
+    size_t position = 0;
+    RBLogRingSlot * slot = [self claimFreeSlot:&position];
+    
+    if (!slot)
+        return NO;
+    
+    // Copies the message bytes straight into the slot when they fit. A UTF-8 
+    // string is never shorter in bytes than in UTF-16 units.
+    NSUInteger length = [msg length];
+    NSUInteger used = 0;
+    NSRange remaining = NSMakeRange(0, length);
+    
+    if (length <= RB_RING_SLOT_INLINE_SIZE) {
+        
+        [msg getBytes:slot->bytes
+            maxLength:RB_RING_SLOT_INLINE_SIZE
+           usedLength:&used
+             encoding:NSUTF8StringEncoding
+              options:0
+                range:NSMakeRange(0, length)
+       remainingRange:&remaining];
+    }
+    
+    slot->timestamp = timestamp;
+    slot->tag = tag;
+    slot->type = type;
+    slot->level = level;
+    slot->length = (uint32_t)used;
+    slot->deferred = NO;
+    slot->overflow = remaining.length > 0 ? CFBridgingRetain([msg copy]) : NULL;
+    
+    // Publishes the slot to the consumer.
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    
+    return YES;
+}
+
+- (BOOL)enqueueDeferredMessage:(RBDeferredMessage *)msg type:(RBLogRecordType)type level:(RBLogLevel)level timestamp:(CFAbsoluteTime)timestamp tag:(uint64_t)tag {
+    
+    size_t position = 0;
+    RBLogRingSlot * slot = [self claimFreeSlot:&position];
+    
+    if (!slot)
+        return NO;
+    
+    slot->timestamp = timestamp;
+    slot->tag = tag;
+    slot->type = type;
+    slot->level = level;
+    slot->length = 0;
+    slot->deferred = YES;
+    slot->overflow = CFBridgingRetain(msg);
+    
+    atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+    
+    return YES;
+}
+
+- (RBLogRingSlot *)claimFreeSlot:(size_t *)claimedPosition {
+    
+    size_t position = atomic_load_explicit(&tail, memory_order_relaxed);
+    
+    for (;;) {
+        
+        RBLogRingSlot * slot = &slots[position & mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+        
+        if (difference == 0) {
+            
+            // The slot is free. Claims it unless another producer got there first.
+            if (atomic_compare_exchange_weak_explicit(&tail, &position, position + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *claimedPosition = position;
+                return slot;
+            }
+        }
+        else if (difference < 0) {
+            
+            // The consumer hasn't freed this slot yet, so the buffer is full.
+            return NULL;
+        }
+        else {
+            position = atomic_load_explicit(&tail, memory_order_relaxed);
+        }
+    }
+}
+
+- (RBLogRecord *)dequeueRecordWithTag:(uint64_t *)tag {
+    
+    size_t position = 0;
+    RBLogRingSlot * slot = [self claimOldestSlot:&position];
+    
+    if (!slot)
+        return nil;
+    
+    NSString * msg = nil;
+    RBDeferredMessage * deferred = nil;
+    
+    if (slot->deferred) {
+        deferred = CFBridgingRelease(slot->overflow);
+        slot->overflow = NULL;
+    }
+    else if (slot->overflow) {
+        msg = CFBridgingRelease(slot->overflow);
+        slot->overflow = NULL;
+    }
+    else {
+        msg = [[NSString alloc] initWithBytes:slot->bytes
+                                       length:slot->length
+                                     encoding:NSUTF8StringEncoding];
+    }
+    
+    CFAbsoluteTime timestamp = slot->timestamp;
+    RBLogRecordType type = slot->type;
+    RBLogLevel level = slot->level;
+    
+    if (tag != NULL)
+        *tag = slot->tag;
+    
+    [self releaseSlot:slot atPosition:position];
+    
+    // Renders after releasing the slot so producers aren't held up by formatting.
+    if (deferred)
+        msg = [deferred message];
+    
+    return [[RBLogRecord alloc] initWithMessage:msg type:type level:level timestamp:timestamp];
+}
+
+- (BOOL)discardOldestWithTag:(uint64_t *)tag {
+    
+    size_t position = 0;
+    RBLogRingSlot * slot = [self claimOldestSlot:&position];
+    
+    if (!slot)
+        return NO;
+    
+    if (tag != NULL)
+        *tag = slot->tag;
+    
+    if (slot->overflow) {
+        CFRelease(slot->overflow);
+        slot->overflow = NULL;
+    }
+    
+    [self releaseSlot:slot atPosition:position];
+    
+    return YES;
+}
+
+- (RBLogRingSlot *)claimOldestSlot:(size_t *)position {
+    
+    size_t current = atomic_load_explicit(&head, memory_order_relaxed);
+    
+    for (;;) {
+        
+        RBLogRingSlot * slot = &slots[current & mask];
+        size_t sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire);
+        intptr_t difference = (intptr_t)sequence - (intptr_t)(current + 1);
+        
+        if (difference == 0) {
+            
+            // Producers may discard the oldest message too, so the head is claimed atomically.
+            if (atomic_compare_exchange_weak_explicit(&head, &current, current + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                *position = current;
+                return slot;
+            }
+        }
+        else if (difference < 0) {
+            
+            // Nothing has been published at this position yet.
+            return NULL;
+        }
+        else {
+            current = atomic_load_explicit(&head, memory_order_relaxed);
+        }
+    }
+}
+
+- (void)releaseSlot:(RBLogRingSlot *)slot atPosition:(size_t)position {
+    atomic_store_explicit(&slot->sequence, position + mask + 1, memory_order_release);
+}
+
+- (NSUInteger)capacity {
+    return mask + 1;
+}
+
+- (NSUInteger)count {
+    
+    size_t currentHead = atomic_load_explicit(&head, memory_order_relaxed);
+    size_t currentTail = atomic_load_explicit(&tail, memory_order_relaxed);
+    
+    return currentTail > currentHead ? currentTail - currentHead : 0;
+}
+
+@end
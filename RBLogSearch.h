@@ -0,0 +1,79 @@
+//
+// RBLogSearch.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogRecord.h"
+
+
+/**
+ * Finds the records whose messages contain a string, across many log files at 
+ * once. Plain extended log files are memory-mapped and split into chunks at 
+ * the line starts their RBLogOffsetIndex records; the part of a file past its 
+ * index, or a file without one, is a single chunk. The chunks are scanned on 
+ * all cores with memmem(), and only the lines around a match are parsed. The 
+ * search string is escaped the way RBExtendedLogFile escapes messages, so 
+ * matches land on the logical message text. Compressed and binary log files 
+ * are searched whole, one file per core.
+ *
+ * The search is literal and case sensitive.
+ */
+@interface RBLogSearch : NSObject
+
+/// The string to search for.
+@property (nonatomic, copy, readonly) NSString * searchString;
+
+/**
+ * The approximate number of bytes in each chunk of a plain log file. Defaults 
+ * to 4 MB.
+ */
+@property (nonatomic, assign) NSUInteger chunkSize;
+
+/**
+ * The maximum number of chunks searched at the same time. Defaults to 0, 
+ * which lets GCD use every core. Useful for measuring how the search scales.
+ */
+@property (nonatomic, assign) NSUInteger maxConcurrency;
+
+/**
+ * Standard initializer.
+ *
+ * @param string The string to search for.
+ *
+ * @return self
+ */
+- (id)initWithSearchString:(NSString *)string;
+
+/**
+ * Searches the given log files.
+ *
+ * @param paths The paths of the log files. May be compressed.
+ * @param error An error is returned by reference if a file can't be read.
+ *
+ * @return An array of the matching RBLogRecords in the order they were 
+ * logged, or nil if a file can't be read.
+ */
+- (NSArray *)recordsInLogFilesAtPaths:(NSArray *)paths error:(NSError **)error;
+
+@end
@@ -0,0 +1,379 @@
+//
+// RBLogSearch.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogSearch.h"
+#import "RBExtendedLogReader.h"
+#import "RBLogOffsetIndex.h"
+#import "RBLogFileCompressor.h"
+#import "RBBinaryLogDecoder.h"
+
+#import <dispatch/dispatch.h>
+#import <stdatomic.h>
+#import <string.h>
+
+/// The default approximate size of the chunks plain log files are split into.
+static const NSUInteger kDefaultSearchChunkSize = 4 * 1024 * 1024;
+
+/**
+ * A unit of work: a range of one file, or a whole file that can't be split.
+ */
+typedef struct {
+    
+    /// The index of the file in the search's file list.
+    NSUInteger file;
+    
+    /// The offset of the first line in the range.
+    NSUInteger start;
+    
+    /// The offset just past the range. Always the start of a line.
+    NSUInteger end;
+    
+    /// Whether the whole file is searched as one unit. The offsets are unused.
+    BOOL wholeFile;
+    
+} RBLogSearchRange;
+
+
+@interface RBLogSearch ()
+
+@property (nonatomic, copy, readwrite) NSString * searchString;
+
+/**
+ * The UTF-8 bytes of the search string with its quotes doubled.
+ */
+@property (nonatomic, strong) NSData * escapedNeedle;
+
+/**
+ * Splits the given plain log file into ranges and appends them to the given 
+ * list. The boundaries are the first indexed line start after each multiple 
+ * of the chunk size. Messages can hold text that looks like the start of a 
+ * line, so only the file's offset index says where lines really start. 
+ * Whatever is past the index, or the whole file if it has none, is one range.
+ *
+ * @param reader A reader of the mapped file.
+ * @param path The path of the file.
+ * @param file The index of the file.
+ * @param ranges The list to append to.
+ */
+- (void)splitFileWithReader:(RBExtendedLogReader *)reader 
+                     atPath:(NSString *)path 
+                  fileIndex:(NSUInteger)file 
+                   toRanges:(NSMutableData *)ranges;
+
+/**
+ * Scans a range of an extended log file and appends the matching records.
+ *
+ * @param reader A reader of the file.
+ * @param start The offset of the first line to scan.
+ * @param end The offset just past the last line to scan.
+ * @param records The array to append matches to.
+ */
+- (void)scanReader:(RBExtendedLogReader *)reader 
+         fromStart:(NSUInteger)start 
+             toEnd:(NSUInteger)end 
+         intoArray:(NSMutableArray *)records;
+
+/**
+ * Searches a file that can't be split: a compressed file or a binary log file.
+ *
+ * @param path The path of the file.
+ * @param records The array to append matches to.
+ * @param error An error is returned by reference if the file can't be read.
+ *
+ * @return YES if the file was searched, NO otherwise.
+ */
+- (BOOL)searchWholeFileAtPath:(NSString *)path 
+                    intoArray:(NSMutableArray *)records 
+                        error:(NSError **)error;
+
+/**
+ * Returns the escaped UTF-8 bytes of the given string.
+ *
+ * @param string The string to escape.
+ *
+ * @return The bytes as they would appear in an extended log file.
+ */
++ (NSData *)escapedDataForString:(NSString *)string;
+
+@end
+
+
+@implementation RBLogSearch
+
+@synthesize searchString, chunkSize, maxConcurrency, escapedNeedle;
+
+- (id)initWithSearchString:(NSString *)string {
+    
+    NSParameterAssert(string);
+    
+    if ((self = [super init])) {
+        
+        [self setSearchString:string];
+        [self setEscapedNeedle:[[self class] escapedDataForString:string]];
+        [self setChunkSize:kDefaultSearchChunkSize];
+    }
+    
+    return self;
+}
+
+- (NSArray *)recordsInLogFilesAtPaths:(NSArray *)paths error:(NSError **)error {
+    
+    NSMutableArray * readPaths = [NSMutableArray arrayWithCapacity:[paths count]];
+    NSMutableArray * readers = [NSMutableArray arrayWithCapacity:[paths count]];
+    NSMutableData * rangeData = [NSMutableData data];
+    
+    // Plans the work up front. Only the file headers and offset indexes are read.
+    for (NSString * path in paths) {
+        
+        NSUInteger file = [readPaths count];
+        NSString * readPath = [RBExtendedLogReader readablePathForLogFilePath:path];
+        
+        // Nothing to search if the file was purged.
+        if (!readPath)
+            continue;
+        
+        BOOL compressed = [[readPath pathExtension] isEqualToString:RBCompressedLogFileExtension];
+        NSData * mapped = compressed ? nil : [RBExtendedLogReader contentsOfLogFileAtPath:readPath error:error];
+        
+        if (!compressed && !mapped)
+            return nil;
+        
+        [readPaths addObject:readPath];
+        
+        if (compressed || [RBBinaryLogDecoder isBinaryLogData:mapped]) {
+            
+            RBLogSearchRange range = { file, 0, 0, YES };
+            
+            [rangeData appendBytes:&range length:sizeof(range)];
+            [readers addObject:[NSNull null]];
+        }
+        else {
+            
+            RBExtendedLogReader * reader = [[RBExtendedLogReader alloc] initWithData:mapped 
+                                                                            dayStart:[RBExtendedLogReader dayStartForLogFilePath:readPath]];
+            
+            [readers addObject:reader];
+            [self splitFileWithReader:reader atPath:readPath fileIndex:file toRanges:rangeData];
+        }
+    }
+    
+    const RBLogSearchRange * ranges = [rangeData bytes];
+    NSUInteger rangeCount = [rangeData length] / sizeof(RBLogSearchRange);
+    NSMutableArray * partials = [NSMutableArray arrayWithCapacity:rangeCount];
+    
+    // Each range fills its own array, so the workers never share mutable state.
+    for (NSUInteger i = 0; i < rangeCount; i++)
+        [partials addObject:[NSMutableArray array]];
+    
+    // Workers pull ranges in order, which balances uneven files across cores.
+    NSUInteger workers = [self maxConcurrency] > 0 ? MIN([self maxConcurrency], rangeCount) : rangeCount;
+    atomic_size_t nextRange = 0;
+    atomic_size_t * next = &nextRange;
+    __block NSError * firstError = nil;
+    
+    dispatch_apply(workers, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t worker) {
+        
+        size_t i;
+        
+        while ((i = atomic_fetch_add_explicit(next, 1, memory_order_relaxed)) < rangeCount) {
+            
+            @autoreleasepool {
+                
+                RBLogSearchRange range = ranges[i];
+                NSMutableArray * records = [partials objectAtIndex:i];
+                
+                if (range.wholeFile) {
+                    
+                    NSError * searchError = nil;
+                    
+                    if (![self searchWholeFileAtPath:[readPaths objectAtIndex:range.file] 
+                                           intoArray:records 
+                                               error:&searchError]) {
+                        
+                        @synchronized (self) {
+                            if (!firstError)
+                                firstError = searchError;
+                        }
+                    }
+                }
+                else {
+                    
+                    [self scanReader:[readers objectAtIndex:range.file] 
+                           fromStart:range.start 
+                               toEnd:range.end 
+                           intoArray:records];
+                }
+            }
+        }
+    });
+    
+    if (firstError) {
+        
+        if (error != NULL)
+            *error = firstError;
+        
+        return nil;
+    }
+    
+    NSMutableArray * matches = [NSMutableArray array];
+    
+    for (NSArray * partial in partials)
+        [matches addObjectsFromArray:partial];
+    
+    // The ranges are already in file order, so a stable sort only fixes up overlaps between files.
+    [matches sortWithOptions:NSSortStable usingComparator:^NSComparisonResult(RBLogRecord * record1, RBLogRecord * record2) {
+        
+        if ([record1 timestamp] < [record2 timestamp])
+            return NSOrderedAscending;
+        
+        if ([record1 timestamp] > [record2 timestamp])
+            return NSOrderedDescending;
+        
+        return NSOrderedSame;
+    }];
+    
+    return matches;
+}
+
+- (void)splitFileWithReader:(RBExtendedLogReader *)reader 
+                     atPath:(NSString *)path 
+                  fileIndex:(NSUInteger)file 
+                   toRanges:(NSMutableData *)ranges {
+    
+    NSUInteger length = [[reader data] length];
+    NSUInteger size = MAX([self chunkSize], (NSUInteger)1);
+    NSArray * offsets = [RBLogOffsetIndex lineOffsetsForLogFileAtPath:path];
+    NSUInteger offsetIndex = 0;
+    NSUInteger start = [reader headerLength];
+    
+    while (start < length) {
+        
+        NSUInteger target = start + size;
+        NSUInteger end = length;
+        
+        if (target < length) {
+            
+            // Indexed offsets are exact line starts. Past the index, the rest of 
+            // the file is one range.
+            while (offsetIndex < [offsets count] && [[offsets objectAtIndex:offsetIndex] unsignedLongLongValue] < target)
+                offsetIndex++;
+            
+            if (offsetIndex < [offsets count])
+                end = (NSUInteger)MIN([[offsets objectAtIndex:offsetIndex] unsignedLongLongValue], (unsigned long long)length);
+        }
+        
+        RBLogSearchRange range = { file, start, end, NO };
+        [ranges appendBytes:&range length:sizeof(range)];
+        
+        start = end;
+    }
+}
+
+- (void)scanReader:(RBExtendedLogReader *)reader 
+         fromStart:(NSUInteger)start 
+             toEnd:(NSUInteger)end 
+         intoArray:(NSMutableArray *)records {
+    
+    const char * bytes = [[reader data] bytes];
+    const char * needle = [[self escapedNeedle] bytes];
+    NSUInteger needleLength = [[self escapedNeedle] length];
+    NSUInteger length = [[reader data] length];
+    NSUInteger offset = MAX(start, [reader headerLength]);
+    
+    while (offset < end) {
+        
+        // Finds the next match that starts in the range. memmem() is vectorized.
+        NSUInteger window = MIN(length - offset, end - offset + (needleLength > 0 ? needleLength - 1 : 0));
+        const char * match = memmem(bytes + offset, window, needle, needleLength);
+        
+        if (!match)
+            break;
+        
+        NSUInteger matchOffset = match - bytes;
+        
+        // Walks the lines up to the one with the match. Lines without quotes cost one memchr().
+        while (offset < end) {
+            
+            RBExtendedLogLine line;
+            NSUInteger lineLength = [reader readLine:&line atOffset:offset];
+            
+            // A truncated last line has nothing more to match.
+            if (lineLength == 0) {
+                offset = end;
+                break;
+            }
+            
+            offset += lineLength;
+            
+            if (matchOffset >= offset)
+                continue;
+            
+            // The match may be in the time rather than the message, so the message is checked.
+            if (line.isRecord && memmem(line.message, line.messageLength, needle, needleLength))
+                [records addObject:[reader recordForLine:&line]];
+            
+            break;
+        }
+    }
+}
+
+- (BOOL)searchWholeFileAtPath:(NSString *)path 
+                    intoArray:(NSMutableArray *)records 
+                        error:(NSError **)error {
+    
+    NSData * contents = [RBExtendedLogReader contentsOfLogFileAtPath:path error:error];
+    
+    if (!contents)
+        return NO;
+    
+    if (![RBBinaryLogDecoder isBinaryLogData:contents]) {
+        
+        RBExtendedLogReader * reader = [[RBExtendedLogReader alloc] initWithData:contents 
+                                                                        dayStart:[RBExtendedLogReader dayStartForLogFilePath:path]];
+        
+        [self scanReader:reader fromStart:0 toEnd:[contents length] intoArray:records];
+        
+        return YES;
+    }
+    
+    RBBinaryLogDecoder * decoder = [[RBBinaryLogDecoder alloc] initWithData:contents error:error];
+    NSString * string = [self searchString];
+    
+    return decoder && [decoder enumerateRecordsUsingBlock:^(RBLogRecord * record, BOOL * stop) {
+        
+        if ([string length] == 0 || [[record message] rangeOfString:string].location != NSNotFound)
+            [records addObject:record];
+        
+    } error:error];
+}
+
++ (NSData *)escapedDataForString:(NSString *)string {
+    
+    NSString * escaped = [string stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""];
+    
+    return [escaped dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+@end
+
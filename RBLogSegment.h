@@ -0,0 +1,159 @@
+//
+// RBLogSegment.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * Describes one log file in the log file directory. A day's messages start in 
+ * segment 0 (LogFileyyyy-MM-dd.log) and continue in numbered segments 
+ * (LogFileyyyy-MM-dd.1.log, ...) when the log files have a max size. A 
+ * segment may have been compressed to a .gz file.
+ */
+@interface RBLogSegment : NSObject
+
+/// The name of the uncompressed log file, e.g. LogFile2011-06-02.1.log.
+@property (nonatomic, copy, readonly) NSString * fileName;
+
+/// The UTC day of the log file, formatted as yyyy-MM-dd.
+@property (nonatomic, copy, readonly) NSString * day;
+
+/// The number of the segment within its day.
+@property (nonatomic, assign, readonly) NSUInteger number;
+
+/// Whether the log file has been compressed.
+@property (nonatomic, assign, getter=isCompressed) BOOL compressed;
+
+/// The size of the log file on disk, in bytes.
+@property (nonatomic, assign) unsigned long long byteCount;
+
+/**
+ * The absolute time of the first message in the log file, or 0 if it isn't 
+ * known. See -startTime.
+ */
+@property (nonatomic, assign) CFAbsoluteTime firstTimestamp;
+
+/**
+ * The absolute time of the last message in the log file, or 0 if it isn't 
+ * known. See -endTime.
+ */
+@property (nonatomic, assign) CFAbsoluteTime lastTimestamp;
+
+/**
+ * Standard initializer.
+ *
+ * @param day The UTC day of the log file, formatted as yyyy-MM-dd.
+ * @param number The number of the segment within its day.
+ *
+ * @return self
+ */
+- (id)initWithDay:(NSString *)day number:(NSUInteger)number;
+
+/**
+ * Returns the name of the file currently on disk, which has the compressed 
+ * extension if the segment has been compressed.
+ *
+ * @return The name of the file on disk.
+ */
+- (NSString *)diskFileName;
+
+/**
+ * Returns the earliest time the log file may contain a message for. This is 
+ * firstTimestamp if known, otherwise the start of the day.
+ *
+ * @return An absolute time.
+ */
+- (CFAbsoluteTime)startTime;
+
+/**
+ * Returns the latest time the log file may contain a message for. This is 
+ * lastTimestamp if known, otherwise the end of the day.
+ *
+ * @return An absolute time.
+ */
+- (CFAbsoluteTime)endTime;
+
+/**
+ * Extends the known time range of the log file to include the given times.
+ *
+ * @param first The time of the first message written.
+ * @param last The time of the last message written.
+ */
+- (void)includeTimestampsFrom:(CFAbsoluteTime)first to:(CFAbsoluteTime)last;
+
+/**
+ * Returns a property list describing the segment, for saving the index.
+ *
+ * @return A dictionary of property list objects.
+ */
+- (NSDictionary *)propertyList;
+
+/**
+ * Orders segments from oldest to newest.
+ *
+ * @param segment The segment to compare to.
+ *
+ * @return The order of the two segments.
+ */
+- (NSComparisonResult)compare:(RBLogSegment *)segment;
+
+/**
+ * Parses a log file name, compressed or not, without touching the disk.
+ *
+ * @param fileName The file name to parse.
+ *
+ * @return The segment the file name describes, or nil if it isn't the name of 
+ * a log file.
+ */
++ (RBLogSegment *)segmentWithFileName:(NSString *)fileName;
+
+/**
+ * Creates a segment from a property list made by -propertyList.
+ *
+ * @param propertyList The property list.
+ *
+ * @return The segment, or nil if the property list is invalid.
+ */
++ (RBLogSegment *)segmentWithPropertyList:(NSDictionary *)propertyList;
+
+/**
+ * Returns the absolute time of the start of the given UTC day.
+ *
+ * @param day The day, formatted as yyyy-MM-dd.
+ *
+ * @return The absolute time of the day's midnight.
+ */
++ (CFAbsoluteTime)startTimeOfDay:(NSString *)day;
+
+/**
+ * Returns the name of the uncompressed log file for the given day and segment.
+ *
+ * @param day The UTC day of the log file, formatted as yyyy-MM-dd.
+ * @param number The number of the segment within its day.
+ *
+ * @return The name of the log file.
+ */
++ (NSString *)fileNameForDay:(NSString *)day number:(NSUInteger)number;
+
+@end
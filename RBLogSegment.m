@@ -0,0 +1,218 @@
+//
+// RBLogSegment.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <stdlib.h>
+
+#import "RBLogSegment.h"
+#import "RBLogFileCompressor.h"
+
+/// The prefix of every log file name.
+static NSString * const kLogFilePrefix = @"LogFile";
+
+/// The extension to use for log files.
+static NSString * const kLogFileExtension = @"log";
+
+/// The length of a day formatted as yyyy-MM-dd.
+static const NSUInteger kDayLength = 10;
+
+/// The number of seconds in a day.
+static const CFTimeInterval kSecondsPerDay = 86400.0;
+
+/// The number of days from 1970-01-01 to the reference date, 2001-01-01.
+static const long kReferenceDateDays = 11323;
+
+/// Property list keys.
+static NSString * const kFileNameKey = @"fileName";
+static NSString * const kCompressedKey = @"compressed";
+static NSString * const kByteCountKey = @"byteCount";
+static NSString * const kFirstTimestampKey = @"firstTimestamp";
+static NSString * const kLastTimestampKey = @"lastTimestamp";
+
+
+@interface RBLogSegment ()
+
+@property (nonatomic, copy, readwrite) NSString * fileName;
+@property (nonatomic, copy, readwrite) NSString * day;
+@property (nonatomic, assign, readwrite) NSUInteger number;
+
+@end
+
+
+@implementation RBLogSegment
+
+@synthesize fileName, day, number, compressed, byteCount, firstTimestamp, lastTimestamp;
+
+- (id)initWithDay:(NSString *)theDay number:(NSUInteger)theNumber {
+    
+    if ((self = [super init])) {
+        [self setDay:theDay];
+        [self setNumber:theNumber];
+        [self setFileName:[[self class] fileNameForDay:theDay number:theNumber]];
+    }
+    
+    return self;
+}
+
+- (NSString *)diskFileName {
+    
+    if ([self isCompressed])
+        return [[self fileName] stringByAppendingPathExtension:RBCompressedLogFileExtension];
+    
+    return [self fileName];
+}
+
+- (CFAbsoluteTime)startTime {
+    
+    if ([self firstTimestamp] != 0)
+        return [self firstTimestamp];
+    
+    return [[self class] startTimeOfDay:[self day]];
+}
+
+- (CFAbsoluteTime)endTime {
+    
+    if ([self lastTimestamp] != 0)
+        return [self lastTimestamp];
+    
+    return [[self class] startTimeOfDay:[self day]] + kSecondsPerDay;
+}
+
+- (void)includeTimestampsFrom:(CFAbsoluteTime)first to:(CFAbsoluteTime)last {
+    
+    if ([self firstTimestamp] == 0 || first < [self firstTimestamp])
+        [self setFirstTimestamp:first];
+    
+    if (last > [self lastTimestamp])
+        [self setLastTimestamp:last];
+}
+
+- (NSDictionary *)propertyList {
+    
+    return [NSDictionary dictionaryWithObjectsAndKeys:
+            [self fileName], kFileNameKey,
+            [NSNumber numberWithBool:[self isCompressed]], kCompressedKey,
+            [NSNumber numberWithUnsignedLongLong:[self byteCount]], kByteCountKey,
+            [NSNumber numberWithDouble:[self firstTimestamp]], kFirstTimestampKey,
+            [NSNumber numberWithDouble:[self lastTimestamp]], kLastTimestampKey,
+            nil];
+}
+
+- (NSComparisonResult)compare:(RBLogSegment *)segment {
+    
+    // Days are formatted so that they sort as strings.
+    NSComparisonResult result = [[self day] compare:[segment day]];
+    
+    if (result != NSOrderedSame)
+        return result;
+    
+    if ([self number] == [segment number])
+        return NSOrderedSame;
+    
+    return [self number] < [segment number] ? NSOrderedAscending : NSOrderedDescending;
+}
+
++ (RBLogSegment *)segmentWithFileName:(NSString *)name {
+    
+    BOOL isCompressed = [[name pathExtension] isEqualToString:RBCompressedLogFileExtension];
+    
+    if (isCompressed)
+        name = [name stringByDeletingPathExtension];
+    
+    if (![name hasPrefix:kLogFilePrefix] || ![[name pathExtension] isEqualToString:kLogFileExtension])
+        return nil;
+    
+    // Whatever is between the prefix and extension is the day and, optionally, a segment number.
+    NSString * stem = [[name stringByDeletingPathExtension] substringFromIndex:[kLogFilePrefix length]];
+    
+    if ([stem length] < kDayLength)
+        return nil;
+    
+    NSString * theDay = [stem substringToIndex:kDayLength];
+    NSInteger theNumber = 0;
+    
+    if ([stem length] > kDayLength) {
+        
+        NSScanner * scanner = [NSScanner scannerWithString:[stem substringFromIndex:kDayLength]];
+        
+        if (![scanner scanString:@"." intoString:NULL] || 
+            ![scanner scanInteger:&theNumber] || 
+            ![scanner isAtEnd] ||
+            theNumber < 0)
+            return nil;
+    }
+    
+    RBLogSegment * segment = [[self alloc] initWithDay:theDay number:theNumber];
+    [segment setCompressed:isCompressed];
+    
+    return segment;
+}
+
++ (RBLogSegment *)segmentWithPropertyList:(NSDictionary *)propertyList {
+    
+    if (![propertyList isKindOfClass:[NSDictionary class]])
+        return nil;
+    
+    RBLogSegment * segment = [self segmentWithFileName:[propertyList objectForKey:kFileNameKey]];
+    
+    [segment setCompressed:[[propertyList objectForKey:kCompressedKey] boolValue]];
+    [segment setByteCount:[[propertyList objectForKey:kByteCountKey] unsignedLongLongValue]];
+    [segment setFirstTimestamp:[[propertyList objectForKey:kFirstTimestampKey] doubleValue]];
+    [segment setLastTimestamp:[[propertyList objectForKey:kLastTimestampKey] doubleValue]];
+    
+    return segment;
+}
+
++ (CFAbsoluteTime)startTimeOfDay:(NSString *)theDay {
+    
+    if ([theDay length] != kDayLength)
+        return 0;
+    
+    // Parses the digits directly; a date formatter is far too heavy for this.
+    const char * digits = [theDay UTF8String];
+    
+    long year = strtol(digits, NULL, 10);
+    long month = strtol(digits + 5, NULL, 10);
+    long dayOfMonth = strtol(digits + 8, NULL, 10);
+    
+    // Days since 1970-01-01 in the proleptic Gregorian calendar (Howard Hinnant's days_from_civil).
+    year -= month <= 2;
+    long era = (year >= 0 ? year : year - 399) / 400;
+    long yearOfEra = year - era * 400;
+    long dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + dayOfMonth - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    long days = era * 146097 + dayOfEra - 719468;
+    
+    return (days - kReferenceDateDays) * kSecondsPerDay;
+}
+
++ (NSString *)fileNameForDay:(NSString *)theDay number:(NSUInteger)theNumber {
+    
+    // The first segment keeps the original, unnumbered name.
+    if (theNumber == 0)
+        return [NSString stringWithFormat:@"%@%@.%@", kLogFilePrefix, theDay, kLogFileExtension];
+    
+    return [NSString stringWithFormat:@"%@%@.%lu.%@", kLogFilePrefix, theDay, (unsigned long)theNumber, kLogFileExtension];
+}
+
+@end
@@ -0,0 +1,52 @@
+//
+// RBLogSink.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * A destination for log records besides the log file, such as the console. 
+ * Sinks are fed the same records as the log file, after deferred messages 
+ * have been rendered. Each sink is called on its own serial queue through an 
+ * RBLogSinkChannel, so it may block without holding up the logger or the 
+ * other sinks. See -[RBLogger addSink:].
+ */
+@protocol RBLogSink <NSObject>
+
+/**
+ * Writes a batch of records. Called on the sink's channel queue.
+ *
+ * @param records The RBLogRecords, oldest first.
+ */
+- (void)writeRecords:(NSArray *)records;
+
+@optional
+
+/**
+ * Pushes out anything the sink buffers itself. Called on the sink's channel 
+ * queue by -[RBLogger flush].
+ */
+- (void)flush;
+
+@end
@@ -0,0 +1,133 @@
+//
+// RBLogSinkChannel.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogSink.h"
+
+
+/**
+ * What a channel does with new records when its buffer is full.
+ */
+typedef enum {
+    
+    /// The oldest buffered records are dropped to make room.
+    RBLogSinkDropOldest,
+    
+    /// The new records that don't fit are dropped.
+    RBLogSinkDropNewest,
+    
+    /// The logger waits for the sink to catch up. A stalled sink then stalls 
+    /// the log file and, once the logger's own queue fills, the callers.
+    RBLogSinkBlock,
+    
+} RBLogSinkOverflowPolicy;
+
+
+/**
+ * Counters describing how a sink is keeping up. Times are in seconds.
+ */
+typedef struct {
+    
+    /// The records handed to the sink.
+    unsigned long long recordsWritten;
+    
+    /// The records dropped because the buffer was full.
+    unsigned long long recordsDropped;
+    
+    /// The number of -writeRecords: calls.
+    unsigned long long batchesWritten;
+    
+    /// The records waiting in the buffer.
+    NSUInteger recordsPending;
+    
+    /// The total time spent in -writeRecords:.
+    NSTimeInterval totalWriteTime;
+    
+    /// The longest single -writeRecords: call.
+    NSTimeInterval maxWriteTime;
+    
+    /// The sum over all records of the time from being logged to being written.
+    NSTimeInterval totalLatency;
+    
+    /// The longest time from a record being logged to it being written.
+    NSTimeInterval maxLatency;
+    
+} RBLogSinkStatistics;
+
+
+/**
+ * Connects the logger to one sink. Each channel has its own serial queue and 
+ * bounded buffer, so a slow or stalled sink only holds up itself (unless its 
+ * policy is RBLogSinkBlock). The logger hands each batch to every channel on 
+ * the loggerQueue, which only copies the records into the buffer; the sink is 
+ * called on the channel's queue with everything buffered since its last call.
+ */
+@interface RBLogSinkChannel : NSObject
+
+/// The sink fed by the channel.
+@property (nonatomic, strong, readonly) id<RBLogSink> sink;
+
+/// The serial queue the sink is called on.
+@property (nonatomic, assign, readonly) dispatch_queue_t queue;
+
+/// The max number of records buffered for the sink.
+@property (nonatomic, assign, readonly) NSUInteger capacity;
+
+/// What to do with records that don't fit in the buffer.
+@property (nonatomic, assign, readonly) RBLogSinkOverflowPolicy overflowPolicy;
+
+/**
+ * Standard initializer.
+ *
+ * @param sink The sink to feed.
+ * @param capacity The max number of records buffered for the sink.
+ * @param policy What to do with records that don't fit in the buffer.
+ *
+ * @return self
+ */
+- (id)initWithSink:(id<RBLogSink>)sink capacity:(NSUInteger)capacity overflowPolicy:(RBLogSinkOverflowPolicy)policy;
+
+/**
+ * Buffers the given records and makes sure the sink will be called. Called by 
+ * the logger on the loggerQueue. Only waits if the policy is RBLogSinkBlock.
+ *
+ * @param records The RBLogRecords, oldest first.
+ */
+- (void)enqueueRecords:(NSArray *)records;
+
+/**
+ * Waits until the sink has been given every buffered record, then calls the 
+ * sink's -flush if it has one.
+ */
+- (void)flush;
+
+/**
+ * Returns a snapshot of the channel's counters. Threadsafe.
+ *
+ * @return The counters.
+ */
+- (RBLogSinkStatistics)statistics;
+
+@end
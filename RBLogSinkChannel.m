@@ -0,0 +1,214 @@
+//
+// RBLogSinkChannel.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogSinkChannel.h"
+#import "RBLogRecord.h"
+
+
+@interface RBLogSinkChannel () {
+    
+    /// The counters. Guarded by condition.
+    RBLogSinkStatistics statistics;
+    
+    /// Whether a drain is queued or running. Guarded by condition.
+    BOOL drainScheduled;
+}
+
+@property (nonatomic, strong, readwrite) id<RBLogSink> sink;
+@property (nonatomic, assign, readwrite) dispatch_queue_t queue;
+@property (nonatomic, assign, readwrite) NSUInteger capacity;
+@property (nonatomic, assign, readwrite) RBLogSinkOverflowPolicy overflowPolicy;
+
+/**
+ * Guards the buffer and counters, and wakes blocked producers when the sink 
+ * takes records.
+ */
+@property (nonatomic, strong) NSCondition * condition;
+
+/**
+ * The records waiting for the sink. Guarded by condition.
+ */
+@property (nonatomic, strong) NSMutableArray * pendingRecords;
+
+/**
+ * Queues a drain unless one is already queued. The caller must hold 
+ * condition.
+ */
+- (void)scheduleDrain;
+
+/**
+ * Hands the buffered records to the sink until the buffer is empty. Should 
+ * only be called on the queue.
+ */
+- (void)drain;
+
+@end
+
+
+@implementation RBLogSinkChannel
+
+@synthesize sink, queue, capacity, overflowPolicy, condition, pendingRecords;
+
+- (id)initWithSink:(id<RBLogSink>)theSink capacity:(NSUInteger)theCapacity overflowPolicy:(RBLogSinkOverflowPolicy)policy {
+    
+    if ((self = [super init])) {
+        
+        [self setSink:theSink];
+        [self setCapacity:MAX(theCapacity, 1)];
+        [self setOverflowPolicy:policy];
+        [self setCondition:[NSCondition new]];
+        [self setPendingRecords:[NSMutableArray array]];
+        
+        dispatch_queue_t sinkQueue = dispatch_queue_create("com.RobertBrown.RBLogSinkQueue", NULL);
+        dispatch_set_target_queue(sinkQueue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0));
+        [self setQueue:sinkQueue];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+#if !OS_OBJECT_USE_OBJC
+    dispatch_release(queue);
+#endif
+}
+
+- (void)enqueueRecords:(NSArray *)records {
+    
+    NSUInteger count = [records count];
+    
+    if (count == 0)
+        return;
+    
+    [[self condition] lock];
+    
+    NSMutableArray * pending = [self pendingRecords];
+    
+    if ([self overflowPolicy] == RBLogSinkBlock) {
+        
+        // Copies in as much as fits, waiting for the sink to take records in between.
+        NSUInteger offset = 0;
+        
+        while (offset < count) {
+            
+            while ([pending count] >= [self capacity]) {
+                [self scheduleDrain];
+                [[self condition] wait];
+                pending = [self pendingRecords];
+            }
+            
+            NSUInteger length = MIN([self capacity] - [pending count], count - offset);
+            [pending addObjectsFromArray:[records subarrayWithRange:NSMakeRange(offset, length)]];
+            offset += length;
+        }
+    }
+    else {
+        
+        [pending addObjectsFromArray:records];
+        
+        if ([pending count] > [self capacity]) {
+            
+            NSUInteger excess = [pending count] - [self capacity];
+            NSUInteger start = [self overflowPolicy] == RBLogSinkDropOldest ? 0 : [pending count] - excess;
+            
+            [pending removeObjectsInRange:NSMakeRange(start, excess)];
+            statistics.recordsDropped += excess;
+        }
+    }
+    
+    [self scheduleDrain];
+    [[self condition] unlock];
+}
+
+- (void)scheduleDrain {
+    
+    if (drainScheduled || [[self pendingRecords] count] == 0)
+        return;
+    
+    drainScheduled = YES;
+    
+    dispatch_async([self queue], ^{
+        [self drain];
+    });
+}
+
+- (void)drain {
+    
+    for (;;) {
+        
+        [[self condition] lock];
+        
+        NSArray * batch = [self pendingRecords];
+        
+        if ([batch count] == 0) {
+            drainScheduled = NO;
+            [[self condition] unlock];
+            return;
+        }
+        
+        // Takes the whole buffer so the logger can keep filling a new one.
+        [self setPendingRecords:[NSMutableArray array]];
+        [[self condition] broadcast];
+        [[self condition] unlock];
+        
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [[self sink] writeRecords:batch];
+        CFAbsoluteTime end = CFAbsoluteTimeGetCurrent();
+        
+        NSTimeInterval latency = 0.0;
+        
+        for (RBLogRecord * record in batch)
+            latency += end - [record timestamp];
+        
+        [[self condition] lock];
+        statistics.recordsWritten += [batch count];
+        statistics.batchesWritten++;
+        statistics.totalWriteTime += end - start;
+        statistics.maxWriteTime = MAX(statistics.maxWriteTime, end - start);
+        statistics.totalLatency += latency;
+        statistics.maxLatency = MAX(statistics.maxLatency, end - [[batch objectAtIndex:0] timestamp]);
+        [[self condition] unlock];
+    }
+}
+
+- (void)flush {
+    
+    dispatch_sync([self queue], ^{
+        
+        if ([[self sink] respondsToSelector:@selector(flush)])
+            [[self sink] flush];
+    });
+}
+
+- (RBLogSinkStatistics)statistics {
+    
+    [[self condition] lock];
+    RBLogSinkStatistics snapshot = statistics;
+    snapshot.recordsPending = [[self pendingRecords] count];
+    [[self condition] unlock];
+    
+    return snapshot;
+}
+
+@end
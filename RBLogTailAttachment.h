@@ -0,0 +1,98 @@
+//
+// RBLogTailAttachment.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBAttachment.h"
+
+
+/**
+ * An attachment holding the end of the log: the last N records, or the 
+ * records from the last N minutes. Plain log files are read backward from the 
+ * end in blocks that double in size until the excerpt is covered, so the cost 
+ * scales with the size of the excerpt rather than the size of the file. 
+ * Compressed files can't be read backward and are read whole.
+ *
+ * The excerpt keeps the extended log file format. Each file's part starts with 
+ * a "#File:" line naming the file, since lines only store the time of day. If 
+ * the part refers to an exception stack written in full before the excerpt, 
+ * the line with the full stack is copied in after a "#Stacks referenced 
+ * below:" line, so those parts may hold a few more, older records. The 
+ * excerpt is built the first time it is needed and then kept.
+ */
+@interface RBLogTailAttachment : NSObject <RBAttachment>
+
+/// The log files to take the excerpt from, from oldest to newest.
+@property (nonatomic, copy, readonly) NSArray * logFilePaths;
+
+/// The maximum number of records in the excerpt, or 0 for no limit.
+@property (nonatomic, assign, readonly) NSUInteger recordLimit;
+
+/// The absolute time of the oldest record in the excerpt, or 0 for no limit.
+@property (nonatomic, assign, readonly) CFAbsoluteTime cutoffTime;
+
+/**
+ * Initializes an attachment with the last records of the given log files.
+ *
+ * @param paths The log files, from oldest to newest.
+ * @param count The number of records to keep.
+ *
+ * @return self
+ */
+- (id)initWithLogFilePaths:(NSArray *)paths recordLimit:(NSUInteger)count;
+
+/**
+ * Initializes an attachment with the records of the given log files logged at 
+ * or after the given time.
+ *
+ * @param paths The log files, from oldest to newest.
+ * @param time The absolute time of the oldest record to keep.
+ *
+ * @return self
+ */
+- (id)initWithLogFilePaths:(NSArray *)paths cutoffTime:(CFAbsoluteTime)time;
+
+/**
+ * Returns an attachment with the last records logged by the default 
+ * logger. Pending messages are written first. Must not be called from the 
+ * loggerQueue.
+ *
+ * @param count The number of records to keep.
+ *
+ * @return An attachment.
+ */
++ (RBLogTailAttachment *)attachmentWithLastRecords:(NSUInteger)count;
+
+/**
+ * Returns an attachment with the records the default logger logged in the 
+ * last few minutes. Pending messages are written first. Must not be called 
+ * from the loggerQueue.
+ *
+ * @param minutes The number of minutes to keep.
+ *
+ * @return An attachment.
+ */
++ (RBLogTailAttachment *)attachmentWithLastMinutes:(NSUInteger)minutes;
+
+@end
@@ -0,0 +1,516 @@
+//
+// RBLogTailAttachment.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogTailAttachment.h"
+#import "RBExtendedLogReader.h"
+#import "RBLogFileCompressor.h"
+#import "RBLogger.h"
+#import "RBStackRenderer.h"
+
+#import <fcntl.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+/// The size of the first block read from the end of a file. Doubles each time.
+static const NSUInteger kTailBlockSize = 16 * 1024;
+
+/// The seconds in a minute.
+static const NSTimeInterval kSecondsPerMinute = 60.0;
+
+/// The seconds a record can be written after later ones. Threads timestamp 
+/// records before they enqueue them, so records race each other into the queue.
+static const CFTimeInterval kOutOfOrderSlack = 1.0;
+
+
+@interface RBLogTailAttachment ()
+
+@property (nonatomic, copy, readwrite) NSArray * logFilePaths;
+@property (nonatomic, assign, readwrite) NSUInteger recordLimit;
+@property (nonatomic, assign, readwrite) CFAbsoluteTime cutoffTime;
+
+/**
+ * The excerpt, once it has been built.
+ */
+@property (nonatomic, strong) NSData * excerpt;
+
+/**
+ * Builds the excerpt from the log files, newest first.
+ *
+ * @return The excerpt.
+ */
+- (NSData *)buildExcerpt;
+
+/**
+ * Returns the end of the given log file that belongs in the excerpt.
+ *
+ * @param path The path of the log file. May be compressed.
+ * @param limit The number of records still wanted, or 0 for no limit.
+ * @param count The number of records returned is returned by reference.
+ * @param reachedCutoff Set to YES by reference if the file has records older 
+ * than cutoffTime by more than records can be out of order, so older files 
+ * aren't needed.
+ *
+ * @return The lines to keep, or nil if the file can't be read.
+ */
+- (NSData *)tailOfLogFileAtPath:(NSString *)path 
+                    recordLimit:(NSUInteger)limit 
+                    recordCount:(NSUInteger *)count 
+                  reachedCutoff:(BOOL *)reachedCutoff;
+
+/**
+ * Returns the lines of a log file that write out in full the exception stacks 
+ * an excerpt only refers to by ID. The logger writes each stack in full 
+ * earlier in the same file, but that may be before the excerpt.
+ *
+ * @param range The byte range of the excerpt in the reader's data.
+ * @param reader The reader the excerpt comes from.
+ * @param path The path of the log file, to read the rest of it if needed.
+ *
+ * @return The lines, oldest first, or nil if none are needed.
+ */
+- (NSData *)stackLinesReferencedInRange:(NSRange)range 
+                                 reader:(RBExtendedLogReader *)reader 
+                          logFileAtPath:(NSString *)path;
+
+/**
+ * Selects the records to keep from the lines a reader can see. Records older 
+ * than cutoffTime are skipped, and once one is older by more than records can 
+ * be out of order, everything before it is too.
+ *
+ * @param reader The reader.
+ * @param start The offset of the first line.
+ * @param limit The number of records wanted, or 0 for no limit.
+ * @param wholeFile Whether the reader sees the whole file.
+ * @param range The byte range of the records to keep is returned by reference.
+ * @param count The number of records kept is returned by reference.
+ * @param reachedCutoff Set to YES by reference if a record older than 
+ * cutoffTime by more than records can be out of order was seen.
+ *
+ * @return YES if the lines cover the excerpt, NO if more of the file is needed.
+ */
+- (BOOL)selectRecordsInReader:(RBExtendedLogReader *)reader 
+                   fromOffset:(NSUInteger)start 
+                  recordLimit:(NSUInteger)limit 
+                    wholeFile:(BOOL)wholeFile 
+                        range:(NSRange *)range 
+                  recordCount:(NSUInteger *)count 
+                reachedCutoff:(BOOL *)reachedCutoff;
+
+/**
+ * Reads the given number of bytes from the end of a file.
+ *
+ * @param fileDescriptor The open file.
+ * @param length The number of bytes to read.
+ * @param size The size of the file.
+ *
+ * @return The bytes, or nil if they can't be read.
+ */
++ (NSData *)readLength:(NSUInteger)length fromEndOfFile:(int)fileDescriptor size:(unsigned long long)size;
+
+/**
+ * Returns the paths of the default logger's log files for the given time 
+ * until now.
+ *
+ * @param startTime The absolute time to start from.
+ *
+ * @return The paths, from oldest to newest.
+ */
++ (NSArray *)logFilePathsSinceTime:(CFAbsoluteTime)startTime;
+
+@end
+
+
+@implementation RBLogTailAttachment
+
+@synthesize logFilePaths, recordLimit, cutoffTime, excerpt;
+
+- (id)initWithLogFilePaths:(NSArray *)paths recordLimit:(NSUInteger)count {
+    
+    if ((self = [super init])) {
+        [self setLogFilePaths:paths];
+        [self setRecordLimit:count];
+    }
+    
+    return self;
+}
+
+- (id)initWithLogFilePaths:(NSArray *)paths cutoffTime:(CFAbsoluteTime)time {
+    
+    if ((self = [super init])) {
+        [self setLogFilePaths:paths];
+        [self setCutoffTime:time];
+    }
+    
+    return self;
+}
+
+- (NSData *)data {
+    
+    if (![self excerpt])
+        [self setExcerpt:[self buildExcerpt]];
+    
+    return [self excerpt];
+}
+
+- (NSString *)MIMEType {
+    return @"text/plain";
+}
+
+- (NSString *)fileName {
+    return @"RecentLog.log";
+}
+
+- (unsigned long long)length {
+    return [[self data] length];
+}
+
+- (BOOL)enumerateChunksUsingBlock:(void (^)(const void *, NSUInteger, BOOL *))block error:(NSError **)error {
+    
+    NSData * data = [self data];
+    BOOL stop = NO;
+    
+    // The excerpt is already small and in memory.
+    if ([data length] > 0)
+        block([data bytes], [data length], &stop);
+    
+    return YES;
+}
+
+- (NSData *)buildExcerpt {
+    
+    NSMutableArray * parts = [NSMutableArray array];
+    NSUInteger remaining = [self recordLimit];
+    
+    // Works back from the newest file until the excerpt is covered.
+    for (NSString * path in [[self logFilePaths] reverseObjectEnumerator]) {
+        
+        NSUInteger count = 0;
+        BOOL reachedCutoff = NO;
+        NSData * tail = [self tailOfLogFileAtPath:path recordLimit:remaining recordCount:&count reachedCutoff:&reachedCutoff];
+        
+        if ([tail length] > 0)
+            [parts insertObject:tail atIndex:0];
+        
+        if (reachedCutoff)
+            break;
+        
+        if ([self recordLimit] > 0) {
+            
+            remaining -= MIN(count, remaining);
+            
+            if (remaining == 0)
+                break;
+        }
+    }
+    
+    NSMutableData * result = [NSMutableData data];
+    
+    for (NSData * part in parts)
+        [result appendData:part];
+    
+    return result;
+}
+
+- (NSData *)tailOfLogFileAtPath:(NSString *)path 
+                    recordLimit:(NSUInteger)limit 
+                    recordCount:(NSUInteger *)count 
+                  reachedCutoff:(BOOL *)reachedCutoff {
+    
+    NSString * readPath = [RBExtendedLogReader readablePathForLogFilePath:path];
+    
+    if (!readPath)
+        return nil;
+    
+    CFAbsoluteTime dayStart = [RBExtendedLogReader dayStartForLogFilePath:readPath];
+    RBExtendedLogReader * reader = nil;
+    NSRange range = NSMakeRange(0, 0);
+    
+    if ([[readPath pathExtension] isEqualToString:RBCompressedLogFileExtension]) {
+        
+        // Compressed files can only be read from the start.
+        reader = [[RBExtendedLogReader alloc] initWithContentsOfFile:readPath error:NULL];
+        
+        [self selectRecordsInReader:reader 
+                         fromOffset:[reader headerLength] 
+                        recordLimit:limit 
+                          wholeFile:YES 
+                              range:&range 
+                        recordCount:count 
+                      reachedCutoff:reachedCutoff];
+    }
+    else {
+        
+        int fileDescriptor = open([readPath fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+        struct stat info;
+        
+        if (fileDescriptor < 0)
+            return nil;
+        
+        unsigned long long size = fstat(fileDescriptor, &info) == 0 ? (unsigned long long)info.st_size : 0;
+        
+        // Reads twice as much from the end each time, so at most twice the excerpt is read overall.
+        for (NSUInteger blockSize = kTailBlockSize; YES; blockSize *= 2) {
+            
+            NSUInteger tailLength = (NSUInteger)MIN(size, (unsigned long long)blockSize);
+            BOOL wholeFile = tailLength == size;
+            NSData * tail = [[self class] readLength:tailLength fromEndOfFile:fileDescriptor size:size];
+            
+            if (!tail) {
+                reader = nil;
+                break;
+            }
+            
+            NSUInteger start = 0;
+            
+            // The block starts mid-line, so starts at the first thing that looks like a line.
+            if (!wholeFile) {
+                
+                const char * bytes = [tail bytes];
+                const char * newline = bytes;
+                
+                while ((newline = memchr(newline, '\n', bytes + tailLength - newline))) {
+                    
+                    newline++;
+                    
+                    if (RBLooksLikeExtendedLogLineStart(newline, bytes + tailLength - newline))
+                        break;
+                }
+                
+                if (!newline)
+                    continue;
+                
+                start = newline - bytes;
+                tail = [tail subdataWithRange:NSMakeRange(start, tailLength - start)];
+                start = 0;
+            }
+            
+            reader = [[RBExtendedLogReader alloc] initWithData:tail dayStart:dayStart];
+            
+            if (wholeFile)
+                start = [reader headerLength];
+            
+            BOOL covered = [self selectRecordsInReader:reader 
+                                            fromOffset:start 
+                                           recordLimit:limit 
+                                             wholeFile:wholeFile 
+                                                 range:&range 
+                                           recordCount:count 
+                                         reachedCutoff:reachedCutoff];
+            
+            if (covered)
+                break;
+        }
+        
+        close(fileDescriptor);
+    }
+    
+    if (!reader || range.length == 0)
+        return nil;
+    
+    NSString * fileName = [readPath lastPathComponent];
+    
+    if ([[fileName pathExtension] isEqualToString:RBCompressedLogFileExtension])
+        fileName = [fileName stringByDeletingPathExtension];
+    
+    NSString * fileLine = [NSString stringWithFormat:@"#File: %@\n", fileName];
+    NSMutableData * part = [NSMutableData dataWithData:[fileLine dataUsingEncoding:NSUTF8StringEncoding]];
+    NSData * stackLines = [self stackLinesReferencedInRange:range reader:reader logFileAtPath:readPath];
+    
+    if (stackLines) {
+        [part appendData:[@"#Stacks referenced below:\n" dataUsingEncoding:NSUTF8StringEncoding]];
+        [part appendData:stackLines];
+    }
+    
+    if ([self cutoffTime] > 0) {
+        
+        // Records written late, from just before the cutoff, can sit between 
+        // the ones kept, so only the lines at or after it are copied.
+        [reader enumerateLinesFromOffset:range.location 
+                                toOffset:NSMaxRange(range) 
+                              usingBlock:^(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop) {
+            
+            if ([reader timestampOfLine:line] < [self cutoffTime])
+                return;
+            
+            RBExtendedLogLine copy;
+            NSUInteger length = [reader readLine:&copy atOffset:offset];
+            
+            [part appendData:[[reader data] subdataWithRange:NSMakeRange(offset, length)]];
+        }];
+    }
+    else {
+        [part appendData:[[reader data] subdataWithRange:range]];
+    }
+    
+    return part;
+}
+
+- (NSData *)stackLinesReferencedInRange:(NSRange)range 
+                                 reader:(RBExtendedLogReader *)reader 
+                          logFileAtPath:(NSString *)path {
+    
+    NSMutableSet * writtenStacks = [NSMutableSet set];
+    NSMutableSet * missingStacks = [NSMutableSet set];
+    
+    [reader enumerateLinesFromOffset:range.location 
+                            toOffset:NSMaxRange(range) 
+                          usingBlock:^(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop) {
+        
+        NSString * message = [reader messageOfLine:line];
+        NSString * stackID = [RBStackRenderer stackIDOfDescription:message];
+        
+        if (stackID) {
+            [writtenStacks addObject:stackID];
+            return;
+        }
+        
+        stackID = [RBStackRenderer referencedStackIDOfDescription:message];
+        
+        if (stackID && ![writtenStacks containsObject:stackID])
+            [missingStacks addObject:stackID];
+    }];
+    
+    if ([missingStacks count] == 0)
+        return nil;
+    
+    // Only the end of a plain file was read. Compressed files were read whole.
+    RBExtendedLogReader * fileReader = reader;
+    
+    if (![[path pathExtension] isEqualToString:RBCompressedLogFileExtension])
+        fileReader = [[RBExtendedLogReader alloc] initWithContentsOfFile:path error:NULL];
+    
+    NSMutableData * lines = [NSMutableData data];
+    
+    [fileReader enumerateLinesUsingBlock:^(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop) {
+        
+        NSString * stackID = [RBStackRenderer stackIDOfDescription:[fileReader messageOfLine:line]];
+        
+        if (!stackID || ![missingStacks containsObject:stackID])
+            return;
+        
+        RBExtendedLogLine copy;
+        NSUInteger length = [fileReader readLine:&copy atOffset:offset];
+        
+        [lines appendData:[[fileReader data] subdataWithRange:NSMakeRange(offset, length)]];
+        [missingStacks removeObject:stackID];
+        *stop = [missingStacks count] == 0;
+    }];
+    
+    return [lines length] > 0 ? lines : nil;
+}
+
+- (BOOL)selectRecordsInReader:(RBExtendedLogReader *)reader 
+                   fromOffset:(NSUInteger)start 
+                  recordLimit:(NSUInteger)limit 
+                    wholeFile:(BOOL)wholeFile 
+                        range:(NSRange *)range 
+                  recordCount:(NSUInteger *)count 
+                reachedCutoff:(BOOL *)reachedCutoff {
+    
+    NSMutableData * offsets = [NSMutableData data];
+    NSUInteger offset = start;
+    NSUInteger end = start;
+    NSUInteger lineLength = 0;
+    BOOL reached = NO;
+    RBExtendedLogLine line;
+    
+    while ((lineLength = [reader readLine:&line atOffset:offset]) > 0) {
+        
+        if (line.isRecord) {
+            
+            CFAbsoluteTime timestamp = [reader timestampOfLine:&line];
+            
+            // Records are only slightly out of order, so everything kept so far 
+            // is older than the cutoff too.
+            if ([self cutoffTime] > 0 && timestamp < [self cutoffTime] - kOutOfOrderSlack) {
+                reached = YES;
+                [offsets setLength:0];
+            }
+            else if ([self cutoffTime] <= 0 || timestamp >= [self cutoffTime]) {
+                [offsets appendBytes:&offset length:sizeof(offset)];
+            }
+            
+            end = offset + lineLength;
+        }
+        
+        offset += lineLength;
+    }
+    
+    const NSUInteger * starts = [offsets bytes];
+    NSUInteger found = [offsets length] / sizeof(NSUInteger);
+    NSUInteger first = (limit > 0 && found > limit) ? found - limit : 0;
+    
+    *count = found - first;
+    *reachedCutoff = reached;
+    *range = found > 0 ? NSMakeRange(starts[first], end - starts[first]) : NSMakeRange(0, 0);
+    
+    // One extra record is wanted in case the first line found was inside a multi-line message.
+    return wholeFile || reached || (limit > 0 && found > limit);
+}
+
++ (NSData *)readLength:(NSUInteger)length fromEndOfFile:(int)fileDescriptor size:(unsigned long long)size {
+    
+    NSMutableData * data = [NSMutableData dataWithLength:length];
+    char * bytes = [data mutableBytes];
+    NSUInteger total = 0;
+    
+    while (total < length) {
+        
+        ssize_t count = pread(fileDescriptor, bytes + total, length - total, (off_t)(size - length + total));
+        
+        if (count < 0 && errno == EINTR)
+            continue;
+        
+        if (count <= 0)
+            return nil;
+        
+        total += (NSUInteger)count;
+    }
+    
+    return data;
+}
+
++ (NSArray *)logFilePathsSinceTime:(CFAbsoluteTime)startTime {
+    
+    NSDate * startDate = [NSDate dateWithTimeIntervalSinceReferenceDate:startTime];
+    
+    return [[RBLogger defaultLogger] logFilePathsFromDate:startDate toDate:[NSDate distantFuture]];
+}
+
++ (RBLogTailAttachment *)attachmentWithLastRecords:(NSUInteger)count {
+    
+    // Older files are listed too, but are only read if the newer ones run out.
+    NSArray * paths = [[RBLogger defaultLogger] logFilePathsFromDate:[NSDate distantPast] toDate:[NSDate distantFuture]];
+    
+    return [[self alloc] initWithLogFilePaths:paths recordLimit:count];
+}
+
++ (RBLogTailAttachment *)attachmentWithLastMinutes:(NSUInteger)minutes {
+    
+    CFAbsoluteTime cutoff = CFAbsoluteTimeGetCurrent() - minutes * kSecondsPerMinute;
+    
+    return [[self alloc] initWithLogFilePaths:[self logFilePathsSinceTime:cutoff] cutoffTime:cutoff];
+}
+
+@end
@@ -25,9 +25,95 @@
 #import <Foundation/Foundation.h>
 
 #import "RBLogFile.h"
+#import "RBLogLevel.h"
+#import "RBLogSink.h"
+#import "RBLogSinkChannel.h"
+#import "RBLatencyHistogram.h"
+
+@class RBLogFileFactory;
+
+
+/**
+ * What the logger does with a new message when its queue of pending messages 
+ * is full.
+ */
+typedef enum {
+    
+    /// The new message is dropped.
+    RBLogOverflowDropNewest,
+    
+    /// The oldest pending message is dropped to make room for the new one.
+    RBLogOverflowDropOldest,
+    
+    /// The caller waits until the logger has written enough messages to make room.
+    RBLogOverflowBlock,
+    
+} RBLogOverflowPolicy;
+
+
+/**
+ * Counters describing how the logger is keeping up. Times are in seconds.
+ */
+typedef struct {
+    
+    /// The messages accepted into the queue of pending messages.
+    unsigned long long messagesEnqueued;
+    
+    /// The messages written to the log file.
+    unsigned long long messagesWritten;
+    
+    /// The messages dropped because the queue of pending messages was full.
+    unsigned long long messagesDropped;
+    
+    /// The bytes written to the log files, headers included.
+    unsigned long long bytesWritten;
+    
+    /// The messages waiting in the queue of pending messages.
+    NSUInteger queueDepth;
+    
+    /// The most messages found waiting when a batch was drained.
+    NSUInteger maxQueueDepth;
+    
+    /// The time from each message being logged to it reaching the kernel.
+    RBLatencySummary diskLatency;
+    
+    /// The time spent in each write and flush of the log file.
+    RBLatencySummary writeTime;
+    
+    /// The time spent deleting old log files, by age or by quota.
+    RBLatencySummary purgeTime;
+    
+    /// The time spent closing one log file and opening the next.
+    RBLatencySummary rotationTime;
+    
+} RBLoggerStatistics;
+
 
 @interface RBLogger : NSObject
 
+/**
+ * The logger's name. The default logger's is "Default".
+ */
+@property (nonatomic, copy, readonly) NSString * name;
+
+/**
+ * The directory the logger's files are kept in. Nothing else should be 
+ * written there.
+ */
+@property (nonatomic, copy, readonly) NSString * directory;
+
+/**
+ * Creates the logger's log files. Change its logFileClass before the first 
+ * message is logged.
+ */
+@property (nonatomic, strong, readonly) RBLogFileFactory * logFileFactory;
+
+/**
+ * The age in days past which log files are purged when the logger starts. 0 
+ * means files are never purged by age. Defaults to 30.
+ */
+@property (nonatomic, assign) NSUInteger logFileAgeLimit;
+
 /**
  * A dispatch queue used for serializing requests. If you call a method in this 
  * class that is not marked as threadsafe in the documentation, you should run 
@@ -36,23 +122,81 @@
 @property (nonatomic, assign, readonly) dispatch_queue_t loggerQueue;
 
 /**
- * Logs an error. Simply calls logMessage: with a string generated from the 
- * error. Threadsafe.
+ * The max number of messages written to the log file in one batch. Once this 
+ * many messages are waiting, they are written without waiting for 
+ * maxBatchAge. Defaults to 256.
+ */
+@property (nonatomic, assign) NSUInteger maxBatchSize;
+
+/**
+ * The max time, in seconds, a message waits before its batch is written to the 
+ * log file. Defaults to 0.05 (50 ms).
+ */
+@property (nonatomic, assign) NSTimeInterval maxBatchAge;
+
+/**
+ * The size, in bytes, at which the current log file is closed and the day's 
+ * messages continue in a new numbered segment, such as 
+ * LogFile2011-06-02.1.log. 0 means no limit. Defaults to 10 MB.
+ */
+@property (nonatomic, assign) unsigned long long maxLogFileSize;
+
+/**
+ * The max total size, in bytes, of all the log files. When it is exceeded, the 
+ * oldest log files are deleted first. The sizes are tracked as messages are 
+ * written, so checking the quota doesn't touch the disk. 0 means no limit. 
+ * Defaults to 100 MB.
+ */
+@property (nonatomic, assign) unsigned long long logDirectoryByteQuota;
+
+/**
+ * What to do with new messages when the queue of pending messages is full. 
+ * Defaults to RBLogOverflowDropOldest.
+ */
+@property (nonatomic, assign) RBLogOverflowPolicy overflowPolicy;
+
+/**
+ * The number of messages dropped because the queue of pending messages was 
+ * full. Threadsafe.
+ */
+@property (nonatomic, assign, readonly) NSUInteger droppedMessageCount;
+
+/**
+ * Returns a snapshot of the logger's counters. The counters are updated with 
+ * relaxed atomics, so logging never waits on them. Threadsafe.
+ *
+ * @return The counters.
+ */
+- (RBLoggerStatistics)statistics;
+
+/**
+ * Returns a plain text report of the logger's counters and those of each of 
+ * its sinks, suitable for a bug report. Threadsafe.
+ *
+ * @return The report.
+ */
+- (NSString *)statisticsReport;
+
+/**
+ * Logs an error at RBLogLevelError. The error is turned into a string on the 
+ * loggerQueue, and only if that level is enabled. Threadsafe.
  *
  * @param error The error to log.
  */
 - (void)logError:(NSError *)error;
 
 /**
- * Logs an exception. Simply calls logMessage: with a string generated from the 
- * exception. Threadsafe
+ * Logs an exception at RBLogLevelFault. The exception is turned into a string 
+ * on the loggerQueue, and only if that level is enabled. Threadsafe.
  *
  * @param exception The exception to log.
  */
 - (void)logException:(NSException *)exception;
 
 /**
- * Writes the given message to the log file. Threadsafe.
+ * Writes the given message to the log file at RBLogLevelInfo. Threadsafe. Messages are copied 
+ * into a lock-free queue and written in batches, see maxBatchSize, maxBatchAge 
+ * and overflowPolicy.
  *
  * @param msg The unformatted message to write to the log file.
  *
@@ -60,6 +204,69 @@
  */
 - (void)logMessage:(NSString *)msg;
 
+/**
+ * Writes the given message to the log file at the given level. Threadsafe. 
+ * Messages below the threshold (see RBSetLogLevelThreshold()) are dropped 
+ * before they are copied.
+ *
+ * @param msg The unformatted message to write to the log file.
+ * @param level How severe the message is.
+ */
+- (void)logMessage:(NSString *)msg level:(RBLogLevel)level;
+
+/**
+ * Logs a formatted message at the given level without formatting it on the 
+ * calling thread. The format and the argument values are copied, and the 
+ * message is rendered on the loggerQueue when its batch is written. Objects 
+ * are described at that point, so mutable objects should be copied first. 
+ * Formats that can't be captured (see RBDeferredMessage) are formatted right 
+ * away. Threadsafe.
+ *
+ * @param level How severe the message is.
+ * @param format The format, as for +[NSString stringWithFormat:].
+ */
+- (void)logWithLevel:(RBLogLevel)level format:(NSString *)format, ... NS_FORMAT_FUNCTION(2,3);
+
+/**
+ * Like -logWithLevel:format:, but takes a va_list. Threadsafe.
+ *
+ * @param level How severe the message is.
+ * @param format The format, as for +[NSString stringWithFormat:].
+ * @param arguments The arguments for the format.
+ */
+- (void)logWithLevel:(RBLogLevel)level format:(NSString *)format arguments:(va_list)arguments NS_FORMAT_FUNCTION(2,0);
+
+/**
+ * Adds a sink to be fed every batch of records after it is written to the log 
+ * file. The sink gets its own queue and a buffer of 4096 records, dropping the 
+ * oldest when it falls behind. The default logger adds an RBConsoleLogSink 
+ * when RB_CONSOLE_LOGGING is set. Threadsafe.
+ *
+ * @param sink The sink to add.
+ *
+ * @return The channel feeding the sink, for reading its statistics.
+ */
+- (RBLogSinkChannel *)addSink:(id<RBLogSink>)sink;
+
+/**
+ * Adds a sink with the given buffer size and overflow policy. See 
+ * RBLogSinkChannel. Threadsafe.
+ *
+ * @param sink The sink to add.
+ * @param capacity The max number of records buffered for the sink.
+ * @param policy What to do with records that don't fit in the buffer.
+ *
+ * @return The channel feeding the sink, for reading its statistics.
+ */
+- (RBLogSinkChannel *)addSink:(id<RBLogSink>)sink capacity:(NSUInteger)capacity overflowPolicy:(RBLogSinkOverflowPolicy)policy;
+
+/**
+ * Removes a sink added with -addSink:. Threadsafe.
+ *
+ * @param sink The sink to remove.
+ */
+- (void)removeSink:(id<RBLogSink>)sink;
+
 /**
  * Returns the log file for the given date. There may or may not be an actual 
  * file underneath the RBLogFile.
@@ -70,18 +277,78 @@
  */
 + (id<RBLogFile>)logFileForDate:(NSDate *)date;
 
+/**
+ * Returns the messages logged between the given dates by the default logger. 
+ * The log files are found with the log file index, and each file is read from 
+ * the offset its sidecar index gives for the start date, so only about the 
+ * bytes returned are read. Pending messages are written first. Must not be 
+ * called from the loggerQueue.
+ *
+ * @param startDate The start of the range, inclusive.
+ * @param endDate The end of the range, inclusive.
+ * @param error An error is returned by reference if a log file can't be read.
+ *
+ * @return An array of RBLogRecords in the order they were logged, or nil if a 
+ * log file can't be read.
+ */
++ (NSArray *)recordsFromDate:(NSDate *)startDate toDate:(NSDate *)endDate error:(NSError **)error;
+
+/**
+ * Returns the messages logged by the default logger that contain the given 
+ * string, searching every log file on disk in parallel with RBLogSearch. 
+ * Pending messages are written first. Must not be called from the loggerQueue.
+ *
+ * @param string The string to search for. Case sensitive.
+ * @param error An error is returned by reference if a log file can't be read.
+ *
+ * @return An array of RBLogRecords in the order they were logged, or nil if a 
+ * log file can't be read.
+ */
++ (NSArray *)recordsContainingString:(NSString *)string error:(NSError **)error;
+
 /** 
- * Returns the log file that the logger is currently using.
+ * Returns the log file that the logger is currently using. The log file is 
+ * kept between messages and only replaced when the day changes (UTC). Should 
+ * only be called from the loggerQueue.
  *
  * @return The log file that the logger is currently using.
  */
 - (id<RBLogFile>)currentLogFile;
 
+/**
+ * Writes any queued or buffered messages to the underlying log file before 
+ * returning. Threadsafe, but must not be called from the loggerQueue.
+ */
+- (void)flush;
+
+/**
+ * Returns the total size in bytes of the log files on disk, taken from the log 
+ * file index. Threadsafe, but must not be called from the loggerQueue.
+ *
+ * @return The total size of the log files.
+ */
+- (unsigned long long)totalLogFileSize;
+
+/**
+ * Returns the paths of the log files that may contain messages logged between 
+ * the given dates, from oldest to newest. Uses the log file index, so no files 
+ * are opened or stat'ed. Pending messages are written first. Threadsafe, but 
+ * must not be called from the loggerQueue.
+ *
+ * @param startDate The start of the range.
+ * @param endDate The end of the range.
+ *
+ * @return An array of file paths. Compressed files end in ".gz".
+ */
+- (NSArray *)logFilePathsFromDate:(NSDate *)startDate toDate:(NSDate *)endDate;
+
 /**
  * Deletes any log files older than the given limit in days. For example, if a
  * limit of 7 days is passed in, then all log files 8 days or older are deleted.
  * Log files may be automatically purged by setting the class constant 
  * 'kAutoPurgeLogFiles' to YES. Otherwise, this will need to be called manually.
+ * The purge runs asynchronously on the loggerQueue and walks the log file 
+ * index from the oldest file, so it only touches the files it deletes.
  * 
  * @param dayAgeLimit The max number of days of logs to keep. 
  */
@@ -102,4 +369,39 @@
  */
 + (RBLogger *)defaultLogger;
 
+/**
+ * Returns the logger with the given name, creating it the first time. Each 
+ * logger has its own loggerQueue, log files, index, flight recorder and 
+ * retention settings, so subsystems with their own loggers don't contend on 
+ * one queue or file. A new logger keeps its files in a subdirectory of the 
+ * default logger's directory named after it, and gets its own factory with 
+ * the default factory's logFileClass. Threadsafe.
+ *
+ * @param name The name. Must be usable as a directory name.
+ *
+ * @return The logger.
+ */
++ (RBLogger *)loggerNamed:(NSString *)name;
+
+/**
+ * Returns the logger with the given name, creating it with the given directory 
+ * and factory the first time. If the logger already exists, the directory and 
+ * factory are ignored. Threadsafe.
+ *
+ * @param name The name.
+ * @param directory The directory for the logger's files.
+ * @param factory The factory that creates the logger's log files.
+ *
+ * @return The logger.
+ */
++ (RBLogger *)loggerNamed:(NSString *)name directory:(NSString *)directory logFileFactory:(RBLogFileFactory *)factory;
+
+/**
+ * Returns every logger created so far, the default logger included once it 
+ * exists, sorted by name. Threadsafe.
+ *
+ * @return The RBLoggers.
+ */
++ (NSArray *)allLoggers;
+
 @end
@@ -23,12 +23,31 @@
 //
 
 #import <dispatch/dispatch.h>
+#import <sched.h>
+#import <stdatomic.h>
 
 #import "RBLogger.h"
 #import "NSString+RBExtras.h"
 #import "NSDate+RBExtras.h"
 #import "RBLogFileFactory.h"
+#import "RBLogRecord.h"
+#import "RBLogRingBuffer.h"
+#import "RBDeferredMessage.h"
+#import "RBConsoleLogSink.h"
+#import "RBLogSinkChannel.h"
+#import "RBFlightRecorder.h"
+#import "RBLogFileCompressor.h"
+#import "RBLogFileIndex.h"
+#import "RBLogOffsetIndex.h"
+#import "RBLogQuery.h"
+#import "RBLogSearch.h"
 #import "RBReporter.h"
+#import "RBStackRenderer.h"
+
+// iOS-specific imports
+#if TARGET_OS_IPHONE
+#import <UIKit/UIKit.h>
+#endif
 
 /**
  * The standard max age limit, in days, that log files should be kept around.
@@ -36,23 +55,91 @@
 static const NSUInteger kDefaultLogFileAgeLimit = 30;
 
 /** 
- * Whether or not the logger should purge old log files when the logger is 
+ * Whether or not loggers purge old log files by default when they are 
  * started. Log files are deemed old when their age in days is greater than 
- * kDefaultLogFileAgeLimit.
+ * the logger's logFileAgeLimit, which starts out as kDefaultLogFileAgeLimit.
  */
 static const BOOL kAutoPurgeLogFiles = YES;
 
+/**
+ * Whether or not the logger should gzip log files once it is done with them. 
+ * The previous day's file is compressed in the background when the day 
+ * changes, and any files left over from earlier launches are compressed when 
+ * the logger is started.
+ */
+static const BOOL kCompressRotatedLogFiles = YES;
+
+/**
+ * Whether or not each logger copies every message into a memory-mapped 
+ * flight recorder file in its directory as it is logged, so the messages 
+ * still queued when the app crashes can be recovered into the log file on the 
+ * next launch.
+ */
+static const BOOL kUseFlightRecorder = YES;
+
+/// The number of bytes of recent messages the flight recorder keeps.
+static const NSUInteger kFlightRecorderCapacity = 256 * 1024;
+
+/// The name of the flight recorder file in the log file directory.
+static NSString * const kFlightRecorderFileName = @"FlightRecorder.bin";
+
 /// The template to use for naming log files.
 static NSString * const kLogFileDateTemplate = @"yyyy-MM-dd";
 
-/// The extension to use for log files.
-static NSString * const kLogFileExtension = @"log";
-
 /// The name of the directory for the log files.
 static NSString * const kLogFileDirectoryName = @"LogFiles";
 
+/// The name of the default logger.
+static NSString * const kDefaultLoggerName = @"Default";
+
+/// The default max number of messages written in one batch.
+static const NSUInteger kDefaultMaxBatchSize = 256;
+
+/// The default max time, in seconds, a message waits to be written.
+static const NSTimeInterval kDefaultMaxBatchAge = 0.05;
+
+/// The default size at which a day's log file continues in a new segment.
+static const unsigned long long kDefaultMaxLogFileSize = 10 * 1024 * 1024;
+
+/// The default max total size of the log files.
+static const unsigned long long kDefaultLogDirectoryByteQuota = 100 * 1024 * 1024;
+
+/// The number of messages that may be waiting to be written.
+static const NSUInteger kPendingMessageCapacity = 4096;
+
+/// The number of records buffered for a sink added with -addSink:.
+static const NSUInteger kDefaultSinkCapacity = 4096;
 
-@interface RBLogger ()
+/// The number of stacks remembered as written in full to the active log file.
+static const NSUInteger kMaxRememberedStacks = 256;
+
+/// The key used to recognize the loggerQueue with dispatch_get_specific().
+static char kLoggerQueueKey;
+
+
+@interface RBLogger () {
+    
+    /// Whether a drain is waiting for maxBatchAge to pass.
+    _Atomic(bool) timedDrainScheduled;
+    
+    /// Whether a drain of a full batch is waiting on the loggerQueue.
+    _Atomic(bool) immediateDrainScheduled;
+    
+    /// The number of messages dropped because the pending queue was full.
+    _Atomic(NSUInteger) droppedCount;
+    
+    /// The number of messages accepted into the pending queue.
+    _Atomic(uint64_t) enqueuedCount;
+    
+    /// The number of drained messages written to the log file.
+    _Atomic(uint64_t) writtenCount;
+    
+    /// The number of bytes written to the log files.
+    _Atomic(uint64_t) bytesWrittenCount;
+    
+    /// The most messages found in the pending queue by a drain.
+    _Atomic(NSUInteger) maxQueueDepth;
+}
 
 /**
  * A lazy loaded date formatter for formmating the dates for the logger. Change 
@@ -64,6 +151,220 @@ static NSString * const kLogFileDirectoryName = @"LogFiles";
 /// A dispatch queue used for serializing requests.
 @property (nonatomic, assign, readwrite) dispatch_queue_t loggerQueue;
 
+/// The logger's name.
+@property (nonatomic, copy, readwrite) NSString * name;
+
+/// The directory the logger's files are kept in.
+@property (nonatomic, copy, readwrite) NSString * directory;
+
+/// Creates the logger's log files.
+@property (nonatomic, strong, readwrite) RBLogFileFactory * logFileFactory;
+
+/// The log file messages are currently written to. Only used on the loggerQueue.
+@property (nonatomic, strong) id<RBLogFile> activeLogFile;
+
+/**
+ * The absolute time (see CFAbsoluteTimeGetCurrent()) at which activeLogFile 
+ * must be replaced. This is always the next UTC midnight. Only used on the 
+ * loggerQueue.
+ */
+@property (nonatomic, assign) CFAbsoluteTime rolloverTime;
+
+/// The segment activeLogFile writes to. Only used on the loggerQueue.
+@property (nonatomic, strong) RBLogSegment * activeSegment;
+
+/// The paths of the log files being compressed. Only used on the loggerQueue.
+@property (nonatomic, strong) NSMutableSet * compressingPaths;
+
+/**
+ * The IDs of the exception stacks written in full to activeLogFile. Emptied 
+ * whenever another file is opened, so a stack written as a reference can 
+ * always be found earlier in the same file. Only used on the loggerQueue.
+ */
+@property (nonatomic, strong) NSMutableSet * writtenStacks;
+
+/// The messages that have been logged but not yet written.
+@property (nonatomic, strong) RBLogRingBuffer * pendingMessages;
+
+/// The RBLogSinkChannels fed each batch. Only used on the loggerQueue.
+@property (nonatomic, copy) NSArray * logSinks;
+
+/// Keeps a crash-proof copy of recent messages. Set before anything is logged.
+@property (nonatomic, strong) RBFlightRecorder * flightRecorder;
+
+/**
+ * The log files and their sizes. Created on the loggerQueue when the logger 
+ * starts and only used there afterwards.
+ */
+@property (nonatomic, strong) RBLogFileIndex * logFileIndex;
+
+/**
+ * The time from each message being logged to its batch being flushed.
+ */
+@property (nonatomic, strong) RBLatencyHistogram * diskLatencyHistogram;
+
+/**
+ * The time spent in each write and flush of the active log file.
+ */
+@property (nonatomic, strong) RBLatencyHistogram * writeTimeHistogram;
+
+/**
+ * The time spent in each purge by age, and each purge by quota that deleted files.
+ */
+@property (nonatomic, strong) RBLatencyHistogram * purgeTimeHistogram;
+
+/**
+ * The time spent in each log file rollover.
+ */
+@property (nonatomic, strong) RBLatencyHistogram * rotationTimeHistogram;
+
+/**
+ * Replaces the active log file with the newest segment of the day of the given 
+ * time and computes the next rollover time. Should only be called from the 
+ * loggerQueue.
+ *
+ * @param now The current absolute time.
+ */
+- (void)rollOverLogFileAtTime:(CFAbsoluteTime)now;
+
+/**
+ * Replaces the active log file with the next segment of the same day. Should 
+ * only be called from the loggerQueue.
+ */
+- (void)rollOverToNextSegment;
+
+/**
+ * Returns the first segment of the given day, starting at the given number, 
+ * that can be written to: one that isn't compressed on disk or being 
+ * compressed. Should only be called from the loggerQueue.
+ *
+ * @param day The day of the segment.
+ * @param number The lowest segment number to consider.
+ *
+ * @return The segment.
+ */
+- (RBLogSegment *)writableSegmentForDay:(NSString *)day number:(NSUInteger)number;
+
+/**
+ * Makes the given segment's log file the active log file. Should only be 
+ * called from the loggerQueue.
+ *
+ * @param segment The segment to write to.
+ */
+- (void)openSegment:(RBLogSegment *)segment;
+
+/**
+ * Closes the active log file and queues it for compression. Should only be 
+ * called from the loggerQueue.
+ */
+- (void)closeActiveLogFile;
+
+/**
+ * Deletes the oldest log files until the total size is within 
+ * logDirectoryByteQuota. Should only be called from the loggerQueue.
+ */
+- (void)enforceByteQuota;
+
+/**
+ * Deletes a segment's log file, compressed or not, and removes it from the 
+ * index.
+ *
+ * @param segment The segment to remove.
+ */
+- (void)removeSegment:(RBLogSegment *)segment;
+
+/**
+ * Deletes the log files for days older than the given number of days. Walks 
+ * the index from the oldest segment, so only the files deleted are touched. 
+ * Must be called on the loggerQueue.
+ *
+ * @param dayAgeLimit The number of days to keep log files for.
+ */
+- (void)purgeLogFilesOlderThanDays:(NSUInteger)dayAgeLimit;
+
+/**
+ * Queues the given message to be written to the log file. Threadsafe.
+ *
+ * @param msg The unformatted message.
+ * @param type What the message was created from.
+ * @param level How severe the message is.
+ */
+- (void)logMessage:(NSString *)msg type:(RBLogRecordType)type level:(RBLogLevel)level;
+
+/**
+ * Queues the given deferred message to be rendered and written on the 
+ * loggerQueue. Threadsafe.
+ *
+ * @param msg The deferred message.
+ * @param type What the message was created from.
+ * @param level How severe the message is.
+ */
+- (void)logDeferredMessage:(RBDeferredMessage *)msg type:(RBLogRecordType)type level:(RBLogLevel)level;
+
+/**
+ * Applies the overflowPolicy when the queue of pending messages is full. 
+ * Dropped messages are retired from the flightRecorder. Threadsafe.
+ *
+ * @param recordID The flight recorder ID of the new message.
+ *
+ * @return YES to try enqueuing again, NO if the new message was dropped.
+ */
+- (BOOL)makeRoomForMessage:(uint64_t)recordID;
+
+/**
+ * Makes sure a drain of the pending messages is scheduled. Full batches are 
+ * drained right away, others after maxBatchAge. Threadsafe.
+ */
+- (void)scheduleDrain;
+
+/**
+ * Returns whether the caller is running on the loggerQueue.
+ *
+ * @return YES if on the loggerQueue, NO otherwise.
+ */
+- (BOOL)isOnLoggerQueue;
+
+/**
+ * Takes all of the pending records and writes them to the log file as one 
+ * batch. Should only be called from the loggerQueue.
+ */
+- (void)drainPendingRecords;
+
+/**
+ * Writes the given records to the log files of the days they were logged on, 
+ * then flushes the active log file. Should only be called from the 
+ * loggerQueue.
+ *
+ * @param records The RBLogRecords to write, in the order they were logged.
+ */
+- (void)writeRecords:(NSArray *)records;
+
+/**
+ * Writes the given records to the active log file and records the bytes 
+ * written in the index. Moves on to the next segment once the file reaches 
+ * maxLogFileSize. Should only be called from the loggerQueue.
+ *
+ * @param records The RBLogRecords to write.
+ */
+- (void)writeRecordsToActiveLogFile:(NSArray *)records;
+
+/**
+ * Returns the given records with each exception stack already written to the 
+ * active log file replaced by a reference to its ID. Should only be called 
+ * from the loggerQueue.
+ *
+ * @param records The RBLogRecords about to be written.
+ *
+ * @return The records to write.
+ */
+- (NSArray *)recordsAbbreviatingWrittenStacks:(NSArray *)records;
+
+/**
+ * Flushes the active log file, if it supports flushing. Should only be called 
+ * from the loggerQueue.
+ */
+- (void)flushActiveLogFile;
+
 /**
  * Returns the path of the log file for the given date.
  *
@@ -79,35 +380,637 @@ static NSString * const kLogFileDirectoryName = @"LogFiles";
 + (NSString *)logFileDirectory;
 
 /**
- * Creates the log file directory if it hasn't already.
+ * Creates the logger's directory if it doesn't exist.
+ */
+- (void)createLogFileDirectory;
+
+/**
+ * Compresses the log file at the given path on a background queue, then 
+ * records the new size in the index. Does nothing if the file is already 
+ * being compressed. Should only be called from the loggerQueue.
+ *
+ * @param path The path of the log file to compress.
+ */
+- (void)compressLogFileAtPath:(NSString *)path;
+
+/**
+ * Compresses every uncompressed log file except the current day's. Should 
+ * only be called from the loggerQueue, after anything recovered from the 
+ * flightRecorder has been written.
+ */
+- (void)compressRotatedLogFiles;
+
+/**
+ * Returns whether the given file name is that of a log file, compressed or not.
+ *
+ * @param fileName The file name to check.
+ *
+ * @return YES if the file is a log file, NO otherwise.
  */
-+ (void)createLogFileDirectory;
++ (BOOL)isLogFileName:(NSString *)fileName;
+
+/**
+ * Standard initializer. Starts the logger.
+ *
+ * @param name The logger's name.
+ * @param directory The directory for the logger's files.
+ * @param factory The factory that creates the logger's log files.
+ *
+ * @return self
+ */
+- (id)initWithName:(NSString *)name directory:(NSString *)directory logFileFactory:(RBLogFileFactory *)factory;
+
+/**
+ * Creates the loggerQueue and the directory, recovers the flight recorder and 
+ * schedules loading the index and purging old files. Called once, by the 
+ * initializer.
+ */
+- (void)start;
+
+/**
+ * Returns the loggers created so far, keyed by name. Only used while 
+ * synchronized on the RBLogger class.
+ *
+ * @return The loggers.
+ */
++ (NSMutableDictionary *)loggersByName;
 
 @end
 
 
 @implementation RBLogger
 
-@synthesize dateFormatter, loggerQueue;
+@synthesize dateFormatter, loggerQueue, activeLogFile, activeSegment, compressingPaths, writtenStacks, rolloverTime, pendingMessages, logFileIndex, logSinks, flightRecorder;
+@synthesize diskLatencyHistogram, writeTimeHistogram, purgeTimeHistogram, rotationTimeHistogram;
+@synthesize maxBatchSize, maxBatchAge, overflowPolicy, maxLogFileSize, logDirectoryByteQuota;
+@synthesize name, directory, logFileFactory, logFileAgeLimit;
+
+- (id)init {
+    return [self initWithName:kDefaultLoggerName 
+                    directory:[[self class] logFileDirectory] 
+               logFileFactory:[RBLogFileFactory defaultFactory]];
+}
+
+- (id)initWithName:(NSString *)aName directory:(NSString *)aDirectory logFileFactory:(RBLogFileFactory *)factory {
+    
+    if ((self = [super init])) {
+        [self setName:aName];
+        [self setDirectory:aDirectory];
+        [self setLogFileFactory:factory];
+        [self setLogFileAgeLimit:kAutoPurgeLogFiles ? kDefaultLogFileAgeLimit : 0];
+        [self setPendingMessages:[[RBLogRingBuffer alloc] initWithCapacity:kPendingMessageCapacity]];
+        [self setLogSinks:[NSArray array]];
+        [self setCompressingPaths:[NSMutableSet set]];
+        [self setWrittenStacks:[NSMutableSet set]];
+        [self setMaxBatchSize:kDefaultMaxBatchSize];
+        [self setMaxBatchAge:kDefaultMaxBatchAge];
+        [self setOverflowPolicy:RBLogOverflowDropOldest];
+        [self setMaxLogFileSize:kDefaultMaxLogFileSize];
+        [self setLogDirectoryByteQuota:kDefaultLogDirectoryByteQuota];
+        [self setDiskLatencyHistogram:[RBLatencyHistogram new]];
+        [self setWriteTimeHistogram:[RBLatencyHistogram new]];
+        [self setPurgeTimeHistogram:[RBLatencyHistogram new]];
+        [self setRotationTimeHistogram:[RBLatencyHistogram new]];
+        atomic_init(&timedDrainScheduled, false);
+        atomic_init(&immediateDrainScheduled, false);
+        atomic_init(&droppedCount, 0);
+        atomic_init(&enqueuedCount, 0);
+        atomic_init(&writtenCount, 0);
+        atomic_init(&bytesWrittenCount, 0);
+        atomic_init(&maxQueueDepth, 0);
+        [self start];
+    }
+    
+    return self;
+}
+
+- (void)start {
+    
+    [self createLogFileDirectory];
+    
+    // Sets up the dispatch queue. Each logger has its own, so loggers write in parallel.
+    NSString * label = [NSString stringWithFormat:@"com.RobertBrown.RBLoggerQueue.%@", [self name]];
+    dispatch_queue_t queue = dispatch_queue_create([label UTF8String], NULL);
+    dispatch_set_target_queue(queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0));
+    dispatch_queue_set_specific(queue, &kLoggerQueueKey, (__bridge void *)self, NULL);
+    [self setLoggerQueue:queue];
+    
+    // Takes what the last launch left in the flight recorder before anything new is recorded.
+    NSArray * recoveredRecords = nil;
+    NSError * recorderError = nil;
+    
+    if (kUseFlightRecorder) {
+        
+        NSString * recorderPath = [[self directory] stringByAppendingPathComponent:kFlightRecorderFileName];
+        RBFlightRecorder * recorder = [[RBFlightRecorder alloc] initWithPath:recorderPath 
+                                                                    capacity:kFlightRecorderCapacity 
+                                                                       error:&recorderError];
+        
+        recoveredRecords = [recorder recoverRecords];
+        [self setFlightRecorder:recorder];
+    }
+    
+    // Mirrors records to the console in the build configurations that want it.
+    if (RB_CONSOLE_LOGGING)
+        [self addSink:[RBConsoleLogSink new]];
+    
+    // Loads the saved log file index. Everything after this is tracked as it is written.
+    dispatch_async(queue, ^{
+        [self setLogFileIndex:[[RBLogFileIndex alloc] initWithDirectory:[self directory]]];
+        [[self logFileIndex] saveIfNeeded];
+        
+        // RBReporter can't be used until the default logger exists.
+        if (recorderError)
+            [self logError:recorderError];
+        
+        // Writes the messages that were lost when the last launch ended into their day's files.
+        if ([recoveredRecords count] > 0) {
+            
+            NSString * note = [NSString stringWithFormat:@"Recovered %lu messages logged before the previous launch ended.", 
+                               (unsigned long)[recoveredRecords count]];
+            
+            [self writeRecords:recoveredRecords];
+            [self writeRecords:[NSArray arrayWithObject:[RBLogRecord recordWithMessage:note]]];
+            [[self logFileIndex] saveIfNeeded];
+        }
+        
+        // Auto-purges old log files if activated. Costs nothing when none are old enough.
+        if ([self logFileAgeLimit] > 0)
+            [self purgeLogFilesOlderThanDays:[self logFileAgeLimit]];
+        
+        // Compresses files left uncompressed by earlier launches. Waits until now so 
+        // the recovered records aren't written to a file while it is compressed.
+        if (kCompressRotatedLogFiles)
+            [self compressRotatedLogFiles];
+    });
+    
+#if TARGET_OS_IPHONE
+    
+    // Makes sure buffered messages reach the disk before the app may be killed.
+    NSNotificationCenter * center = [NSNotificationCenter defaultCenter];
+    void (^flushBlock)(NSNotification *) = ^(NSNotification * note) {
+        [self flush];
+    };
+    
+    [center addObserverForName:UIApplicationDidEnterBackgroundNotification
+                        object:nil
+                         queue:nil
+                    usingBlock:flushBlock];
+    [center addObserverForName:UIApplicationWillTerminateNotification
+                        object:nil
+                         queue:nil
+                    usingBlock:flushBlock];
+    
+#endif
+}
 
 - (void)logError:(NSError *)error {
-    [self logMessage:[NSString stringWithError:error]];
+    
+    // The error is turned into a string on the loggerQueue.
+    if (error && RBLogLevelIsEnabled(RBLogLevelError))
+        [self logDeferredMessage:[[RBDeferredMessage alloc] initWithError:error] type:RBLogRecordTypeError level:RBLogLevelError];
 }
 
 - (void)logException:(NSException *)exception {
-    [self logMessage:[NSString stringWithException:exception]];
+    
+    if (exception && RBLogLevelIsEnabled(RBLogLevelFault))
+        [self logDeferredMessage:[[RBDeferredMessage alloc] initWithException:exception] type:RBLogRecordTypeException level:RBLogLevelFault];
 }
 
 - (void)logMessage:(NSString *)msg {
+    [self logMessage:msg level:RBLogLevelInfo];
+}
+
+- (void)logMessage:(NSString *)msg level:(RBLogLevel)level {
+    
+    if (RBLogLevelIsEnabled(level))
+        [self logMessage:msg type:RBLogRecordTypeMessage level:level];
+}
+
+- (void)logWithLevel:(RBLogLevel)level format:(NSString *)format, ... {
+    
+    va_list arguments;
+    va_start(arguments, format);
+    [self logWithLevel:level format:format arguments:arguments];
+    va_end(arguments);
+}
+
+- (void)logWithLevel:(RBLogLevel)level format:(NSString *)format arguments:(va_list)arguments {
+    
+    if (!format || !RBLogLevelIsEnabled(level))
+        return;
+    
+    RBDeferredMessage * deferred = [[RBDeferredMessage alloc] initWithFormat:format arguments:arguments];
+    
+    // Formats that can't be captured are formatted right away.
+    if (deferred)
+        [self logDeferredMessage:deferred type:RBLogRecordTypeMessage level:level];
+    else
+        [self logMessage:[[NSString alloc] initWithFormat:format arguments:arguments] type:RBLogRecordTypeMessage level:level];
+}
+
+- (void)logMessage:(NSString *)msg type:(RBLogRecordType)type level:(RBLogLevel)level {
+    
+    CFAbsoluteTime timestamp = CFAbsoluteTimeGetCurrent();
+    RBLogRingBuffer * pending = [self pendingMessages];
+    
+    uint64_t recordID = [[self flightRecorder] recordMessage:msg type:type level:level timestamp:timestamp];
+    
+    // The common case is a single copy into a free slot.
+    while (![pending enqueueMessage:msg type:type level:level timestamp:timestamp tag:recordID]) {
+        
+        if (![self makeRoomForMessage:recordID])
+            return;
+    }
+    
+    atomic_fetch_add_explicit(&enqueuedCount, 1, memory_order_relaxed);
+    [self scheduleDrain];
+}
+
+- (void)logDeferredMessage:(RBDeferredMessage *)msg type:(RBLogRecordType)type level:(RBLogLevel)level {
+    
+    CFAbsoluteTime timestamp = CFAbsoluteTimeGetCurrent();
+    RBLogRingBuffer * pending = [self pendingMessages];
+    
+    // Records a stand-in, since rendering here would defeat deferring.
+    uint64_t recordID = [[self flightRecorder] recordMessage:[msg unrenderedMessage] type:type level:level timestamp:timestamp];
+    
+    while (![pending enqueueDeferredMessage:msg type:type level:level timestamp:timestamp tag:recordID]) {
+        
+        if (![self makeRoomForMessage:recordID])
+            return;
+    }
+    
+    atomic_fetch_add_explicit(&enqueuedCount, 1, memory_order_relaxed);
+    [self scheduleDrain];
+}
+
+- (BOOL)makeRoomForMessage:(uint64_t)recordID {
+    
+    RBLogRingBuffer * pending = [self pendingMessages];
+    uint64_t discardedID = 0;
+    
+    switch ([self overflowPolicy]) {
+            
+        case RBLogOverflowDropNewest:
+            [[self flightRecorder] retireRecord:recordID];
+            atomic_fetch_add_explicit(&droppedCount, 1, memory_order_relaxed);
+            return NO;
+            
+        case RBLogOverflowDropOldest:
+            if ([pending discardOldestWithTag:&discardedID]) {
+                [[self flightRecorder] retireRecord:discardedID];
+                atomic_fetch_add_explicit(&droppedCount, 1, memory_order_relaxed);
+            }
+            break;
+            
+        case RBLogOverflowBlock:
+            
+            // Waiting on the loggerQueue would deadlock, so makes room here instead.
+            if ([self isOnLoggerQueue]) {
+                [self drainPendingRecords];
+            }
+            else {
+                [self scheduleDrain];
+                sched_yield();
+            }
+            break;
+    }
+    
+    return YES;
+}
+
+- (void)scheduleDrain {
+    
+    // Checks the flags before exchanging them so most calls don't write to shared memory.
+    if ([[self pendingMessages] count] >= [self maxBatchSize]) {
+        
+        if (!atomic_load_explicit(&immediateDrainScheduled, memory_order_relaxed) &&
+            !atomic_exchange(&immediateDrainScheduled, true)) {
+            
+            dispatch_async([self loggerQueue], ^{
+                atomic_store(&self->immediateDrainScheduled, false);
+                [self drainPendingRecords];
+            });
+        }
+    }
+    else if (!atomic_load_explicit(&timedDrainScheduled, memory_order_relaxed) &&
+             !atomic_exchange(&timedDrainScheduled, true)) {
+        
+        int64_t delay = (int64_t)([self maxBatchAge] * NSEC_PER_SEC);
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delay), [self loggerQueue], ^{
+            atomic_store(&self->timedDrainScheduled, false);
+            [self drainPendingRecords];
+        });
+    }
+}
+
+- (BOOL)isOnLoggerQueue {
+    return dispatch_get_specific(&kLoggerQueueKey) == (__bridge void *)self;
+}
+
+- (void)drainPendingRecords {
+    
+    RBLogRingBuffer * pending = [self pendingMessages];
+    
+    // Stops after one buffer's worth so busy producers can't keep the drain going forever.
+    NSUInteger limit = [pending capacity];
+    NSUInteger depth = [pending count];
+    NSMutableArray * records = [NSMutableArray arrayWithCapacity:MIN(depth, limit)];
+    NSMutableData * recordIDs = [NSMutableData dataWithCapacity:MIN(depth, limit) * sizeof(uint64_t)];
+    RBLogRecord * record = nil;
+    uint64_t recordID = 0;
+    
+    // Only the loggerQueue writes the max, so there's no need for a compare and swap.
+    if (depth > atomic_load_explicit(&maxQueueDepth, memory_order_relaxed))
+        atomic_store_explicit(&maxQueueDepth, depth, memory_order_relaxed);
+    
+    while ([records count] < limit && (record = [pending dequeueRecordWithTag:&recordID])) {
+        [records addObject:record];
+        [recordIDs appendBytes:&recordID length:sizeof(recordID)];
+    }
+    
+    if ([records count] == 0)
+        return;
+    
+    [self writeRecords:records];
+    
+    // The records have been handed to the kernel, so a crash no longer loses them.
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    RBLatencyHistogram * latency = [self diskLatencyHistogram];
+    RBFlightRecorder * flightRecorder = [self flightRecorder];
+    const uint64_t * writtenIDs = [recordIDs bytes];
+    NSUInteger index = 0;
+    
+    for (RBLogRecord * written in records) {
+        [latency recordDuration:now - [written timestamp]];
+        [flightRecorder retireRecord:writtenIDs[index++]];
+    }
+    
+    atomic_fetch_add_explicit(&writtenCount, [records count], memory_order_relaxed);
+    
+    // Only copies the records into each sink's buffer; the sinks write on their own queues.
+    for (RBLogSinkChannel * channel in [self logSinks])
+        [channel enqueueRecords:records];
+}
+
+- (void)writeRecords:(NSArray *)records {
+    
+    NSUInteger count = [records count];
+    NSUInteger start = 0;
+    
+    if (![self activeLogFile])
+        [self rollOverLogFileAtTime:[[records objectAtIndex:0] timestamp]];
+    
+    // Writes each run of records to the file of the day they were logged on.
+    for (NSUInteger i = 0; i < count; i++) {
+        
+        CFAbsoluteTime timestamp = [[records objectAtIndex:i] timestamp];
+        
+        if (timestamp >= [self rolloverTime]) {
+            
+            NSArray * run = [records subarrayWithRange:NSMakeRange(start, i - start)];
+            [self writeRecordsToActiveLogFile:run];
+            [self rollOverLogFileAtTime:timestamp];
+            start = i;
+        }
+    }
+    
+    NSArray * run = [records subarrayWithRange:NSMakeRange(start, count - start)];
+    [self writeRecordsToActiveLogFile:run];
+    [self flushActiveLogFile];
+    [self enforceByteQuota];
+}
+
+- (void)writeRecordsToActiveLogFile:(NSArray *)records {
+    
+    if ([records count] == 0)
+        return;
+    
+    id<RBLogFile> logFile = [self activeLogFile];
+    BOOL tracksSize = [logFile respondsToSelector:@selector(fileSize)];
+    unsigned long long sizeBefore = tracksSize ? [(id)logFile fileSize] : 0;
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    records = [self recordsAbbreviatingWrittenStacks:records];
+    
+    if ([logFile respondsToSelector:@selector(writeRecords:error:)]) {
+        [logFile writeRecords:records error:NULL];
+    }
+    else {
+        
+        for (RBLogRecord * record in records)
+            [logFile write:[record message]];
+    }
+    
+    [[self writeTimeHistogram] recordDurationSince:start];
+    
+    if (!tracksSize)
+        return;
+    
+    unsigned long long sizeAfter = [(id)logFile fileSize];
+    
+    NSString * fileName = [[self activeSegment] fileName];
+    RBLogFileIndex * index = [self logFileIndex];
+    
+    if (sizeAfter > sizeBefore) {
+        [index addByteCount:sizeAfter - sizeBefore toSegmentWithFileName:fileName];
+        atomic_fetch_add_explicit(&bytesWrittenCount, sizeAfter - sizeBefore, memory_order_relaxed);
+    }
+    
+    // Threads can enqueue records slightly out of time order, so the ends of 
+    // the batch don't always bound it.
+    CFAbsoluteTime earliest = [[records objectAtIndex:0] timestamp];
+    CFAbsoluteTime latest = earliest;
+    
+    for (RBLogRecord * record in records) {
+        
+        CFAbsoluteTime timestamp = [record timestamp];
+        
+        if (timestamp < earliest)
+            earliest = timestamp;
+        else if (timestamp > latest)
+            latest = timestamp;
+    }
+    
+    [index includeTimestampsFrom:earliest to:latest inSegmentWithFileName:fileName];
+    
+    // A single bad day can't grow one file without bound.
+    if ([self maxLogFileSize] > 0 && sizeAfter >= [self maxLogFileSize])
+        [self rollOverToNextSegment];
+}
+
+- (NSArray *)recordsAbbreviatingWrittenStacks:(NSArray *)records {
+    
+    NSMutableSet * written = [self writtenStacks];
+    NSMutableArray * result = nil;
+    NSUInteger index = 0;
+    
+    for (RBLogRecord * record in records) {
+        
+        NSString * stackID = [record type] == RBLogRecordTypeException ? [RBStackRenderer stackIDOfDescription:[record message]] : nil;
+        
+        if (stackID && [written containsObject:stackID]) {
+            
+            // Copies the array only once there is something to replace.
+            if (!result)
+                result = [records mutableCopy];
+            
+            RBLogRecord * abbreviated = [[RBLogRecord alloc] initWithMessage:[RBStackRenderer abbreviatedDescription:[record message]] 
+                                                                        type:[record type] 
+                                                                       level:[record level] 
+                                                                   timestamp:[record timestamp]];
+            [result replaceObjectAtIndex:index withObject:abbreviated];
+        }
+        else if (stackID) {
+            
+            // Starting over only means a stack is written in full again.
+            if ([written count] >= kMaxRememberedStacks)
+                [written removeAllObjects];
+            
+            [written addObject:stackID];
+        }
+        
+        index++;
+    }
+    
+    return result ? result : records;
+}
+
+- (void)flushActiveLogFile {
+    
+    id<RBLogFile> logFile = [self activeLogFile];
+    
+    if ([logFile respondsToSelector:@selector(flush:)]) {
+        
+        CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+        [logFile flush:NULL];
+        [[self writeTimeHistogram] recordDurationSince:start];
+    }
+}
+
+- (NSUInteger)droppedMessageCount {
+    return atomic_load_explicit(&droppedCount, memory_order_relaxed);
+}
+
+- (RBLoggerStatistics)statistics {
+    
+    RBLoggerStatistics statistics;
+    
+    statistics.messagesEnqueued = atomic_load_explicit(&enqueuedCount, memory_order_relaxed);
+    statistics.messagesWritten = atomic_load_explicit(&writtenCount, memory_order_relaxed);
+    statistics.messagesDropped = atomic_load_explicit(&droppedCount, memory_order_relaxed);
+    statistics.bytesWritten = atomic_load_explicit(&bytesWrittenCount, memory_order_relaxed);
+    statistics.queueDepth = [[self pendingMessages] count];
+    statistics.maxQueueDepth = atomic_load_explicit(&maxQueueDepth, memory_order_relaxed);
+    statistics.diskLatency = [[self diskLatencyHistogram] summary];
+    statistics.writeTime = [[self writeTimeHistogram] summary];
+    statistics.purgeTime = [[self purgeTimeHistogram] summary];
+    statistics.rotationTime = [[self rotationTimeHistogram] summary];
+    
+    return statistics;
+}
+
+- (NSString *)statisticsReport {
+    
+    RBLoggerStatistics statistics = [self statistics];
+    NSMutableString * report = [NSMutableString string];
+    
+    [report appendFormat:@"Messages: %llu enqueued, %llu written, %llu dropped\n", 
+     statistics.messagesEnqueued, statistics.messagesWritten, statistics.messagesDropped];
+    [report appendFormat:@"Bytes written: %llu\n", statistics.bytesWritten];
+    [report appendFormat:@"Queue depth: %lu (max %lu of %lu)\n", 
+     (unsigned long)statistics.queueDepth, (unsigned long)statistics.maxQueueDepth, (unsigned long)[[self pendingMessages] capacity]];
+    [report appendFormat:@"Disk latency: %@\n", [RBLatencyHistogram descriptionOfSummary:statistics.diskLatency]];
+    [report appendFormat:@"Write time: %@\n", [RBLatencyHistogram descriptionOfSummary:statistics.writeTime]];
+    [report appendFormat:@"Purge time: %@\n", [RBLatencyHistogram descriptionOfSummary:statistics.purgeTime]];
+    [report appendFormat:@"Rotation time: %@\n", [RBLatencyHistogram descriptionOfSummary:statistics.rotationTime]];
+    
+    for (RBLogSinkChannel * channel in [self logSinks]) {
+        
+        RBLogSinkStatistics sinkStatistics = [channel statistics];
+        
+        [report appendFormat:@"Sink %@: %llu written, %llu dropped, %lu pending, max write %.1f ms, max latency %.1f ms\n", 
+         NSStringFromClass([[channel sink] class]), sinkStatistics.recordsWritten, sinkStatistics.recordsDropped, 
+         (unsigned long)sinkStatistics.recordsPending, sinkStatistics.maxWriteTime * 1000.0, sinkStatistics.maxLatency * 1000.0];
+    }
+    
+    return report;
+}
+
+- (void)flush {
+    
+    dispatch_sync([self loggerQueue], ^{
+        [self drainPendingRecords];
+        [self flushActiveLogFile];
+        [[self logFileIndex] saveIfNeeded];
+        
+        for (RBLogSinkChannel * channel in [self logSinks])
+            [channel flush];
+    });
+}
+
+- (RBLogSinkChannel *)addSink:(id<RBLogSink>)sink {
+    return [self addSink:sink capacity:kDefaultSinkCapacity overflowPolicy:RBLogSinkDropOldest];
+}
+
+- (RBLogSinkChannel *)addSink:(id<RBLogSink>)sink capacity:(NSUInteger)capacity overflowPolicy:(RBLogSinkOverflowPolicy)policy {
+    
+    RBLogSinkChannel * channel = [[RBLogSinkChannel alloc] initWithSink:sink capacity:capacity overflowPolicy:policy];
     
-    // Uses some GCD magic to serialize the requests and to avoid holding up the calling thread.
     dispatch_async([self loggerQueue], ^{
+        [self setLogSinks:[[self logSinks] arrayByAddingObject:channel]];
+    });
+    
+    return channel;
+}
+
+- (void)removeSink:(id<RBLogSink>)sink {
+    
+    dispatch_async([self loggerQueue], ^{
+        
+        NSMutableArray * channels = [NSMutableArray arrayWithCapacity:[[self logSinks] count]];
+        
+        for (RBLogSinkChannel * channel in [self logSinks])
+            if ([channel sink] != sink)
+                [channels addObject:channel];
         
-        // Writes to the log file.
-        [[self currentLogFile] write:msg];
+        [self setLogSinks:channels];
     });
 }
 
+- (unsigned long long)totalLogFileSize {
+    
+    __block unsigned long long size = 0;
+    
+    dispatch_sync([self loggerQueue], ^{
+        size = [[self logFileIndex] totalByteCount];
+    });
+    
+    return size;
+}
+
+- (NSArray *)logFilePathsFromDate:(NSDate *)startDate toDate:(NSDate *)endDate {
+    
+    NSMutableArray * paths = [NSMutableArray array];
+    NSString * logDir = [self directory];
+    
+    dispatch_sync([self loggerQueue], ^{
+        
+        // Buffered messages have to be on disk before the caller reads the files.
+        [self drainPendingRecords];
+        [self flushActiveLogFile];
+        
+        NSArray * segments = [[self logFileIndex] segmentsFromTime:[startDate timeIntervalSinceReferenceDate]
+                                                            toTime:[endDate timeIntervalSinceReferenceDate]];
+        
+        for (RBLogSegment * segment in segments)
+            [paths addObject:[logDir stringByAppendingPathComponent:[segment diskFileName]]];
+    });
+    
+    return paths;
+}
+
 + (id<RBLogFile>)logFileForDate:(NSDate *)date {
     
     // Gets the file path with the given date.
@@ -116,16 +1019,182 @@ static NSString * const kLogFileDirectoryName = @"LogFiles";
     return [[RBLogFileFactory defaultFactory] newLogFileWithPath:filePath];
 }
 
++ (NSArray *)recordsFromDate:(NSDate *)startDate toDate:(NSDate *)endDate error:(NSError **)error {
+    
+    NSArray * paths = [[self defaultLogger] logFilePathsFromDate:startDate toDate:endDate];
+    RBLogQuery * query = [[RBLogQuery alloc] initWithStartTime:[startDate timeIntervalSinceReferenceDate]
+                                                       endTime:[endDate timeIntervalSinceReferenceDate]];
+    
+    return [query recordsInLogFilesAtPaths:paths error:error];
+}
+
++ (NSArray *)recordsContainingString:(NSString *)string error:(NSError **)error {
+    
+    NSArray * paths = [[self defaultLogger] logFilePathsFromDate:[NSDate distantPast] toDate:[NSDate distantFuture]];
+    RBLogSearch * search = [[RBLogSearch alloc] initWithSearchString:string];
+    
+    return [search recordsInLogFilesAtPaths:paths error:error];
+}
+
 - (id<RBLogFile>)currentLogFile {
     
-    return [[self class] logFileForDate:[NSDate date]];
+    // A single comparison per message. The file only changes at midnight.
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    
+    if (![self activeLogFile] || now >= [self rolloverTime])
+        [self rollOverLogFileAtTime:now];
+    
+    return [self activeLogFile];
+}
+
+- (void)rollOverLogFileAtTime:(CFAbsoluteTime)now {
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    // Releases the previous day's file.
+    [self closeActiveLogFile];
+    
+    NSDate * date = [NSDate dateWithTimeIntervalSinceReferenceDate:now];
+    NSString * day = [[self dateFormatter] stringFromDate:date];
+    
+    // Continues the day's newest segment, unless it has already been compressed.
+    RBLogSegment * lastSegment = [[self logFileIndex] lastSegmentForDay:day];
+    NSUInteger number = 0;
+    
+    if (lastSegment)
+        number = [lastSegment number] + ([lastSegment isCompressed] ? 1 : 0);
+    
+    [self openSegment:[self writableSegmentForDay:day number:number]];
+    
+    // The reference date is a UTC midnight, so the next midnight is a multiple of a day.
+    [self setRolloverTime:(floor(now / ONE_DAY) + 1.0) * ONE_DAY];
+    [[self rotationTimeHistogram] recordDurationSince:start];
+}
+
+- (void)rollOverToNextSegment {
+    
+    RBLogSegment * segment = [self activeSegment];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    [self closeActiveLogFile];
+    [self openSegment:[self writableSegmentForDay:[segment day] number:[segment number] + 1]];
+    [[self rotationTimeHistogram] recordDurationSince:start];
+}
+
+- (RBLogSegment *)writableSegmentForDay:(NSString *)day number:(NSUInteger)number {
+    
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    
+    // The index can be behind the disk if the last launch ended before saving it. 
+    // Writing next to a compressed file would get the plain file compressed over it.
+    while (YES) {
+        
+        RBLogSegment * segment = [[RBLogSegment alloc] initWithDay:day number:number];
+        NSString * path = [[self directory] stringByAppendingPathComponent:[segment fileName]];
+        
+        if (![[self compressingPaths] containsObject:path] &&
+            ![fileManager fileExistsAtPath:[RBLogFileCompressor compressedPathForPath:path]])
+            return segment;
+        
+        number++;
+    }
+}
+
+- (void)openSegment:(RBLogSegment *)segment {
+    
+    NSString * path = [[self directory] stringByAppendingPathComponent:[segment fileName]];
+    id<RBLogFile> logFile = [[self logFileFactory] newLogFileWithPath:path];
+    
+    [self setActiveSegment:segment];
+    [self setActiveLogFile:logFile];
+    [[self writtenStacks] removeAllObjects];
+    
+    // Opens the file up front so its size, header included, is known to the index.
+    if ([logFile respondsToSelector:@selector(openFile:)] && [logFile respondsToSelector:@selector(fileSize)]) {
+        
+        [(id)logFile openFile:NULL];
+        
+        RBLogFileIndex * index = [self logFileIndex];
+        unsigned long long size = [(id)logFile fileSize];
+        unsigned long long indexedSize = [[index segmentWithFileName:[segment fileName]] byteCount];
+        
+        if (size > indexedSize)
+            [index addByteCount:size - indexedSize toSegmentWithFileName:[segment fileName]];
+    }
+}
+
+- (void)closeActiveLogFile {
+    
+    id<RBLogFile> oldLogFile = [self activeLogFile];
+    
+    if (!oldLogFile)
+        return;
+    
+    if ([oldLogFile respondsToSelector:@selector(closeFile)])
+        [oldLogFile closeFile];
+    
+    if (kCompressRotatedLogFiles && [oldLogFile respondsToSelector:@selector(filePath)])
+        [self compressLogFileAtPath:[(id)oldLogFile filePath]];
+    
+    [self setActiveLogFile:nil];
+    [self setActiveSegment:nil];
+    [[self logFileIndex] saveIfNeeded];
+}
+
+- (void)enforceByteQuota {
+    
+    RBLogFileIndex * index = [self logFileIndex];
+    unsigned long long quota = [self logDirectoryByteQuota];
+    
+    if (quota == 0 || !index)
+        return;
+    
+    if ([index totalByteCount] <= quota)
+        return;
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    // Evicts the oldest segments first, but never the one being written.
+    while ([index totalByteCount] > quota) {
+        
+        RBLogSegment * oldest = [index oldestSegment];
+        
+        if (!oldest || [[oldest fileName] isEqualToString:[[self activeSegment] fileName]])
+            break;
+        
+        [self removeSegment:oldest];
+    }
+    
+    [index saveIfNeeded];
+    [[self purgeTimeHistogram] recordDurationSince:start];
+}
+
+- (void)removeSegment:(RBLogSegment *)segment {
+    
+    NSString * path = [[self directory] stringByAppendingPathComponent:[segment fileName]];
+    NSFileManager * fileManager = [NSFileManager defaultManager];
+    NSError * error = nil;
+    
+    // Either file may be missing, depending on whether the segment was compressed.
+    if (![fileManager removeItemAtPath:path error:&error] && [fileManager fileExistsAtPath:path])
+        [RBReporter logError:error];
+    
+    NSString * compressedPath = [RBLogFileCompressor compressedPathForPath:path];
+    
+    if (![fileManager removeItemAtPath:compressedPath error:&error] && [fileManager fileExistsAtPath:compressedPath])
+        [RBReporter logError:error];
+    
+    // The offset index is only a hint for readers, so failing to delete it is ignored.
+    [fileManager removeItemAtPath:[RBLogOffsetIndex indexPathForLogFilePath:path] error:NULL];
+    
+    [[self logFileIndex] removeSegment:segment];
 }
 
 + (NSString *)logFilePathForDate:(NSDate *)date {
     
     // Generates the file name.
     NSString * formattedDate = [[[self defaultLogger] dateFormatter] stringFromDate:date];
-    NSString * fileName = [NSString stringWithFormat:@"LogFile%@.%@", formattedDate, kLogFileExtension];
+    NSString * fileName = [RBLogSegment fileNameForDay:formattedDate number:0];
     
     // Generates an array of path components.
     NSArray * pathComps = [NSArray arrayWithObjects:[self logFileDirectory], fileName, nil];
@@ -142,52 +1211,100 @@ static NSString * const kLogFileDirectoryName = @"LogFiles";
 
 + (void)purgeOldLogFiles:(NSUInteger)dayAgeLimit {
     
-    // Gets the log file directory.
-    NSString * logDir = [self logFileDirectory];
-    NSFileManager * fileManager = [NSFileManager defaultManager];
+    RBLogger * logger = [self defaultLogger];
     
-    // Gets all the files in the directory.
-    NSError * error = nil;
-    NSArray * files = [fileManager contentsOfDirectoryAtPath:logDir error:&error];
+    dispatch_async([logger loggerQueue], ^{
+        [logger purgeLogFilesOlderThanDays:dayAgeLimit];
+    });
+}
+
+- (void)purgeLogFilesOlderThanDays:(NSUInteger)dayAgeLimit {
     
-    if (error) {
-        [RBReporter logError:error];
-        return;
-    }
+    RBLogFileIndex * index = [self logFileIndex];
+    NSDate * cutoffDate = [NSDate dateWithTimeIntervalSinceNow:-(NSTimeInterval)dayAgeLimit * ONE_DAY];
+    NSString * cutoffDay = [[self dateFormatter] stringFromDate:cutoffDate];
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
     
-    // Iterates through all of the files and deletes any that are too old.
-    for (NSString * file in files) {
+    // Segments are sorted by day, so this stops at the first one young enough to keep.
+    for (RBLogSegment * oldest = [index oldestSegment]; oldest; oldest = [index oldestSegment]) {
         
-        NSString * path = [NSString pathWithComponents:[NSArray arrayWithObjects:[self logFileDirectory], file, nil]];
-        NSDictionary * attributes = [fileManager attributesOfItemAtPath:path error:&error];
+        if ([[oldest day] compare:cutoffDay] != NSOrderedAscending || 
+            [[oldest fileName] isEqualToString:[[self activeSegment] fileName]])
+            break;
         
-        if (error) {
-            [RBReporter logError:error];
-            error = nil;
-            continue;
-        }
+        [self removeSegment:oldest];
+    }
+    
+    [index saveIfNeeded];
+    [[self purgeTimeHistogram] recordDurationSince:start];
+}
+
+- (void)compressLogFileAtPath:(NSString *)path {
+    
+    // Closing a file and the startup sweep can both ask for the same file.
+    if ([[self compressingPaths] containsObject:path])
+        return;
+    
+    [[self compressingPaths] addObject:path];
+    
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_BACKGROUND, 0), ^{
         
-        NSDate * creationDate = [attributes valueForKey:NSFileCreationDate];
+        NSFileManager * fileManager = [NSFileManager defaultManager];
+        NSError * error = nil;
+        BOOL compressed = NO;
+        unsigned long long size = 0;
         
-        // If the log file is too old, then it is deleted.
-        if ([creationDate timeIntervalSinceDate:[NSDate date]] > dayAgeLimit * ONE_DAY && 
-            [[file pathExtension] isEqualToString:kLogFileExtension]) {
+        // Nothing to do if the day had no messages.
+        if ([fileManager fileExistsAtPath:path]) {
             
-            [fileManager removeItemAtPath:file error:&error];
+            compressed = [RBLogFileCompressor compressFileAtPath:path error:&error];
             
-            if (error) {
+            if (compressed) {
+                NSString * compressedPath = [RBLogFileCompressor compressedPathForPath:path];
+                size = [[fileManager attributesOfItemAtPath:compressedPath error:NULL] fileSize];
+            }
+            else {
                 [RBReporter logError:error];
-                error = nil;
-                continue;
             }
         }
+        
+        dispatch_async([self loggerQueue], ^{
+            
+            RBLogFileIndex * index = [self logFileIndex];
+            
+            [[self compressingPaths] removeObject:path];
+            
+            if (compressed) {
+                [index setCompressedByteCount:size forSegmentWithFileName:[path lastPathComponent]];
+                [index saveIfNeeded];
+            }
+        });
+    });
+}
+
+- (void)compressRotatedLogFiles {
+    
+    NSString * logDir = [self directory];
+    NSString * today = [[self dateFormatter] stringFromDate:[NSDate date]];
+    NSArray * files = [[NSFileManager defaultManager] contentsOfDirectoryAtPath:logDir error:NULL];
+    
+    for (NSString * file in files) {
+        
+        RBLogSegment * segment = [RBLogSegment segmentWithFileName:file];
+        
+        if (segment && ![segment isCompressed] && ![[segment day] isEqualToString:today])
+            [self compressLogFileAtPath:[logDir stringByAppendingPathComponent:file]];
     }
 }
 
-+ (void)createLogFileDirectory {
++ (BOOL)isLogFileName:(NSString *)fileName {
+    return [RBLogSegment segmentWithFileName:fileName] != nil;
+}
+
+- (void)createLogFileDirectory {
     
     NSFileManager * fileManager = [NSFileManager defaultManager];
-    NSString * logFileDir = [[self class] logFileDirectory];
+    NSString * logFileDir = [self directory];
     NSError * error = nil;
     
     // Creates the log file director if it hasn't already.
@@ -227,22 +1344,66 @@ static NSString * const kLogFileDirectoryName = @"LogFiles";
     dispatch_once(&onceToken, ^{
         _defaultLogger = [self new];
         
-        [self createLogFileDirectory];
-        
-        // Sets up the dispatch queue.
-        dispatch_queue_t queue = dispatch_queue_create("com.RobertBrown.RBLoggerQueue", NULL);
-        dispatch_set_target_queue(queue, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0));
-        [_defaultLogger setLoggerQueue:queue];
-        
-        // Auto-purges old log files if activated.
-        if (kAutoPurgeLogFiles) {
-            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
-                [[self class] purgeOldLogFiles:kDefaultLogFileAgeLimit];
-            });
+        @synchronized (self) {
+            [[self loggersByName] setObject:_defaultLogger forKey:[_defaultLogger name]];
         }
     });
     
     return _defaultLogger;
 }
 
++ (RBLogger *)loggerNamed:(NSString *)aName {
+    
+    // The default logger is created outside the lock, since creating it takes the lock too.
+    RBLogger * defaultLogger = [self defaultLogger];
+    
+    if ([aName isEqualToString:[defaultLogger name]])
+        return defaultLogger;
+    
+    RBLogFileFactory * factory = [RBLogFileFactory new];
+    [factory setLogFileClass:[[defaultLogger logFileFactory] logFileClass]];
+    
+    return [self loggerNamed:aName 
+                   directory:[[defaultLogger directory] stringByAppendingPathComponent:aName] 
+              logFileFactory:factory];
+}
+
++ (RBLogger *)loggerNamed:(NSString *)aName directory:(NSString *)aDirectory logFileFactory:(RBLogFileFactory *)factory {
+    
+    // Makes sure the default logger is registered before any other.
+    [self defaultLogger];
+    
+    @synchronized (self) {
+        
+        RBLogger * logger = [[self loggersByName] objectForKey:aName];
+        
+        if (!logger) {
+            logger = [[self alloc] initWithName:aName directory:aDirectory logFileFactory:factory];
+            [[self loggersByName] setObject:logger forKey:aName];
+        }
+        
+        return logger;
+    }
+}
+
++ (NSArray *)allLoggers {
+    
+    @synchronized (self) {
+        
+        NSArray * names = [[[self loggersByName] allKeys] sortedArrayUsingSelector:@selector(compare:)];
+        
+        return [[self loggersByName] objectsForKeys:names notFoundMarker:[NSNull null]];
+    }
+}
+
++ (NSMutableDictionary *)loggersByName {
+    
+    static NSMutableDictionary * _loggersByName = nil;
+    
+    if (!_loggersByName)
+        _loggersByName = [NSMutableDictionary dictionary];
+    
+    return _loggersByName;
+}
+
 @end
@@ -0,0 +1,49 @@
+//
+// RBMappedAttachment.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBStandardAttachment.h"
+
+
+/**
+ * A file attachment that memory-maps its file instead of reading it. Slices of 
+ * the file are handed out without copying, and pages that have been consumed 
+ * are given back to the system, so large log files never sit in the heap. The 
+ * file is mapped the first time it is needed and unmapped when the attachment 
+ * is deallocated.
+ */
+@interface RBMappedAttachment : RBStandardAttachment
+
+/**
+ * Returns the bytes in the given range of the file without copying them. The 
+ * data is only valid while the attachment is alive.
+ *
+ * @param range The range of bytes to return. Clamped to the file's length.
+ *
+ * @return The bytes in the range, or nil if the file can't be mapped.
+ */
+- (NSData *)dataInRange:(NSRange)range;
+
+@end
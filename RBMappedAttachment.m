@@ -0,0 +1,161 @@
+//
+// RBMappedAttachment.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBMappedAttachment.h"
+
+#import <fcntl.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+
+/// The size of the slices the mapped file is enumerated in.
+static const NSUInteger kMappedChunkSize = 256 * 1024;
+
+
+@interface RBMappedAttachment () {
+    
+    /// The start of the mapping, or NULL if the file isn't mapped.
+    void * mappedBytes;
+    
+    /// The length of the mapping.
+    size_t mappedLength;
+}
+
+/**
+ * Maps the file if it isn't mapped already. Empty files are never mapped.
+ *
+ * @param error An error is returned by reference if the file can't be mapped.
+ *
+ * @return YES if the file is mapped or empty, NO otherwise.
+ */
+- (BOOL)mapFile:(NSError **)error;
+
+@end
+
+
+@implementation RBMappedAttachment
+
+- (void)dealloc {
+    
+    if (mappedBytes)
+        munmap(mappedBytes, mappedLength);
+}
+
+- (NSData *)data {
+    return [self dataInRange:NSMakeRange(0, NSUIntegerMax)];
+}
+
+- (unsigned long long)length {
+    
+    if (![self mapFile:NULL])
+        return 0;
+    
+    return mappedLength;
+}
+
+- (NSData *)dataInRange:(NSRange)range {
+    
+    if (![self mapFile:NULL])
+        return nil;
+    
+    NSUInteger location = MIN(range.location, mappedLength);
+    NSUInteger length = MIN(range.length, mappedLength - location);
+    
+    if (length == 0)
+        return [NSData data];
+    
+    return [NSData dataWithBytesNoCopy:(char *)mappedBytes + location length:length freeWhenDone:NO];
+}
+
+- (BOOL)enumerateChunksUsingBlock:(void (^)(const void *, NSUInteger, BOOL *))block error:(NSError **)error {
+    
+    if (![self mapFile:error])
+        return NO;
+    
+    if (mappedLength > 0)
+        madvise(mappedBytes, mappedLength, MADV_SEQUENTIAL);
+    
+    BOOL stop = NO;
+    
+    for (size_t offset = 0; !stop && offset < mappedLength; offset += kMappedChunkSize) {
+        
+        char * chunk = (char *)mappedBytes + offset;
+        size_t length = MIN(kMappedChunkSize, mappedLength - offset);
+        
+        block(chunk, length, &stop);
+        
+        // The pages are clean, so they can be dropped and faulted back in if needed.
+        madvise(chunk, length, MADV_DONTNEED);
+    }
+    
+    return YES;
+}
+
+- (BOOL)mapFile:(NSError **)error {
+    
+    if (mappedBytes)
+        return YES;
+    
+    int input = open([[self fileName] fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+    struct stat status;
+    
+    if (input < 0 || fstat(input, &status) != 0) {
+        
+        if (error != NULL)
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        
+        if (input >= 0)
+            close(input);
+        
+        return NO;
+    }
+    
+    // mmap() rejects empty mappings, and an empty file has nothing to map.
+    if (status.st_size == 0) {
+        close(input);
+        return YES;
+    }
+    
+    void * bytes = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_SHARED, input, 0);
+    
+    if (bytes == MAP_FAILED) {
+        
+        if (error != NULL)
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        
+        close(input);
+        
+        return NO;
+    }
+    
+    // The mapping outlives the descriptor.
+    close(input);
+    
+    mappedBytes = bytes;
+    mappedLength = (size_t)status.st_size;
+    
+    return YES;
+}
+
+@end
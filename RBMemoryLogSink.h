@@ -0,0 +1,55 @@
+//
+// RBMemoryLogSink.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogSink.h"
+
+
+/**
+ * A sink that keeps the most recent records in memory, such as for showing 
+ * them in the app or attaching them to a report without touching the disk.
+ */
+@interface RBMemoryLogSink : NSObject <RBLogSink>
+
+/// The max number of records kept.
+@property (nonatomic, assign, readonly) NSUInteger capacity;
+
+/**
+ * Standard initializer.
+ *
+ * @param capacity The max number of records kept.
+ *
+ * @return self
+ */
+- (id)initWithCapacity:(NSUInteger)capacity;
+
+/**
+ * Returns the records kept, oldest first. Threadsafe.
+ *
+ * @return The RBLogRecords.
+ */
+- (NSArray *)records;
+
+@end
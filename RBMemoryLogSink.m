@@ -0,0 +1,94 @@
+//
+// RBMemoryLogSink.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBMemoryLogSink.h"
+
+
+@interface RBMemoryLogSink () {
+    
+    /// The slot the next record goes in. Guarded by self.
+    NSUInteger nextIndex;
+}
+
+@property (nonatomic, assign, readwrite) NSUInteger capacity;
+
+/**
+ * The records, used as a ring once it reaches capacity. Guarded by self.
+ */
+@property (nonatomic, strong) NSMutableArray * ring;
+
+@end
+
+
+@implementation RBMemoryLogSink
+
+@synthesize capacity, ring;
+
+- (id)initWithCapacity:(NSUInteger)theCapacity {
+    
+    if ((self = [super init])) {
+        [self setCapacity:MAX(theCapacity, 1)];
+        [self setRing:[NSMutableArray arrayWithCapacity:[self capacity]]];
+    }
+    
+    return self;
+}
+
+- (void)writeRecords:(NSArray *)records {
+    
+    @synchronized(self) {
+        
+        NSMutableArray * kept = [self ring];
+        
+        for (id record in records) {
+            
+            // Overwrites the oldest record once full instead of shifting the array.
+            if ([kept count] < [self capacity])
+                [kept addObject:record];
+            else
+                [kept replaceObjectAtIndex:nextIndex withObject:record];
+            
+            nextIndex = (nextIndex + 1) % [self capacity];
+        }
+    }
+}
+
+- (NSArray *)records {
+    
+    @synchronized(self) {
+        
+        NSMutableArray * kept = [self ring];
+        
+        if ([kept count] < [self capacity])
+            return [kept copy];
+        
+        NSMutableArray * ordered = [NSMutableArray arrayWithCapacity:[kept count]];
+        [ordered addObjectsFromArray:[kept subarrayWithRange:NSMakeRange(nextIndex, [kept count] - nextIndex)]];
+        [ordered addObjectsFromArray:[kept subarrayWithRange:NSMakeRange(0, nextIndex)]];
+        
+        return ordered;
+    }
+}
+
+@end
@@ -0,0 +1,66 @@
+//
+// RBMergedLogAttachment.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBAttachment.h"
+
+@class RBLogMergeReader;
+
+
+/**
+ * An attachment holding the records of several loggers from a start time 
+ * until now, interleaved by timestamp with RBLogMergeReader. Each line names 
+ * the logger it came from. The text is built the first time it is needed and 
+ * then kept.
+ */
+@interface RBMergedLogAttachment : NSObject <RBAttachment>
+
+/// The reader the records come from.
+@property (nonatomic, strong, readonly) RBLogMergeReader * reader;
+
+/// The absolute time of the oldest record in the attachment.
+@property (nonatomic, assign, readonly) CFAbsoluteTime cutoffTime;
+
+/**
+ * Standard initializer.
+ *
+ * @param reader The reader the records come from.
+ * @param time The absolute time of the oldest record to keep.
+ *
+ * @return self
+ */
+- (id)initWithReader:(RBLogMergeReader *)reader cutoffTime:(CFAbsoluteTime)time;
+
+/**
+ * Returns an attachment with the records every logger has logged in the last 
+ * given number of minutes. Must not be called from a loggerQueue.
+ *
+ * @param minutes The number of minutes.
+ *
+ * @return An attachment.
+ */
++ (RBMergedLogAttachment *)attachmentWithLastMinutes:(NSUInteger)minutes;
+
+@end
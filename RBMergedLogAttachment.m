@@ -0,0 +1,110 @@
+//
+// RBMergedLogAttachment.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBMergedLogAttachment.h"
+#import "RBLogMergeReader.h"
+#import "RBReporter.h"
+
+/// The seconds in a minute.
+static const NSTimeInterval kSecondsPerMinute = 60.0;
+
+
+@interface RBMergedLogAttachment ()
+
+@property (nonatomic, strong, readwrite) RBLogMergeReader * reader;
+@property (nonatomic, assign, readwrite) CFAbsoluteTime cutoffTime;
+
+/**
+ * The merged lines, once they have been built.
+ */
+@property (nonatomic, strong) NSData * lines;
+
+@end
+
+
+@implementation RBMergedLogAttachment
+
+@synthesize reader, cutoffTime, lines;
+
+- (id)initWithReader:(RBLogMergeReader *)theReader cutoffTime:(CFAbsoluteTime)time {
+    
+    if ((self = [super init])) {
+        [self setReader:theReader];
+        [self setCutoffTime:time];
+    }
+    
+    return self;
+}
+
+- (NSData *)data {
+    
+    if (![self lines]) {
+        
+        NSError * error = nil;
+        NSDate * cutoffDate = [NSDate dateWithTimeIntervalSinceReferenceDate:[self cutoffTime]];
+        NSData * merged = [[self reader] linesFromDate:cutoffDate toDate:[NSDate distantFuture] error:&error];
+        
+        // A file that can't be read leaves the attachment empty rather than failing the report.
+        if (!merged) {
+            [RBReporter logError:error];
+            merged = [NSData data];
+        }
+        
+        [self setLines:merged];
+    }
+    
+    return [self lines];
+}
+
+- (NSString *)MIMEType {
+    return @"text/plain";
+}
+
+- (NSString *)fileName {
+    return @"MergedLog.log";
+}
+
+- (unsigned long long)length {
+    return [[self data] length];
+}
+
+- (BOOL)enumerateChunksUsingBlock:(void (^)(const void *, NSUInteger, BOOL *))block error:(NSError **)error {
+    
+    NSData * data = [self data];
+    BOOL stop = NO;
+    
+    if ([data length] > 0)
+        block([data bytes], [data length], &stop);
+    
+    return YES;
+}
+
++ (RBMergedLogAttachment *)attachmentWithLastMinutes:(NSUInteger)minutes {
+    
+    CFAbsoluteTime cutoff = CFAbsoluteTimeGetCurrent() - minutes * kSecondsPerMinute;
+    
+    return [[self alloc] initWithReader:[RBLogMergeReader readerForAllLoggers] cutoffTime:cutoff];
+}
+
+@end
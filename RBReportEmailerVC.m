@@ -12,8 +12,21 @@
 // iOS-specific class
 #if TARGET_OS_IPHONE
 
+@interface RBReportEmailerVC ()
+
+/**
+ * The attachments of the email. Kept for as long as the composer, since mapped 
+ * attachments hand out data that is only valid while they are alive.
+ */
+@property (nonatomic, strong) NSArray * attachments;
+
+@end
+
+
 @implementation RBReportEmailerVC
 
+@synthesize attachments;
+
 - (id)initWithEmailBuilder:(id<RBEmailBuilder>)builder {
     
     NSParameterAssert(builder);
@@ -28,10 +41,10 @@
         [self setMessageBody:[builder emailMessage]
                       isHTML:[builder isHTML]];
         
-        // Adds all of the attachments, if any. 
-        NSArray * attachments = [builder attachments];
+        // Adds all of the attachments, if any. File attachments are mapped, not read.
+        [self setAttachments:[builder attachments]];
         
-        for (id<RBAttachment> attachment in attachments) {
+        for (id<RBAttachment> attachment in [self attachments]) {
             [self addAttachmentData:[attachment data]
                            mimeType:[attachment MIMEType]
                            fileName:[attachment fileName]];
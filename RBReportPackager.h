@@ -0,0 +1,66 @@
+//
+// RBReportPackager.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+@protocol RBEmailBuilder;
+
+
+/**
+ * Writes a report as a MIME multipart message to a file, ready to be uploaded 
+ * or handed to a mail client. Attachments that support 
+ * -enumerateChunksUsingBlock:error: are streamed and base64 encoded through a 
+ * fixed-size buffer, so memory use doesn't grow with the size of the logs. 
+ * Other attachments are encoded from their -data.
+ */
+@interface RBReportPackager : NSObject
+
+/**
+ * The builder that provides the report's recipients, subject, message and 
+ * attachments.
+ */
+@property (nonatomic, strong, readonly) id<RBEmailBuilder> builder;
+
+/**
+ * Standard initializer.
+ *
+ * @param builder The builder to package the report of.
+ *
+ * @return self
+ */
+- (id)initWithEmailBuilder:(id<RBEmailBuilder>)builder;
+
+/**
+ * Writes the report to the given path. The file only appears once it is 
+ * complete; an existing file at the path is replaced.
+ *
+ * @param path The path to write the report to.
+ * @param error An error is returned by reference if the report can't be 
+ * written.
+ *
+ * @return YES if the report was written, NO otherwise.
+ */
+- (BOOL)writeReportToPath:(NSString *)path error:(NSError **)error;
+
+@end
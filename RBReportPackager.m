@@ -0,0 +1,447 @@
+//
+// RBReportPackager.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBReportPackager.h"
+#import "RBEmailBuilder.h"
+#import "RBAttachment.h"
+
+#import <fcntl.h>
+#import <unistd.h>
+
+/// The number of bytes encoded per line of base64. Makes 76 character lines.
+#define RB_BASE64_LINE_INPUT_LENGTH 57
+
+/// The number of bytes the output is buffered up to before it is written.
+static const NSUInteger kPackageBufferSize = 64 * 1024;
+
+/// The line ending MIME requires.
+static NSString * const kCRLF = @"\r\n";
+
+static const char kBase64Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * Base64 encodes the given bytes. Writes 4 characters for every 3 bytes, plus 
+ * padding.
+ *
+ * @param bytes The bytes to encode.
+ * @param length The number of bytes to encode.
+ * @param output The buffer to encode into. Must hold ((length + 2) / 3) * 4 
+ * characters.
+ *
+ * @return The number of characters written.
+ */
+static NSUInteger RBBase64Encode(const unsigned char * bytes, NSUInteger length, char * output);
+
+
+@interface RBReportPackager () {
+    
+    /// The descriptor of the file being written, or -1.
+    int fileDescriptor;
+    
+    /// Bytes of the current attachment that don't fill a base64 line yet.
+    unsigned char carry[RB_BASE64_LINE_INPUT_LENGTH];
+    
+    /// The number of bytes in carry.
+    NSUInteger carryLength;
+}
+
+@property (nonatomic, strong, readwrite) id<RBEmailBuilder> builder;
+
+/**
+ * Output that hasn't been written to the file yet.
+ */
+@property (nonatomic, strong) NSMutableData * outputBuffer;
+
+/**
+ * Appends the given string, encoded as UTF-8, to the output.
+ *
+ * @param string The string to append.
+ * @param error An error is returned by reference if the output can't be 
+ * written.
+ *
+ * @return YES if the string was appended, NO otherwise.
+ */
+- (BOOL)appendString:(NSString *)string error:(NSError **)error;
+
+/**
+ * Appends the given bytes to the output, writing the buffer to the file when it 
+ * is full.
+ *
+ * @param bytes The bytes to append.
+ * @param length The number of bytes.
+ * @param error An error is returned by reference if the output can't be 
+ * written.
+ *
+ * @return YES if the bytes were appended, NO otherwise.
+ */
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length error:(NSError **)error;
+
+/**
+ * Writes the buffered output to the file.
+ *
+ * @param error An error is returned by reference if the output can't be 
+ * written.
+ *
+ * @return YES if the output was written, NO otherwise.
+ */
+- (BOOL)flushOutput:(NSError **)error;
+
+/**
+ * Appends the given bytes of an attachment as base64 lines. Bytes that don't 
+ * fill a line are carried over to the next call.
+ *
+ * @param bytes The bytes to encode.
+ * @param length The number of bytes.
+ * @param final YES for the last bytes of the attachment, which flushes the 
+ * carry.
+ * @param error An error is returned by reference if the output can't be 
+ * written.
+ *
+ * @return YES if the bytes were appended, NO otherwise.
+ */
+- (BOOL)appendBase64Bytes:(const unsigned char *)bytes length:(NSUInteger)length final:(BOOL)final error:(NSError **)error;
+
+/**
+ * Appends the given attachment as a MIME part.
+ *
+ * @param attachment The attachment to append.
+ * @param boundary The multipart boundary.
+ * @param error An error is returned by reference if the attachment can't be 
+ * read or the output can't be written.
+ *
+ * @return YES if the attachment was appended, NO otherwise.
+ */
+- (BOOL)appendAttachment:(id<RBAttachment>)attachment boundary:(NSString *)boundary error:(NSError **)error;
+
+/**
+ * Returns the message headers of the report.
+ *
+ * @param boundary The multipart boundary.
+ *
+ * @return The headers, ending with a blank line.
+ */
+- (NSString *)headersWithBoundary:(NSString *)boundary;
+
+/**
+ * Encodes a header value as an RFC 2047 encoded word if it isn't plain ASCII.
+ *
+ * @param value The header value.
+ *
+ * @return The value, safe to use in a header.
+ */
++ (NSString *)encodedHeaderValue:(NSString *)value;
+
+@end
+
+
+@implementation RBReportPackager
+
+@synthesize builder, outputBuffer;
+
+- (id)initWithEmailBuilder:(id<RBEmailBuilder>)theBuilder {
+    
+    NSParameterAssert(theBuilder);
+    
+    if ((self = [super init])) {
+        
+        [self setBuilder:theBuilder];
+        fileDescriptor = -1;
+    }
+    
+    return self;
+}
+
+- (BOOL)writeReportToPath:(NSString *)path error:(NSError **)error {
+    
+    NSString * tempPath = [path stringByAppendingPathExtension:@"tmp"];
+    
+    fileDescriptor = open([tempPath fileSystemRepresentation], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    
+    if (fileDescriptor < 0) {
+        
+        if (error != NULL)
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        
+        return NO;
+    }
+    
+    [self setOutputBuffer:[NSMutableData dataWithCapacity:kPackageBufferSize]];
+    
+    NSString * boundary = [NSString stringWithFormat:@"RBReport-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    id<RBEmailBuilder> report = [self builder];
+    NSString * bodyType = [report isHTML] ? @"text/html" : @"text/plain";
+    
+    NSMutableString * body = [NSMutableString stringWithString:[self headersWithBoundary:boundary]];
+    [body appendFormat:@"--%@%@", boundary, kCRLF];
+    [body appendFormat:@"Content-Type: %@; charset=UTF-8%@", bodyType, kCRLF];
+    [body appendFormat:@"Content-Transfer-Encoding: 8bit%@%@", kCRLF, kCRLF];
+    [body appendString:[report emailMessage] ?: @""];
+    [body appendString:kCRLF];
+    
+    BOOL success = [self appendString:body error:error];
+    
+    for (id<RBAttachment> attachment in [report attachments]) {
+        
+        if (!success)
+            break;
+        
+        // Drains each attachment before the next one is read.
+        @autoreleasepool {
+            success = [self appendAttachment:attachment boundary:boundary error:error];
+        }
+    }
+    
+    if (success)
+        success = [self appendString:[NSString stringWithFormat:@"--%@--%@", boundary, kCRLF] error:error];
+    
+    if (success)
+        success = [self flushOutput:error];
+    
+    close(fileDescriptor);
+    fileDescriptor = -1;
+    [self setOutputBuffer:nil];
+    
+    if (success && rename([tempPath fileSystemRepresentation], [path fileSystemRepresentation]) != 0) {
+        
+        if (error != NULL)
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        
+        success = NO;
+    }
+    
+    if (!success)
+        unlink([tempPath fileSystemRepresentation]);
+    
+    return success;
+}
+
+- (BOOL)appendAttachment:(id<RBAttachment>)attachment boundary:(NSString *)boundary error:(NSError **)error {
+    
+    NSString * name = [[[attachment fileName] lastPathComponent] stringByReplacingOccurrencesOfString:@"\"" withString:@""];
+    NSString * type = [attachment MIMEType] ?: @"application/octet-stream";
+    
+    NSMutableString * headers = [NSMutableString string];
+    [headers appendFormat:@"--%@%@", boundary, kCRLF];
+    [headers appendFormat:@"Content-Type: %@; name=\"%@\"%@", type, name, kCRLF];
+    [headers appendFormat:@"Content-Disposition: attachment; filename=\"%@\"%@", name, kCRLF];
+    [headers appendFormat:@"Content-Transfer-Encoding: base64%@%@", kCRLF, kCRLF];
+    
+    if (![self appendString:headers error:error])
+        return NO;
+    
+    carryLength = 0;
+    
+    if ([attachment respondsToSelector:@selector(enumerateChunksUsingBlock:error:)]) {
+        
+        __block BOOL written = YES;
+        __block NSError * writeError = nil;
+        
+        BOOL read = [attachment enumerateChunksUsingBlock:^(const void * bytes, NSUInteger length, BOOL * stop) {
+            
+            NSError * chunkError = nil;
+            
+            if (![self appendBase64Bytes:bytes length:length final:NO error:&chunkError]) {
+                written = NO;
+                writeError = chunkError;
+                *stop = YES;
+            }
+        } error:error];
+        
+        if (!written && error != NULL)
+            *error = writeError;
+        
+        if (!read || !written)
+            return NO;
+        
+        return [self appendBase64Bytes:NULL length:0 final:YES error:error];
+    }
+    
+    NSData * data = [attachment data];
+    
+    return [self appendBase64Bytes:[data bytes] length:[data length] final:YES error:error];
+}
+
+- (BOOL)appendBase64Bytes:(const unsigned char *)bytes length:(NSUInteger)length final:(BOOL)final error:(NSError **)error {
+    
+    char line[80];
+    
+    // Completes a line started by the previous chunk.
+    if (carryLength > 0) {
+        
+        NSUInteger needed = MIN(RB_BASE64_LINE_INPUT_LENGTH - carryLength, length);
+        
+        if (needed > 0) {
+            memcpy(carry + carryLength, bytes, needed);
+            carryLength += needed;
+            bytes += needed;
+            length -= needed;
+        }
+        
+        if (carryLength == RB_BASE64_LINE_INPUT_LENGTH || final) {
+            
+            NSUInteger lineLength = RBBase64Encode(carry, carryLength, line);
+            line[lineLength++] = '\r';
+            line[lineLength++] = '\n';
+            carryLength = 0;
+            
+            if (![self appendBytes:line length:lineLength error:error])
+                return NO;
+        }
+    }
+    
+    while (length >= RB_BASE64_LINE_INPUT_LENGTH || (final && length > 0)) {
+        
+        NSUInteger inputLength = MIN(length, RB_BASE64_LINE_INPUT_LENGTH);
+        NSUInteger lineLength = RBBase64Encode(bytes, inputLength, line);
+        line[lineLength++] = '\r';
+        line[lineLength++] = '\n';
+        bytes += inputLength;
+        length -= inputLength;
+        
+        if (![self appendBytes:line length:lineLength error:error])
+            return NO;
+    }
+    
+    if (length > 0) {
+        memcpy(carry, bytes, length);
+        carryLength = length;
+    }
+    
+    return YES;
+}
+
+- (BOOL)appendString:(NSString *)string error:(NSError **)error {
+    
+    NSData * data = [string dataUsingEncoding:NSUTF8StringEncoding];
+    
+    return [self appendBytes:[data bytes] length:[data length] error:error];
+}
+
+- (BOOL)appendBytes:(const void *)bytes length:(NSUInteger)length error:(NSError **)error {
+    
+    NSMutableData * buffer = [self outputBuffer];
+    
+    if ([buffer length] + length > kPackageBufferSize && ![self flushOutput:error])
+        return NO;
+    
+    // Output bigger than the buffer is written at once rather than kept around.
+    if (length > kPackageBufferSize) {
+        [buffer appendBytes:bytes length:length];
+        return [self flushOutput:error];
+    }
+    
+    [buffer appendBytes:bytes length:length];
+    
+    return YES;
+}
+
+- (BOOL)flushOutput:(NSError **)error {
+    
+    NSMutableData * buffer = [self outputBuffer];
+    const char * bytes = [buffer bytes];
+    NSUInteger remaining = [buffer length];
+    
+    while (remaining > 0) {
+        
+        ssize_t written = write(fileDescriptor, bytes, remaining);
+        
+        if (written < 0) {
+            
+            if (errno == EINTR)
+                continue;
+            
+            if (error != NULL)
+                *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            
+            return NO;
+        }
+        
+        bytes += written;
+        remaining -= (NSUInteger)written;
+    }
+    
+    [buffer setLength:0];
+    
+    return YES;
+}
+
+- (NSString *)headersWithBoundary:(NSString *)boundary {
+    
+    id<RBEmailBuilder> report = [self builder];
+    NSMutableString * headers = [NSMutableString string];
+    
+    [headers appendFormat:@"MIME-Version: 1.0%@", kCRLF];
+    [headers appendFormat:@"To: %@%@", [[report recipients] componentsJoinedByString:@", "], kCRLF];
+    [headers appendFormat:@"Subject: %@%@", [[self class] encodedHeaderValue:[report subjectLine] ?: @""], kCRLF];
+    [headers appendFormat:@"Content-Type: multipart/mixed; boundary=\"%@\"%@%@", boundary, kCRLF, kCRLF];
+    
+    return headers;
+}
+
++ (NSString *)encodedHeaderValue:(NSString *)value {
+    
+    if ([value canBeConvertedToEncoding:NSASCIIStringEncoding])
+        return value;
+    
+    NSData * data = [value dataUsingEncoding:NSUTF8StringEncoding];
+    NSMutableData * encoded = [NSMutableData dataWithLength:(([data length] + 2) / 3) * 4];
+    NSUInteger length = RBBase64Encode([data bytes], [data length], [encoded mutableBytes]);
+    NSString * base64 = [[NSString alloc] initWithBytes:[encoded bytes] length:length encoding:NSASCIIStringEncoding];
+    
+    return [NSString stringWithFormat:@"=?UTF-8?B?%@?=", base64];
+}
+
+@end
+
+
+static NSUInteger RBBase64Encode(const unsigned char * bytes, NSUInteger length, char * output) {
+    
+    char * start = output;
+    NSUInteger i = 0;
+    
+    for (; i + 3 <= length; i += 3) {
+        
+        uint32_t triple = ((uint32_t)bytes[i] << 16) | ((uint32_t)bytes[i + 1] << 8) | bytes[i + 2];
+        
+        *output++ = kBase64Alphabet[(triple >> 18) & 0x3F];
+        *output++ = kBase64Alphabet[(triple >> 12) & 0x3F];
+        *output++ = kBase64Alphabet[(triple >> 6) & 0x3F];
+        *output++ = kBase64Alphabet[triple & 0x3F];
+    }
+    
+    if (i < length) {
+        
+        uint32_t triple = (uint32_t)bytes[i] << 16;
+        
+        if (i + 1 < length)
+            triple |= (uint32_t)bytes[i + 1] << 8;
+        
+        *output++ = kBase64Alphabet[(triple >> 18) & 0x3F];
+        *output++ = kBase64Alphabet[(triple >> 12) & 0x3F];
+        *output++ = i + 1 < length ? kBase64Alphabet[(triple >> 6) & 0x3F] : '=';
+        *output++ = '=';
+    }
+    
+    return (NSUInteger)(output - start);
+}
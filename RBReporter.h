@@ -23,9 +23,15 @@
 //
 
 #import <Foundation/Foundation.h>
+
+// Only Apple's SDKs have TargetConditionals.h. Elsewhere TARGET_OS_IPHONE is 
+// undefined, which the checks below treat as 0.
+#ifdef __APPLE__
 #import <TargetConditionals.h>
+#endif
 
 #import "RBEmailBuilder.h"
+#import "RBLogLevel.h"
 
 
 // iOS-specific imports. 
@@ -34,12 +40,44 @@
 #endif
 
 
+/**
+ * Logs a formatted message at the given level. The arguments aren't evaluated 
+ * unless the level is at or above both RB_LOG_LEVEL_FLOOR and the runtime 
+ * threshold, and the message is formatted later on the logger's queue. Below 
+ * the floor the call compiles to nothing.
+ */
+#define RBLogWithLevel(lvl, format, ...) \
+    do { \
+        if ((lvl) >= RB_LOG_LEVEL_FLOOR && RBLogLevelIsEnabled(lvl)) \
+            [RBReporter logWithLevel:(lvl) format:(format), ##__VA_ARGS__]; \
+    } while (0)
+
+/// Logs a formatted message at RBLogLevelTrace. See RBLogWithLevel.
+#define RBLogTrace(format, ...) RBLogWithLevel(RBLogLevelTrace, format, ##__VA_ARGS__)
+
+/// Logs a formatted message at RBLogLevelDebug. See RBLogWithLevel.
+#define RBLogDebug(format, ...) RBLogWithLevel(RBLogLevelDebug, format, ##__VA_ARGS__)
+
+/// Logs a formatted message at RBLogLevelInfo. See RBLogWithLevel.
+#define RBLogInfo(format, ...) RBLogWithLevel(RBLogLevelInfo, format, ##__VA_ARGS__)
+
+/// Logs a formatted message at RBLogLevelWarn. See RBLogWithLevel.
+#define RBLogWarn(format, ...) RBLogWithLevel(RBLogLevelWarn, format, ##__VA_ARGS__)
+
+/// Logs a formatted message at RBLogLevelError. See RBLogWithLevel.
+#define RBLogError(format, ...) RBLogWithLevel(RBLogLevelError, format, ##__VA_ARGS__)
+
+/// Logs a formatted message at RBLogLevelFault. See RBLogWithLevel.
+#define RBLogFault(format, ...) RBLogWithLevel(RBLogLevelFault, format, ##__VA_ARGS__)
+
+
 /**
  * A class for generating reports, logging errors, etc. Includes support for 
  * Flurry. The bug reporter comes with many defaults which can be overriden as
  * necessary through various accessor methods.
  *
- * @todo Turn off NSLog when not debugging.
+ * Logged messages are mirrored to the console by RBConsoleLogSink on its own 
+ * queue, in the build configurations where RB_CONSOLE_LOGGING is set.
  */
 @interface RBReporter : NSObject
 
@@ -81,28 +119,51 @@
 + (void)presentAlertWithTitle:(NSString *)title message:(NSString *)message;
 
 /**
- * Convenient error logger given an NSError.
+ * Convenient error logger given an NSError. Logs at RBLogLevelError. The error 
+ * is only turned into a string if that level is enabled.
  *
  * @param error The error to log.
  */
 + (void)logError:(NSError *)error;
 
 /**
- * Convenient exception logger given an NSException.
+ * Convenient exception logger given an NSException. Logs at RBLogLevelFault. 
+ * The exception is only turned into a string if that level is enabled.
  *
  * @param exception The exception to log.
  */
 + (void)logException:(NSException *)exception;
 
 /**
- * Convenient message logger.
+ * Convenient message logger. Logs at RBLogLevelInfo.
  *
  * @param msg The message to log.
  */
 + (void)logMessage:(NSString *)msg;
 
 /**
- * Like +logMessage: except it only logs the message if DEBUG is defined.
+ * Logs a message at the given level, if the level is enabled. Prefer the 
+ * RBLogInfo() style macros, which skip building the message when the level 
+ * is disabled.
+ *
+ * @param msg The message to log.
+ * @param level How severe the message is.
+ */
++ (void)logMessage:(NSString *)msg level:(RBLogLevel)level;
+
+/**
+ * Logs a formatted message at the given level, if the level is enabled. The 
+ * message is formatted on the logger's queue rather than the calling thread 
+ * (see -[RBLogger logWithLevel:format:]).
+ *
+ * @param level How severe the message is.
+ * @param format The format, as for +[NSString stringWithFormat:].
+ */
++ (void)logWithLevel:(RBLogLevel)level format:(NSString *)format, ... NS_FORMAT_FUNCTION(2,3);
+
+/**
+ * Like +logMessage: except it logs at RBLogLevelDebug and only if DEBUG is 
+ * defined.
  *
  * @param msg The message to log.
  */
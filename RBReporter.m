@@ -26,6 +26,7 @@
 
 #import "RBReporter.h"
 #import "RBLogger.h"
+#import "RBErrorThrottle.h"
 #import "RBAttachment.h"
 #import "NSString+RBExtras.h"
 #import "RBReportEmailerVC.h"
@@ -102,31 +103,49 @@
 
 + (void)logError:(NSError *)error {
 	
-    if (!error) return;
+    // Checks the level first so filtered errors don't use up the throttle's budget.
+    if (!error || !RBLogLevelIsEnabled(RBLogLevelError)) return;
     
-    NSLog(@"%@", [NSString stringWithError:error]);
+    // Repeats past their limit are only counted, and summarized later.
+    if (![[RBErrorThrottle sharedThrottle] shouldLogError:error]) return;
+    
+    // The logger turns the error into a string on its own queue.
     [[RBLogger defaultLogger] logError:error];
 }
 
 + (void)logException:(NSException *)exception {
     
-    if (!exception) return;
+    if (!exception || !RBLogLevelIsEnabled(RBLogLevelFault)) return;
+    
+    if (![[RBErrorThrottle sharedThrottle] shouldLogException:exception]) return;
     
-    NSLog(@"%@", [NSString stringWithException:exception]);
     [[RBLogger defaultLogger] logException:exception];
 }
 
 + (void)logMessage:(NSString *)msg {
+    [self logMessage:msg level:RBLogLevelInfo];
+}
+
++ (void)logMessage:(NSString *)msg level:(RBLogLevel)level {
     
     if (!msg) return;
     
-    NSLog(@"%@", msg);
-    [[RBLogger defaultLogger] logMessage:msg];
+    [[RBLogger defaultLogger] logMessage:msg level:level];
+}
+
++ (void)logWithLevel:(RBLogLevel)level format:(NSString *)format, ... {
+    
+    if (!format || !RBLogLevelIsEnabled(level)) return;
+    
+    va_list arguments;
+    va_start(arguments, format);
+    [[RBLogger defaultLogger] logWithLevel:level format:format arguments:arguments];
+    va_end(arguments);
 }
 
 + (void)logDebugMessage:(NSString *)msg {
 #if DEBUG
-    [self logMessage:msg];
+    [self logMessage:msg level:RBLogLevelDebug];
 #endif
 }
 
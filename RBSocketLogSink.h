@@ -0,0 +1,59 @@
+//
+// RBSocketLogSink.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "RBLogSink.h"
+
+
+/**
+ * A sink that streams records as console lines (see RBConsoleLogSink) over a 
+ * TCP connection, such as to a log collector running on the same machine. 
+ * The connection is made when the first batch is written and remade after it 
+ * fails, at most once per retryInterval. Batches written while there is no 
+ * connection are dropped. Connecting and writing block, but only the sink's 
+ * channel queue.
+ */
+@interface RBSocketLogSink : NSObject <RBLogSink>
+
+/// The host to connect to.
+@property (nonatomic, copy, readonly) NSString * host;
+
+/// The TCP port to connect to.
+@property (nonatomic, assign, readonly) uint16_t port;
+
+/// The min seconds between connection attempts. Defaults to 5.
+@property (nonatomic, assign) NSTimeInterval retryInterval;
+
+/**
+ * Standard initializer.
+ *
+ * @param host The host to connect to, such as @"127.0.0.1".
+ * @param port The TCP port to connect to.
+ *
+ * @return self
+ */
+- (id)initWithHost:(NSString *)host port:(uint16_t)port;
+
+@end
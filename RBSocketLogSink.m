@@ -0,0 +1,201 @@
+//
+// RBSocketLogSink.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <errno.h>
+#import <netdb.h>
+#import <sys/socket.h>
+#import <unistd.h>
+
+#import "RBSocketLogSink.h"
+#import "RBConsoleLogSink.h"
+#import "RBTimestampEncoder.h"
+
+/// The default min seconds between connection attempts.
+static const NSTimeInterval kDefaultRetryInterval = 5.0;
+
+/// Keeps a send() to a closed collector from raising SIGPIPE where the socket option doesn't exist.
+#ifdef MSG_NOSIGNAL
+static const int kSendFlags = MSG_NOSIGNAL;
+#else
+static const int kSendFlags = 0;
+#endif
+
+
+@interface RBSocketLogSink () {
+    
+    /// The connected socket, or -1.
+    int socketDescriptor;
+    
+    /// The absolute time of the last connection attempt.
+    CFAbsoluteTime lastAttempt;
+}
+
+@property (nonatomic, copy, readwrite) NSString * host;
+@property (nonatomic, assign, readwrite) uint16_t port;
+
+/**
+ * Formats the times of day. Only used on the channel queue.
+ */
+@property (nonatomic, strong) RBTimestampEncoder * timeEncoder;
+
+/**
+ * Connects to host and port unless connected or an attempt was made within 
+ * retryInterval.
+ *
+ * @return YES if connected.
+ */
+- (BOOL)connectIfNeeded;
+
+/**
+ * Sends all of the given data over the socket, retrying short sends. Unlike 
+ * write(), never raises SIGPIPE if the collector has gone away.
+ *
+ * @param data The data to send.
+ *
+ * @return YES if everything was sent, NO if the send failed.
+ */
+- (BOOL)sendData:(NSData *)data;
+
+/**
+ * Closes the socket, if open.
+ */
+- (void)disconnect;
+
+@end
+
+
+@implementation RBSocketLogSink
+
+@synthesize host, port, retryInterval, timeEncoder;
+
+- (id)initWithHost:(NSString *)theHost port:(uint16_t)thePort {
+    
+    if ((self = [super init])) {
+        
+        socketDescriptor = -1;
+        [self setHost:theHost];
+        [self setPort:thePort];
+        [self setRetryInterval:kDefaultRetryInterval];
+        [self setTimeEncoder:[RBTimestampEncoder new]];
+        [[self timeEncoder] setPrecision:RBTimestampPrecisionMilliseconds];
+    }
+    
+    return self;
+}
+
+- (void)dealloc {
+    [self disconnect];
+}
+
+- (void)writeRecords:(NSArray *)records {
+    
+    if (![self connectIfNeeded])
+        return;
+    
+    NSData * lines = [RBConsoleLogSink linesForRecords:records timeEncoder:[self timeEncoder]];
+    
+    // The collector went away. Reconnects on a later batch.
+    if (![self sendData:lines])
+        [self disconnect];
+}
+
+- (BOOL)sendData:(NSData *)data {
+    
+    const char * bytes = [data bytes];
+    NSUInteger remaining = [data length];
+    
+    while (remaining > 0) {
+        
+        ssize_t sent = send(socketDescriptor, bytes, remaining, kSendFlags);
+        
+        if (sent < 0 && errno == EINTR)
+            continue;
+        
+        if (sent <= 0)
+            return NO;
+        
+        bytes += sent;
+        remaining -= (NSUInteger)sent;
+    }
+    
+    return YES;
+}
+
+- (BOOL)connectIfNeeded {
+    
+    if (socketDescriptor >= 0)
+        return YES;
+    
+    CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+    
+    if (lastAttempt != 0 && now - lastAttempt < [self retryInterval])
+        return NO;
+    
+    lastAttempt = now;
+    
+    struct addrinfo hints;
+    struct addrinfo * addresses = NULL;
+    
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    
+    NSString * service = [NSString stringWithFormat:@"%u", (unsigned)[self port]];
+    
+    if (getaddrinfo([[self host] UTF8String], [service UTF8String], &hints, &addresses) != 0)
+        return NO;
+    
+    for (struct addrinfo * address = addresses; address && socketDescriptor < 0; address = address->ai_next) {
+        
+        int descriptor = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        
+        if (descriptor < 0)
+            continue;
+        
+#ifdef SO_NOSIGPIPE
+        // A closed collector should fail the send, not kill the app. Elsewhere kSendFlags does this.
+        int on = 1;
+        setsockopt(descriptor, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        
+        if (connect(descriptor, address->ai_addr, address->ai_addrlen) == 0)
+            socketDescriptor = descriptor;
+        else
+            close(descriptor);
+    }
+    
+    freeaddrinfo(addresses);
+    
+    return socketDescriptor >= 0;
+}
+
+- (void)disconnect {
+    
+    if (socketDescriptor >= 0) {
+        close(socketDescriptor);
+        socketDescriptor = -1;
+    }
+}
+
+@end
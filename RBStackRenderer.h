@@ -0,0 +1,115 @@
+//
+// RBStackRenderer.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * Turns exceptions' raw return addresses into text for the log. Symbols are 
+ * looked up with dladdr() and cached by address, so a crash site that throws 
+ * over and over is only symbolicated once. Each distinct stack also gets a 
+ * short ID, a hash of its addresses, written above the stack.
+ *
+ * The renderer always writes stacks in full. Whoever writes the descriptions 
+ * can shorten repeats with +abbreviatedDescription:, as long as the full 
+ * stack is in the same place, such as the same log file.
+ *
+ * Addresses change from launch to launch, so IDs and cached symbols are only 
+ * meaningful within one. The symbol cache is bounded, and once full it starts 
+ * over.
+ */
+@interface RBStackRenderer : NSObject
+
+/**
+ * The max number of symbols cached. Defaults to 4096.
+ */
+@property (nonatomic, assign) NSUInteger maxCachedSymbols;
+
+/**
+ * Returns the exception's name and reason, followed by its stack ID and its 
+ * stack. Threadsafe.
+ *
+ * @param exception The exception.
+ *
+ * @return The description.
+ */
+- (NSString *)descriptionOfException:(NSException *)exception;
+
+/**
+ * Returns the short ID of a stack. Threadsafe.
+ *
+ * @param addresses The return addresses, as NSNumbers, innermost first.
+ *
+ * @return The ID, 12 hex digits.
+ */
+- (NSString *)stackIDForAddresses:(NSArray *)addresses;
+
+/**
+ * Returns the image and symbol for an address, such as 
+ * "MyApp 0x000000010000abcd -[MyView layoutSubviews] + 52", from the cache 
+ * if it can. Threadsafe.
+ *
+ * @param address The address.
+ *
+ * @return The symbol.
+ */
+- (NSString *)symbolForAddress:(NSNumber *)address;
+
+/**
+ * Returns the ID of the stack written in full in a description.
+ *
+ * @param description A description returned by -descriptionOfException:.
+ *
+ * @return The ID, or nil if the description has no stack or is abbreviated.
+ */
++ (NSString *)stackIDOfDescription:(NSString *)description;
+
+/**
+ * Returns the ID of the stack an abbreviated description refers to.
+ *
+ * @param description A description returned by +abbreviatedDescription:.
+ *
+ * @return The ID, or nil if the description isn't abbreviated.
+ */
++ (NSString *)referencedStackIDOfDescription:(NSString *)description;
+
+/**
+ * Returns a description with its stack replaced by a reference to the stack's 
+ * ID, such as "Stack 3fa2c1e09b7d (written earlier)".
+ *
+ * @param description A description returned by -descriptionOfException:.
+ *
+ * @return The abbreviated description, or the description itself if it has 
+ * no stack.
+ */
++ (NSString *)abbreviatedDescription:(NSString *)description;
+
+/**
+ * Returns the renderer used by the logger.
+ *
+ * @return The shared renderer.
+ */
++ (RBStackRenderer *)sharedRenderer;
+
+@end
@@ -0,0 +1,230 @@
+//
+// RBStackRenderer.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <dlfcn.h>
+#import <string.h>
+
+#import "RBStackRenderer.h"
+
+/// The default number of symbols cached.
+static const NSUInteger kDefaultMaxCachedSymbols = 4096;
+
+/// The number of hex digits in a stack ID.
+static const NSUInteger kStackIDLength = 12;
+
+/// Starts the line naming a description's stack.
+static NSString * const kStackLinePrefix = @"\nStack ";
+
+/// Ends the line naming a stack written in full.
+static NSString * const kFullStackSuffix = @":";
+
+/// Ends the line naming a stack written earlier.
+static NSString * const kStackReferenceSuffix = @" (written earlier)";
+
+
+@interface RBStackRenderer ()
+
+/**
+ * The symbols, keyed by address.
+ */
+@property (nonatomic, strong) NSMutableDictionary * symbols;
+
+/**
+ * Looks up the image and symbol for an address. Doesn't use the cache.
+ *
+ * @param address The address.
+ *
+ * @return The symbol.
+ */
++ (NSString *)lookUpSymbolForAddress:(uintptr_t)address;
+
+/**
+ * Finds the line naming a description's stack. It is the last line starting 
+ * with "Stack ", since the reason may have several lines and frames start 
+ * with their number.
+ *
+ * @param description The description.
+ * @param suffix What follows the ID, kFullStackSuffix or kStackReferenceSuffix.
+ *
+ * @return The range of the line's newline and prefix, or NSNotFound.
+ */
++ (NSRange)rangeOfStackLineInDescription:(NSString *)description suffix:(NSString *)suffix;
+
+@end
+
+
+@implementation RBStackRenderer
+
+@synthesize maxCachedSymbols, symbols;
+
+- (id)init {
+    
+    if ((self = [super init])) {
+        [self setMaxCachedSymbols:kDefaultMaxCachedSymbols];
+        [self setSymbols:[NSMutableDictionary dictionary]];
+    }
+    
+    return self;
+}
+
+- (NSString *)descriptionOfException:(NSException *)exception {
+    
+    NSString * header = [NSString stringWithFormat:@"%@: %@", [exception name], [exception reason]];
+    NSArray * addresses = [exception callStackReturnAddresses];
+    
+    // Exceptions that were never thrown have no stack.
+    if ([addresses count] == 0)
+        return header;
+    
+    NSString * stackID = [self stackIDForAddresses:addresses];
+    NSMutableString * description = [NSMutableString stringWithFormat:@"%@%@%@%@", header, kStackLinePrefix, stackID, kFullStackSuffix];
+    NSUInteger frame = 0;
+    
+    for (NSNumber * address in addresses)
+        [description appendFormat:@"\n%-4lu%@", (unsigned long)frame++, [self symbolForAddress:address]];
+    
+    return description;
+}
+
+- (NSString *)stackIDForAddresses:(NSArray *)addresses {
+    
+    // FNV-1a over the addresses, folded to 48 bits.
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    
+    for (NSNumber * address in addresses) {
+        
+        uint64_t value = [address unsignedLongLongValue];
+        
+        for (NSUInteger i = 0; i < sizeof(value); i++) {
+            hash ^= (value >> (i * 8)) & 0xff;
+            hash *= 0x100000001b3ULL;
+        }
+    }
+    
+    return [NSString stringWithFormat:@"%012llx", (unsigned long long)((hash ^ (hash >> 48)) & 0xffffffffffffULL)];
+}
+
+- (NSString *)symbolForAddress:(NSNumber *)address {
+    
+    NSString * symbol = nil;
+    
+    @synchronized (self) {
+        symbol = [[self symbols] objectForKey:address];
+    }
+    
+    if (symbol)
+        return symbol;
+    
+    // Looks up outside the lock; two threads may both miss, which only costs a lookup.
+    symbol = [[self class] lookUpSymbolForAddress:(uintptr_t)[address unsignedLongLongValue]];
+    
+    @synchronized (self) {
+        
+        if ([[self symbols] count] >= [self maxCachedSymbols])
+            [[self symbols] removeAllObjects];
+        
+        [[self symbols] setObject:symbol forKey:address];
+    }
+    
+    return symbol;
+}
+
++ (NSString *)lookUpSymbolForAddress:(uintptr_t)address {
+    
+    Dl_info info;
+    
+    if (!dladdr((const void *)address, &info))
+        return [NSString stringWithFormat:@"%-30s 0x%016lx", "???", (unsigned long)address];
+    
+    const char * path = info.dli_fname ? info.dli_fname : "???";
+    const char * image = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    
+    if (!info.dli_sname)
+        return [NSString stringWithFormat:@"%-30s 0x%016lx 0x%lx + %lu", image, (unsigned long)address, 
+                (unsigned long)info.dli_fbase, (unsigned long)(address - (uintptr_t)info.dli_fbase)];
+    
+    return [NSString stringWithFormat:@"%-30s 0x%016lx %s + %lu", image, (unsigned long)address, 
+            info.dli_sname, (unsigned long)(address - (uintptr_t)info.dli_saddr)];
+}
+
++ (NSRange)rangeOfStackLineInDescription:(NSString *)description suffix:(NSString *)suffix {
+    
+    NSRange line = [description rangeOfString:kStackLinePrefix options:NSBackwardsSearch];
+    NSUInteger suffixStart = NSMaxRange(line) + kStackIDLength;
+    
+    if (line.location == NSNotFound || suffixStart + [suffix length] > [description length])
+        return NSMakeRange(NSNotFound, 0);
+    
+    if (![[description substringWithRange:NSMakeRange(suffixStart, [suffix length])] isEqualToString:suffix])
+        return NSMakeRange(NSNotFound, 0);
+    
+    return line;
+}
+
++ (NSString *)stackIDOfDescription:(NSString *)description {
+    
+    NSRange line = [self rangeOfStackLineInDescription:description suffix:kFullStackSuffix];
+    
+    if (line.location == NSNotFound)
+        return nil;
+    
+    return [description substringWithRange:NSMakeRange(NSMaxRange(line), kStackIDLength)];
+}
+
++ (NSString *)referencedStackIDOfDescription:(NSString *)description {
+    
+    NSRange line = [self rangeOfStackLineInDescription:description suffix:kStackReferenceSuffix];
+    
+    if (line.location == NSNotFound)
+        return nil;
+    
+    return [description substringWithRange:NSMakeRange(NSMaxRange(line), kStackIDLength)];
+}
+
++ (NSString *)abbreviatedDescription:(NSString *)description {
+    
+    NSRange line = [self rangeOfStackLineInDescription:description suffix:kFullStackSuffix];
+    
+    if (line.location == NSNotFound)
+        return description;
+    
+    NSString * stackID = [description substringWithRange:NSMakeRange(NSMaxRange(line), kStackIDLength)];
+    
+    return [NSString stringWithFormat:@"%@%@%@%@", [description substringToIndex:line.location], 
+            kStackLinePrefix, stackID, kStackReferenceSuffix];
+}
+
++ (RBStackRenderer *)sharedRenderer {
+    
+    static RBStackRenderer * _sharedRenderer = nil;
+    
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        _sharedRenderer = [self new];
+    });
+    
+    return _sharedRenderer;
+}
+
+@end
@@ -24,8 +24,15 @@
 
 #import <Foundation/Foundation.h>
 
+#import "RBAttachment.h"
 
-@interface RBStandardAttachment : NSObject
+
+/**
+ * An attachment backed by a file. The file is only read when the attachment is 
+ * consumed: -data maps the file when it can, and 
+ * -enumerateChunksUsingBlock:error: streams it through a fixed-size buffer.
+ */
+@interface RBStandardAttachment : NSObject <RBAttachment>
 
 /**
  * The MIME type of the attachment. Optional value.
@@ -25,6 +25,12 @@
 #import "RBStandardAttachment.h"
 #import "NSURL+RBExtras.h"
 
+#import <fcntl.h>
+#import <unistd.h>
+
+/// The size of the buffer attachments are streamed through.
+static const NSUInteger kAttachmentChunkSize = 64 * 1024;
+
 
 @interface RBStandardAttachment ()
 
@@ -52,7 +58,55 @@
 
 - (NSData *)data {
     
-    return [NSData dataWithContentsOfFile:[self fileName]];
+    // Mapping keeps large files out of the heap.
+    return [NSData dataWithContentsOfFile:[self fileName] options:NSDataReadingMappedIfSafe error:NULL];
+}
+
+- (unsigned long long)length {
+    
+    NSDictionary * attributes = [[NSFileManager defaultManager] attributesOfItemAtPath:[self fileName] error:NULL];
+    
+    return [attributes fileSize];
+}
+
+- (BOOL)enumerateChunksUsingBlock:(void (^)(const void *, NSUInteger, BOOL *))block error:(NSError **)error {
+    
+    int input = open([[self fileName] fileSystemRepresentation], O_RDONLY | O_CLOEXEC);
+    
+    if (input < 0) {
+        
+        if (error != NULL)
+            *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+        
+        return NO;
+    }
+    
+    char * buffer = malloc(kAttachmentChunkSize);
+    BOOL stop = NO;
+    BOOL success = YES;
+    ssize_t length = 0;
+    
+    while (!stop && (length = read(input, buffer, kAttachmentChunkSize)) != 0) {
+        
+        if (length < 0) {
+            
+            if (errno == EINTR)
+                continue;
+            
+            if (error != NULL)
+                *error = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+            
+            success = NO;
+            break;
+        }
+        
+        block(buffer, (NSUInteger)length, &stop);
+    }
+    
+    free(buffer);
+    close(input);
+    
+    return success;
 }
 
 - (NSString *)MIMEType {
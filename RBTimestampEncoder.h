@@ -0,0 +1,74 @@
+//
+// RBTimestampEncoder.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * The precision of the times written by RBTimestampEncoder.
+ */
+typedef enum {
+    
+    /// HH:mm:ss
+    RBTimestampPrecisionSeconds,
+    
+    /// HH:mm:ss.SSS
+    RBTimestampPrecisionMilliseconds,
+    
+    /// HH:mm:ss.SSSSSS
+    RBTimestampPrecisionMicroseconds,
+    
+} RBTimestampPrecision;
+
+/// The max number of bytes RBTimestampEncoder writes for one time.
+#define RB_TIMESTAMP_MAX_LENGTH 15
+
+
+/**
+ * Writes UTC times of day as ASCII digits. Produces the same text as an 
+ * NSDateFormatter with the format HH:mm:ss in the GMT time zone, but without 
+ * creating any objects. The digits of the last second encoded are cached, so 
+ * consecutive times in the same second only format the fraction. Not 
+ * threadsafe; each thread or queue should use its own encoder.
+ */
+@interface RBTimestampEncoder : NSObject
+
+/**
+ * The precision of the encoded times. Defaults to RBTimestampPrecisionSeconds.
+ */
+@property (nonatomic, assign) RBTimestampPrecision precision;
+
+/**
+ * Writes the time of day of the given time into the given buffer. The buffer 
+ * is not NUL terminated.
+ *
+ * @param time The absolute time (see CFAbsoluteTimeGetCurrent()) to encode.
+ * @param buffer The buffer to write to. Must hold at least 
+ * RB_TIMESTAMP_MAX_LENGTH bytes.
+ *
+ * @return The number of bytes written.
+ */
+- (NSUInteger)encodeTime:(CFAbsoluteTime)time intoBuffer:(char *)buffer;
+
+@end
@@ -0,0 +1,130 @@
+//
+// RBTimestampEncoder.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <math.h>
+#import <string.h>
+
+#import "RBTimestampEncoder.h"
+
+/// The number of seconds in a day.
+static const int64_t kSecondsPerDay = 86400;
+
+/// The length of HH:mm:ss.
+static const NSUInteger kSecondsLength = 8;
+
+/**
+ * Writes the given number as a fixed number of digits.
+ *
+ * @param value The number to write.
+ * @param digits The number of digits to write.
+ * @param buffer The buffer to write to.
+ */
+static void RBWriteDigits(uint32_t value, NSUInteger digits, char * buffer);
+
+
+@interface RBTimestampEncoder () {
+    
+    /// The whole second the cached digits are for.
+    int64_t cachedSecond;
+    
+    /// The digits of cachedSecond as HH:mm:ss.
+    char cachedDigits[8];
+}
+
+@end
+
+
+@implementation RBTimestampEncoder
+
+@synthesize precision;
+
+- (id)init {
+    
+    if ((self = [super init])) {
+        
+        // No time can floor to this, so the first encode fills the cache.
+        cachedSecond = INT64_MIN;
+    }
+    
+    return self;
+}
+
+- (NSUInteger)encodeTime:(CFAbsoluteTime)time intoBuffer:(char *)buffer {
+    
+    double wholeSeconds = floor(time);
+    int64_t second = (int64_t)wholeSeconds;
+    
+    // The reference date is a UTC midnight, so the time of day is the remainder of a day.
+    if (second != cachedSecond) {
+        
+        int64_t secondOfDay = second % kSecondsPerDay;
+        
+        if (secondOfDay < 0)
+            secondOfDay += kSecondsPerDay;
+        
+        RBWriteDigits((uint32_t)(secondOfDay / 3600), 2, cachedDigits);
+        cachedDigits[2] = ':';
+        RBWriteDigits((uint32_t)(secondOfDay / 60 % 60), 2, cachedDigits + 3);
+        cachedDigits[5] = ':';
+        RBWriteDigits((uint32_t)(secondOfDay % 60), 2, cachedDigits + 6);
+        cachedSecond = second;
+    }
+    
+    memcpy(buffer, cachedDigits, kSecondsLength);
+    
+    // Truncates the fraction like NSDateFormatter does.
+    uint32_t micros = (uint32_t)((time - wholeSeconds) * 1000000.0);
+    
+    if (micros > 999999)
+        micros = 999999;
+    
+    switch ([self precision]) {
+            
+        case RBTimestampPrecisionSeconds:
+            return kSecondsLength;
+            
+        case RBTimestampPrecisionMilliseconds:
+            buffer[kSecondsLength] = '.';
+            RBWriteDigits(micros / 1000, 3, buffer + kSecondsLength + 1);
+            return kSecondsLength + 4;
+            
+        case RBTimestampPrecisionMicroseconds:
+            buffer[kSecondsLength] = '.';
+            RBWriteDigits(micros, 6, buffer + kSecondsLength + 1);
+            return kSecondsLength + 7;
+    }
+    
+    return kSecondsLength;
+}
+
+static void RBWriteDigits(uint32_t value, NSUInteger digits, char * buffer) {
+    
+    // Fills from the right so no reversing is needed.
+    for (NSUInteger i = digits; i > 0; i--) {
+        buffer[i - 1] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+@end
@@ -0,0 +1,189 @@
+//
+// RBErrorThrottleTests.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBErrorThrottleTests.h"
+#import "RBErrorThrottle.h"
+#import "RBLogFileFactory.h"
+#import "RBLogger.h"
+#import "RBLogRecord.h"
+#import "RBMemoryLogSink.h"
+
+/// The repeats allowed per second. A token comes back every 200 ms, which 
+/// leaves the sleeps in the tests 100 ms of slack.
+static const double kRatePerSecond = 5.0;
+
+/// The repeats allowed back to back.
+static const NSUInteger kBurst = 3;
+
+/// The error domain of the test errors.
+static NSString * const kErrorDomain = @"RBErrorThrottleTests";
+
+
+@interface RBErrorThrottleTests ()
+
+/**
+ * A directory for the summary logger's files, removed after each test.
+ */
+@property (nonatomic, copy) NSString * directory;
+
+/**
+ * The throttle under test. Its summaries go to summarySink.
+ */
+@property (nonatomic, strong) RBErrorThrottle * throttle;
+
+/**
+ * Keeps the summaries the throttle logs.
+ */
+@property (nonatomic, strong) RBMemoryLogSink * summarySink;
+
+/**
+ * Returns how many of the given number of repeats of an error the throttle 
+ * lets through, checked back to back.
+ *
+ * @param count The number of repeats.
+ * @param code The error's code.
+ *
+ * @return The number of repeats that should be logged.
+ */
+- (NSUInteger)allowedRepeats:(NSUInteger)count ofErrorWithCode:(NSInteger)code;
+
+/**
+ * Logs the throttle's summaries and returns them.
+ *
+ * @return The messages of the summaries logged.
+ */
+- (NSArray *)summaries;
+
+@end
+
+
+@implementation RBErrorThrottleTests
+
+@synthesize directory, throttle, summarySink;
+
+- (void)setUp {
+    
+    NSString * name = [NSString stringWithFormat:@"RBErrorThrottleTests-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    
+    [self setDirectory:[NSTemporaryDirectory() stringByAppendingPathComponent:name]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[self directory] withIntermediateDirectories:YES attributes:nil error:NULL];
+    
+    RBLogger * logger = [RBLogger loggerNamed:name directory:[self directory] logFileFactory:[RBLogFileFactory defaultFactory]];
+    
+    [self setSummarySink:[[RBMemoryLogSink alloc] initWithCapacity:100]];
+    [logger addSink:[self summarySink] capacity:100 overflowPolicy:RBLogSinkDropNewest];
+    
+    [self setThrottle:[RBErrorThrottle new]];
+    [[self throttle] setRatePerSecond:kRatePerSecond];
+    [[self throttle] setBurst:kBurst];
+    [[self throttle] setSummaryLogger:logger];
+    
+    // The tests log the summaries themselves, so the timer never does.
+    [[self throttle] setSummaryInterval:3600.0];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:[self directory] error:NULL];
+}
+
+- (void)testBurstThenDrop {
+    
+    NSUInteger allowed = [self allowedRepeats:kBurst + 4 ofErrorWithCode:1];
+    
+    RBAssert(allowed == kBurst, @"%lu of %lu repeats were allowed with a burst of %lu", 
+             (unsigned long)allowed, (unsigned long)(kBurst + 4), (unsigned long)kBurst);
+    
+    // Fingerprints have buckets of their own.
+    allowed = [self allowedRepeats:kBurst ofErrorWithCode:2];
+    
+    RBAssert(allowed == kBurst, @"A different error got %lu of %lu repeats", (unsigned long)allowed, (unsigned long)kBurst);
+}
+
+- (void)testRefill {
+    
+    [self allowedRepeats:kBurst + 1 ofErrorWithCode:1];
+    
+    // Half again the time one token takes to come back, well short of two.
+    [NSThread sleepForTimeInterval:1.5 / kRatePerSecond];
+    
+    NSUInteger allowed = [self allowedRepeats:2 ofErrorWithCode:1];
+    
+    RBAssert(allowed == 1, @"%lu repeats were allowed after one token came back", (unsigned long)allowed);
+    
+    // Long enough for the whole bucket to come back.
+    [NSThread sleepForTimeInterval:(kBurst + 1) / kRatePerSecond];
+    
+    allowed = [self allowedRepeats:kBurst + 1 ofErrorWithCode:1];
+    
+    RBAssert(allowed == kBurst, @"%lu repeats were allowed after the bucket refilled", (unsigned long)allowed);
+}
+
+- (void)testSummariesCountDrops {
+    
+    [self allowedRepeats:kBurst + 5 ofErrorWithCode:7];
+    [self allowedRepeats:kBurst ofErrorWithCode:8];
+    
+    NSArray * summaries = [self summaries];
+    NSString * expected = [NSString stringWithFormat:@"Error %@ 7 repeated 5× in ", kErrorDomain];
+    
+    // The error that wasn't dropped gets no summary.
+    RBAssert([summaries count] == 1, @"Logged %lu summaries: %@", (unsigned long)[summaries count], summaries);
+    RBAssert([summaries count] == 0 || [[summaries objectAtIndex:0] hasPrefix:expected], 
+             @"Logged %@, expected it to start with %@", [summaries lastObject], expected);
+    
+    // Each summary resets its count.
+    summaries = [self summaries];
+    
+    RBAssert([summaries count] == 1, @"Logged %lu summaries in all after nothing more was dropped", (unsigned long)[summaries count]);
+}
+
+- (NSUInteger)allowedRepeats:(NSUInteger)count ofErrorWithCode:(NSInteger)code {
+    
+    NSError * error = [NSError errorWithDomain:kErrorDomain code:code userInfo:nil];
+    NSUInteger allowed = 0;
+    
+    for (NSUInteger i = 0; i < count; i++) {
+        
+        if ([[self throttle] shouldLogError:error])
+            allowed++;
+    }
+    
+    return allowed;
+}
+
+- (NSArray *)summaries {
+    
+    RBLogger * logger = [[self throttle] summaryLogger];
+    NSMutableArray * messages = [NSMutableArray array];
+    
+    [[self throttle] logSummaries];
+    [logger flush];
+    
+    for (RBLogRecord * record in [[self summarySink] records])
+        [messages addObject:[record message]];
+    
+    return messages;
+}
+
+@end
@@ -0,0 +1,368 @@
+//
+// RBExtendedLogFileTests.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <dispatch/dispatch.h>
+#import <math.h>
+#import <stdlib.h>
+#import <string.h>
+
+#import "RBExtendedLogFileTests.h"
+#import "RBExtendedLogFile.h"
+#import "RBExtendedLogReader.h"
+#import "RBLogRecord.h"
+
+/// The number of random messages each test checks.
+static const NSUInteger kRandomMessageCount = 20000;
+
+/// Records and the exact lines the baseline encoder wrote for them.
+static const struct {
+    CFAbsoluteTime timestamp;
+    const char * message;
+    const char * line;
+} kGoldenLines[] = {
+    { 0.0,     "Launched",                    "00:00:00 \"Launched\"\n" },
+    { 33302.5, "Said \"hi\"",                 "09:15:02 \"Said \"\"hi\"\"\"\n" },
+    { -1.0,    "",                            "23:59:59 \"\"\n" },
+    { 86399.9, "\xc3\xa9\n\xe6\x97\xa5\xe6\x9c\xac", "23:59:59 \"\xc3\xa9\n\xe6\x97\xa5\xe6\x9c\xac\"\n" },
+};
+
+/// A file in the "time string" format, as every version of RBExtendedLogFile 
+/// has written it, with a quoted quote and a message over two lines.
+static const char kTimeStringFile[] = 
+    "#Name: RBReporter\n"
+    "#Version: 1.0\n"
+    "#Date: Oct 17, 2011\n"
+    "#Fields: time string\n"
+    "09:15:00 \"Launched\"\n"
+    "09:15:02 \"Said \"\"hi\"\"\"\n"
+    "23:59:59 \"Two\nlines\"\n";
+
+
+@interface RBExtendedLogFileTests ()
+
+/**
+ * A file whose encoder is used without writing to it.
+ */
+@property (nonatomic, strong) RBExtendedLogFile * logFile;
+
+/**
+ * A directory for the test's files, removed after each test.
+ */
+@property (nonatomic, copy) NSString * directory;
+
+/**
+ * Returns a random message built from fragments that stress the encoder: 
+ * quotes, newlines, multi-byte characters, NULs and long runs without quotes.
+ *
+ * @return The message.
+ */
++ (NSString *)randomMessage;
+
+/**
+ * Returns a random record with a random level and time.
+ *
+ * @return The record.
+ */
++ (RBLogRecord *)randomRecord;
+
+/**
+ * Returns the line for the given record the way the original 
+ * RBExtendedLogFile -write:error: built it, before lines were encoded in one 
+ * pass: quotes doubled, the GMT HH:mm:ss time and the message formatted as 
+ * `time "message"`, and the string converted to UTF-8. Checked against 
+ * kGoldenLines, so it can't drift along with the encoder.
+ *
+ * @param record The record.
+ *
+ * @return The line's bytes.
+ */
++ (NSData *)referenceLineForRecord:(RBLogRecord *)record;
+
+/**
+ * Checks that a parsed line matches the record it was written from.
+ *
+ * @param line The parsed line.
+ * @param record The record.
+ */
+- (void)checkLine:(const RBExtendedLogLine *)line matchesRecord:(RBLogRecord *)record;
+
+@end
+
+
+@implementation RBExtendedLogFileTests
+
+@synthesize logFile, directory;
+
+- (void)setUp {
+    
+    NSString * name = [NSString stringWithFormat:@"RBExtendedLogFileTests-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    
+    [self setDirectory:[NSTemporaryDirectory() stringByAppendingPathComponent:name]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[self directory] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [self setLogFile:[[RBExtendedLogFile alloc] initWithFilePath:[[self directory] stringByAppendingPathComponent:@"Encoder.log"]]];
+    
+    // Repeatable, so a failure can be reproduced.
+    srand48(20111017);
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:[self directory] error:NULL];
+}
+
+- (void)testGoldenLines {
+    
+    NSMutableData * line = [NSMutableData data];
+    
+    for (NSUInteger i = 0; i < sizeof(kGoldenLines) / sizeof(kGoldenLines[0]); i++) {
+        
+        RBLogRecord * record = [[RBLogRecord alloc] initWithMessage:[NSString stringWithUTF8String:kGoldenLines[i].message] 
+                                                          timestamp:kGoldenLines[i].timestamp];
+        NSData * golden = [NSData dataWithBytes:kGoldenLines[i].line length:strlen(kGoldenLines[i].line)];
+        NSData * reference = [[self class] referenceLineForRecord:record];
+        
+        [line setLength:0];
+        [[self logFile] appendRecord:record toData:line];
+        
+        RBAssert([reference isEqualToData:golden], @"The reference encoded %@ as %@, expected %@", [record message], reference, golden);
+        RBAssert([line isEqualToData:golden], @"%@ encoded as %@, expected %@", [record message], line, golden);
+    }
+}
+
+- (void)testLinesMatchReferenceEncoding {
+    
+    NSMutableData * line = [NSMutableData data];
+    
+    for (NSUInteger i = 0; i < kRandomMessageCount; i++) {
+        
+        RBLogRecord * record = [[self class] randomRecord];
+        NSData * expected = [[self class] referenceLineForRecord:record];
+        
+        [line setLength:0];
+        [[self logFile] appendRecord:record toData:line];
+        
+        RBAssert([line isEqualToData:expected], @"%@ encoded as %@, expected %@", [record message], line, expected);
+    }
+}
+
+- (void)testLinesRoundTrip {
+    
+    NSMutableData * line = [NSMutableData data];
+    
+    for (NSUInteger i = 0; i < kRandomMessageCount; i++) {
+        
+        RBLogRecord * record = [[self class] randomRecord];
+        RBExtendedLogLine parsed;
+        
+        [line setLength:0];
+        [[self logFile] appendRecord:record toData:line];
+        
+        NSUInteger length = RBParseExtendedLogLine([line bytes], [line length], &parsed);
+        
+        RBAssert(length == [line length], @"%@ parsed %lu of %lu bytes", [record message], (unsigned long)length, (unsigned long)[line length]);
+        [self checkLine:&parsed matchesRecord:record];
+    }
+}
+
+- (void)testPartialLinesAreIncomplete {
+    
+    NSMutableData * line = [NSMutableData data];
+    
+    // A reader at the end of a file being written must wait for the rest of the line.
+    for (NSUInteger i = 0; i < kRandomMessageCount / 10; i++) {
+        
+        RBLogRecord * record = [[self class] randomRecord];
+        RBExtendedLogLine parsed;
+        
+        [line setLength:0];
+        [[self logFile] appendRecord:record toData:line];
+        
+        for (NSUInteger length = 0; length < [line length]; length++) {
+            
+            NSUInteger parsedLength = RBParseExtendedLogLine([line bytes], length, &parsed);
+            
+            RBAssert(parsedLength == 0, @"%lu bytes of %@ parsed as a line of %lu", 
+                     (unsigned long)length, [record message], (unsigned long)parsedLength);
+        }
+    }
+}
+
+- (void)testFileRoundTrip {
+    
+    NSMutableArray * records = [NSMutableArray array];
+    NSError * error = nil;
+    
+    for (NSUInteger i = 0; i < kRandomMessageCount; i++)
+        [records addObject:[[self class] randomRecord]];
+    
+    // Writes in uneven batches so lines straddle the write buffer's flushes.
+    for (NSUInteger i = 0; i < [records count]; i += 37) {
+        
+        NSArray * batch = [records subarrayWithRange:NSMakeRange(i, MIN((NSUInteger)37, [records count] - i))];
+        
+        RBAssert([[self logFile] writeRecords:batch error:&error], @"Writing failed: %@", error);
+    }
+    
+    [[self logFile] closeFile];
+    
+    NSData * contents = [NSData dataWithContentsOfFile:[[self logFile] filePath]];
+    const char * bytes = [contents bytes];
+    NSUInteger remaining = [contents length];
+    NSUInteger recordIndex = 0;
+    
+    while (remaining > 0) {
+        
+        RBExtendedLogLine parsed;
+        NSUInteger length = RBParseExtendedLogLine(bytes, remaining, &parsed);
+        
+        RBAssert(length > 0, @"The file ends in an incomplete line after %lu records", (unsigned long)recordIndex);
+        
+        if (length == 0)
+            break;
+        
+        // Skips the header.
+        if (parsed.isRecord) {
+            
+            RBAssert(recordIndex < [records count], @"The file has more records than were written");
+            
+            if (recordIndex < [records count])
+                [self checkLine:&parsed matchesRecord:[records objectAtIndex:recordIndex]];
+            
+            recordIndex++;
+        }
+        
+        bytes += length;
+        remaining -= length;
+    }
+    
+    RBAssert(recordIndex == [records count], @"Read %lu of %lu records", (unsigned long)recordIndex, (unsigned long)[records count]);
+}
+
+- (void)testTimeStringFilesParse {
+    
+    NSData * contents = [NSData dataWithBytes:kTimeStringFile length:sizeof(kTimeStringFile) - 1];
+    RBExtendedLogReader * reader = [[RBExtendedLogReader alloc] initWithData:contents dayStart:86400.0];
+    NSArray * messages = [NSArray arrayWithObjects:@"Launched", @"Said \"hi\"", @"Two\nlines", nil];
+    NSArray * times = [NSArray arrayWithObjects:
+                       [NSNumber numberWithDouble:86400.0 + 33300.0], 
+                       [NSNumber numberWithDouble:86400.0 + 33302.0], 
+                       [NSNumber numberWithDouble:86400.0 + 86399.0], 
+                       nil];
+    NSMutableArray * records = [NSMutableArray array];
+    
+    RBAssert([[reader fields] isEqualToString:@"time string"], @"Read the fields as %@", [reader fields]);
+    
+    [reader enumerateLinesUsingBlock:^(const RBExtendedLogLine * line, NSUInteger offset, BOOL * stop) {
+        [records addObject:[reader recordForLine:line]];
+    }];
+    
+    RBAssert([records count] == [messages count], @"Read %lu of %lu records", (unsigned long)[records count], (unsigned long)[messages count]);
+    
+    for (NSUInteger i = 0; i < MIN([records count], [messages count]); i++) {
+        
+        RBLogRecord * record = [records objectAtIndex:i];
+        
+        RBAssert([[record message] isEqualToString:[messages objectAtIndex:i]], @"Record %lu read as %@", (unsigned long)i, [record message]);
+        RBAssert([record timestamp] == [[times objectAtIndex:i] doubleValue], @"Record %lu read at %f", (unsigned long)i, [record timestamp]);
+        RBAssert([record level] == RBLogLevelUnknown, @"Record %lu read with level %d", (unsigned long)i, [record level]);
+    }
+}
+
+- (void)checkLine:(const RBExtendedLogLine *)line matchesRecord:(RBLogRecord *)record {
+    
+    CFTimeInterval timeOfDay = fmod(floor([record timestamp]), 86400.0);
+    NSString * message = RBMessageOfExtendedLogLine(line);
+    
+    if (timeOfDay < 0)
+        timeOfDay += 86400.0;
+    
+    RBAssert(line->isRecord, @"%@ didn't parse as a record", [record message]);
+    RBAssert(line->timeOfDay == timeOfDay, @"%@ parsed at %f, expected %f", [record message], line->timeOfDay, timeOfDay);
+    RBAssert([message isEqualToString:[record message]], @"%@ parsed as %@", [record message], message);
+}
+
++ (NSString *)randomMessage {
+    
+    static NSArray * fragments = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        
+        unichar nul = 0;
+        
+        fragments = [NSArray arrayWithObjects:
+                     @"a", @"Request failed", @" ", @"\"", @"\"\"", @"\n", @"\"\n", @"\r\n", @"\t", @"\\", 
+                     @"#Fields: ", @"12:00:00 ", @"é", @"日本語", @"\U0001F600", 
+                     [NSString stringWithCharacters:&nul length:1], 
+                     nil];
+    });
+    
+    NSMutableString * message = [NSMutableString string];
+    NSUInteger count = (NSUInteger)(drand48() * 12);
+    
+    for (NSUInteger i = 0; i < count; i++)
+        [message appendString:[fragments objectAtIndex:(NSUInteger)(drand48() * [fragments count])]];
+    
+    // Stack traces are long, and long runs are where memchr() does its work.
+    if (drand48() < 0.1) {
+        
+        NSUInteger runLength = [message length] + (NSUInteger)(drand48() * 4096);
+        
+        message = [[message stringByPaddingToLength:runLength withString:@"  at -[RBLogger writeRecords:] (RBLogger.m:42)\n" startingAtIndex:0] mutableCopy];
+        [message appendString:[fragments objectAtIndex:(NSUInteger)(drand48() * [fragments count])]];
+    }
+    
+    return message;
+}
+
++ (RBLogRecord *)randomRecord {
+    
+    RBLogLevel level = (RBLogLevel)(drand48() * (RBLogLevelFault + 1));
+    CFAbsoluteTime timestamp = (drand48() - 0.5) * 1e9;
+    
+    return [[RBLogRecord alloc] initWithMessage:[self randomMessage] 
+                                           type:RBLogRecordTypeMessage 
+                                          level:level 
+                                      timestamp:timestamp];
+}
+
++ (NSData *)referenceLineForRecord:(RBLogRecord *)record {
+    
+    static NSDateFormatter * formatter = nil;
+    static dispatch_once_t onceToken;
+    
+    dispatch_once(&onceToken, ^{
+        formatter = [NSDateFormatter new];
+        [formatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"]];
+        [formatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+        [formatter setDateFormat:@"HH:mm:ss"];
+    });
+    
+    NSString * time = [formatter stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:[record timestamp]]];
+    NSString * escaped = [[record message] stringByReplacingOccurrencesOfString:@"\"" withString:@"\"\""];
+    NSString * line = [NSString stringWithFormat:@"%@ \"%@\"\n", time, escaped];
+    
+    return [line dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+@end
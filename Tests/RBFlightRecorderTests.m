@@ -0,0 +1,317 @@
+//
+// RBFlightRecorderTests.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <fcntl.h>
+#import <unistd.h>
+
+#import "RBFlightRecorderTests.h"
+#import "RBFlightRecorder.h"
+
+/// The capacity of the test recorders, the smallest one allowed.
+static const NSUInteger kCapacity = 4096;
+
+/// The bytes before the records in the file: the recorder's header.
+static const off_t kFileHeaderSize = 64;
+
+/// The bytes before each record's message.
+static const NSUInteger kRecordHeaderSize = 24;
+
+/// The message length that makes a record take up 64 bytes, which divides 
+/// the capacity evenly.
+static const NSUInteger kSmallMessageLength = 40;
+
+/// The message length that makes a record take up 1024 bytes.
+static const NSUInteger kLargeMessageLength = 1000;
+
+
+@interface RBFlightRecorderTests ()
+
+/**
+ * A directory for the test's files, removed after each test.
+ */
+@property (nonatomic, copy) NSString * directory;
+
+/**
+ * The path of the test's flight recorder file.
+ */
+@property (nonatomic, copy) NSString * path;
+
+/**
+ * Returns a recorder on the test's file, as on a new launch.
+ *
+ * @return The recorder.
+ */
+- (RBFlightRecorder *)openRecorder;
+
+/**
+ * Records a numbered message of the given length.
+ *
+ * @param recorder The recorder.
+ * @param number The message's number.
+ * @param length The message's length in bytes.
+ *
+ * @return The record's ID.
+ */
+- (uint64_t)recordMessageNumber:(NSUInteger)number length:(NSUInteger)length inRecorder:(RBFlightRecorder *)recorder;
+
+/**
+ * Checks that the records recovered from the test's file are the numbered 
+ * messages expected, in order.
+ *
+ * @param numbers The NSNumbers of the messages expected.
+ * @param length The length of each message.
+ */
+- (void)checkRecoveredMessageNumbers:(NSArray *)numbers length:(NSUInteger)length;
+
+/**
+ * Returns a numbered message of the given length.
+ *
+ * @param number The message's number.
+ * @param length The message's length in bytes. At least 16.
+ *
+ * @return The message.
+ */
++ (NSString *)messageNumber:(NSUInteger)number length:(NSUInteger)length;
+
+/**
+ * Returns the numbers in a range.
+ *
+ * @param range The range.
+ *
+ * @return The NSNumbers, in increasing order.
+ */
++ (NSMutableArray *)numbersInRange:(NSRange)range;
+
+@end
+
+
+@implementation RBFlightRecorderTests
+
+@synthesize directory, path;
+
+- (void)setUp {
+    
+    NSString * name = [NSString stringWithFormat:@"RBFlightRecorderTests-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    
+    [self setDirectory:[NSTemporaryDirectory() stringByAppendingPathComponent:name]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[self directory] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [self setPath:[[self directory] stringByAppendingPathComponent:@"FlightRecorder"]];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:[self directory] error:NULL];
+}
+
+- (void)testRecordsRoundTrip {
+    
+    @autoreleasepool {
+        
+        RBFlightRecorder * recorder = [self openRecorder];
+        
+        [recorder recordMessage:@"Launched" type:RBLogRecordTypeMessage level:RBLogLevelInfo timestamp:1000.5];
+        [recorder recordMessage:@"Said \"hi\" in 日本語" type:RBLogRecordTypeError level:RBLogLevelError timestamp:1001.25];
+    }
+    
+    NSArray * recovered = [[self openRecorder] recoverRecords];
+    
+    RBAssert([recovered count] == 2, @"Recovered %lu of 2 records", (unsigned long)[recovered count]);
+    
+    if ([recovered count] == 2) {
+        
+        RBLogRecord * first = [recovered objectAtIndex:0];
+        RBLogRecord * second = [recovered objectAtIndex:1];
+        
+        RBAssert([[first message] isEqualToString:@"Launched"], @"Recovered %@", [first message]);
+        RBAssert([first level] == RBLogLevelInfo && [first timestamp] == 1000.5, @"Recovered level %d at %f", [first level], [first timestamp]);
+        RBAssert([[second message] isEqualToString:@"Said \"hi\" in 日本語"], @"Recovered %@", [second message]);
+        RBAssert([second type] == RBLogRecordTypeError && [second level] == RBLogLevelError, 
+                 @"Recovered type %d and level %d", [second type], [second level]);
+    }
+    
+    // Recovering empties the file.
+    recovered = [[self openRecorder] recoverRecords];
+    
+    RBAssert([recovered count] == 0, @"Recovered %lu records a second time", (unsigned long)[recovered count]);
+}
+
+- (void)testRecordThatDoesNotFitStartsNextLap {
+    
+    @autoreleasepool {
+        
+        RBFlightRecorder * recorder = [self openRecorder];
+        
+        // 64 bytes, then three of 1024, leave 960 bytes before the end, which 
+        // is too few for the fifth record.
+        [self recordMessageNumber:0 length:kSmallMessageLength inRecorder:recorder];
+        
+        for (NSUInteger i = 1; i <= 4; i++)
+            [self recordMessageNumber:i length:kLargeMessageLength inRecorder:recorder];
+    }
+    
+    // The fifth record starts the next lap, over the first two. The gap at the 
+    // end of the first lap is skipped.
+    [self checkRecoveredMessageNumbers:[[self class] numbersInRange:NSMakeRange(2, 3)] length:kLargeMessageLength];
+}
+
+- (void)testRecoveryAfterWrappingAround {
+    
+    NSUInteger count = 500;
+    NSUInteger recordsPerLap = kCapacity / (kRecordHeaderSize + kSmallMessageLength);
+    
+    @autoreleasepool {
+        
+        RBFlightRecorder * recorder = [self openRecorder];
+        
+        for (NSUInteger i = 0; i < count; i++)
+            [self recordMessageNumber:i length:kSmallMessageLength inRecorder:recorder];
+    }
+    
+    // Nearly eight laps in, only the last lap's worth is left.
+    [self checkRecoveredMessageNumbers:[[self class] numbersInRange:NSMakeRange(count - recordsPerLap, recordsPerLap)] 
+                                length:kSmallMessageLength];
+}
+
+- (void)testRetiredRecordsAreSkipped {
+    
+    uint64_t recordIDs[10];
+    NSUInteger count = sizeof(recordIDs) / sizeof(recordIDs[0]);
+    NSMutableArray * expected = [NSMutableArray array];
+    
+    @autoreleasepool {
+        
+        RBFlightRecorder * recorder = [self openRecorder];
+        
+        for (NSUInteger i = 0; i < count; i++)
+            recordIDs[i] = [self recordMessageNumber:i length:kSmallMessageLength inRecorder:recorder];
+        
+        // Retired out of order, as records from several threads reach the log file.
+        for (NSUInteger i = count; i > 0; i--) {
+            
+            if ((i - 1) % 3 == 0)
+                [expected insertObject:[NSNumber numberWithUnsignedInteger:i - 1] atIndex:0];
+            else
+                [recorder retireRecord:recordIDs[i - 1]];
+        }
+    }
+    
+    [self checkRecoveredMessageNumbers:expected length:kSmallMessageLength];
+}
+
+- (void)testTornRecordIsSkipped {
+    
+    NSUInteger count = 70;
+    NSUInteger recordsPerLap = kCapacity / (kRecordHeaderSize + kSmallMessageLength);
+    NSUInteger tornNumber = 66;
+    uint64_t tornID = 0;
+    
+    @autoreleasepool {
+        
+        RBFlightRecorder * recorder = [self openRecorder];
+        
+        for (NSUInteger i = 0; i < count; i++) {
+            
+            uint64_t recordID = [self recordMessageNumber:i length:kSmallMessageLength inRecorder:recorder];
+            
+            if (i == tornNumber)
+                tornID = recordID;
+        }
+    }
+    
+    // A crash in the middle of writing the record on its second lap leaves the 
+    // commit word of the record it replaced, a lap earlier, and a length half 
+    // written.
+    uint64_t staleCommit = tornID - kCapacity;
+    uint32_t tornLength = 0xFFFF0000;
+    off_t offset = kFileHeaderSize + (off_t)((tornID - 1) % kCapacity);
+    int fileDescriptor = open([[self path] fileSystemRepresentation], O_RDWR);
+    
+    RBAssert(fileDescriptor >= 0, @"Couldn't open %@", [self path]);
+    RBAssert(pwrite(fileDescriptor, &staleCommit, sizeof(staleCommit), offset) == sizeof(staleCommit), @"Couldn't write the commit word");
+    RBAssert(pwrite(fileDescriptor, &tornLength, sizeof(tornLength), offset + 16) == sizeof(tornLength), @"Couldn't write the length");
+    close(fileDescriptor);
+    
+    NSMutableArray * expected = [[self class] numbersInRange:NSMakeRange(count - recordsPerLap, recordsPerLap)];
+    
+    [expected removeObject:[NSNumber numberWithUnsignedInteger:tornNumber]];
+    [self checkRecoveredMessageNumbers:expected length:kSmallMessageLength];
+}
+
+- (RBFlightRecorder *)openRecorder {
+    
+    NSError * error = nil;
+    RBFlightRecorder * recorder = [[RBFlightRecorder alloc] initWithPath:[self path] capacity:kCapacity error:&error];
+    
+    RBAssert(recorder != nil, @"Couldn't open the recorder: %@", error);
+    RBAssert([recorder capacity] == kCapacity, @"The recorder holds %lu bytes, expected %lu", 
+             (unsigned long)[recorder capacity], (unsigned long)kCapacity);
+    
+    return recorder;
+}
+
+- (uint64_t)recordMessageNumber:(NSUInteger)number length:(NSUInteger)length inRecorder:(RBFlightRecorder *)recorder {
+    
+    return [recorder recordMessage:[[self class] messageNumber:number length:length] 
+                              type:RBLogRecordTypeMessage 
+                             level:RBLogLevelInfo 
+                         timestamp:(CFAbsoluteTime)number];
+}
+
+- (void)checkRecoveredMessageNumbers:(NSArray *)numbers length:(NSUInteger)length {
+    
+    NSArray * recovered = [[self openRecorder] recoverRecords];
+    
+    RBAssert([recovered count] == [numbers count], @"Recovered %lu records, expected %lu", 
+             (unsigned long)[recovered count], (unsigned long)[numbers count]);
+    
+    for (NSUInteger i = 0; i < MIN([recovered count], [numbers count]); i++) {
+        
+        NSUInteger number = [[numbers objectAtIndex:i] unsignedIntegerValue];
+        RBLogRecord * record = [recovered objectAtIndex:i];
+        NSString * expected = [[self class] messageNumber:number length:length];
+        
+        RBAssert([[record message] isEqualToString:expected], @"Recovered record %lu is %@, expected message %lu", 
+                 (unsigned long)i, [[record message] substringToIndex:MIN([[record message] length], (NSUInteger)16)], (unsigned long)number);
+        RBAssert([record timestamp] == (CFAbsoluteTime)number, @"Recovered record %lu at %f, expected %lu", 
+                 (unsigned long)i, [record timestamp], (unsigned long)number);
+    }
+}
+
++ (NSString *)messageNumber:(NSUInteger)number length:(NSUInteger)length {
+    
+    NSString * prefix = [NSString stringWithFormat:@"Message %07lu ", (unsigned long)number];
+    
+    return [prefix stringByPaddingToLength:length withString:@"x" startingAtIndex:0];
+}
+
++ (NSMutableArray *)numbersInRange:(NSRange)range {
+    
+    NSMutableArray * numbers = [NSMutableArray arrayWithCapacity:range.length];
+    
+    for (NSUInteger i = range.location; i < NSMaxRange(range); i++)
+        [numbers addObject:[NSNumber numberWithUnsignedInteger:i]];
+    
+    return numbers;
+}
+
+@end
@@ -0,0 +1,163 @@
+//
+// RBLogSinkTests.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import "RBLogSinkTests.h"
+#import "RBLogFileFactory.h"
+#import "RBLogger.h"
+#import "RBLogRecord.h"
+#import "RBLogSinkChannel.h"
+#import "RBMemoryLogSink.h"
+#import "RBSlowLogSink.h"
+
+/// The messages each test logs. More than a batch, so the slow sink's buffer overflows.
+static const NSUInteger kMessageCount = 2000;
+
+/// The slow sink's buffer, much smaller than kMessageCount.
+static const NSUInteger kSlowSinkCapacity = 100;
+
+/// The time the slow sink takes for every batch.
+static const NSTimeInterval kSlowSinkDelay = 0.2;
+
+
+@interface RBLogSinkTests ()
+
+/**
+ * A directory for the test's log files, removed after each test.
+ */
+@property (nonatomic, copy) NSString * directory;
+
+/**
+ * A logger writing to the test's directory. Loggers live for the rest of the 
+ * process, so each test gets a new one.
+ */
+@property (nonatomic, strong) RBLogger * logger;
+
+/**
+ * Logs kMessageCount numbered messages.
+ *
+ * @return The seconds the calls took.
+ */
+- (NSTimeInterval)logMessages;
+
+@end
+
+
+@implementation RBLogSinkTests
+
+@synthesize directory, logger;
+
+- (void)setUp {
+    
+    NSString * name = [NSString stringWithFormat:@"RBLogSinkTests-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+    
+    [self setDirectory:[NSTemporaryDirectory() stringByAppendingPathComponent:name]];
+    [[NSFileManager defaultManager] createDirectoryAtPath:[self directory] withIntermediateDirectories:YES attributes:nil error:NULL];
+    [self setLogger:[RBLogger loggerNamed:name directory:[self directory] logFileFactory:[RBLogFileFactory defaultFactory]]];
+    
+    // Nothing logged by the tests may be dropped before it reaches the sinks.
+    [[self logger] setOverflowPolicy:RBLogOverflowBlock];
+}
+
+- (void)tearDown {
+    [[NSFileManager defaultManager] removeItemAtPath:[self directory] error:NULL];
+}
+
+- (void)testSlowSinkDoesNotHoldUpOthers {
+    
+    RBMemoryLogSink * fastSink = [[RBMemoryLogSink alloc] initWithCapacity:kMessageCount];
+    RBSlowLogSink * slowSink = [[RBSlowLogSink alloc] initWithCapacity:kMessageCount delay:kSlowSinkDelay];
+    RBLogSinkChannel * fastChannel = [[self logger] addSink:fastSink capacity:kMessageCount overflowPolicy:RBLogSinkDropOldest];
+    RBLogSinkChannel * slowChannel = [[self logger] addSink:slowSink capacity:kSlowSinkCapacity overflowPolicy:RBLogSinkDropNewest];
+    
+    NSTimeInterval loggingTime = [self logMessages];
+    
+    [[self logger] flush];
+    
+    RBLogSinkStatistics fastStatistics = [fastChannel statistics];
+    RBLogSinkStatistics slowStatistics = [slowChannel statistics];
+    NSArray * fastRecords = [fastSink records];
+    
+    // The callers finished before the slow sink had written a single batch.
+    RBAssert(loggingTime < kSlowSinkDelay, @"Logging took %f s with a sink taking %f s a batch", loggingTime, kSlowSinkDelay);
+    
+    // The file and the fast sink got everything, in order.
+    RBAssert([[self logger] statistics].messagesWritten >= kMessageCount, @"The log file got %llu of %lu messages", 
+             [[self logger] statistics].messagesWritten, (unsigned long)kMessageCount);
+    RBAssert([fastRecords count] == kMessageCount, @"The fast sink got %lu of %lu records", 
+             (unsigned long)[fastRecords count], (unsigned long)kMessageCount);
+    RBAssert(fastStatistics.recordsDropped == 0, @"The fast sink dropped %llu records", fastStatistics.recordsDropped);
+    
+    for (NSUInteger i = 0; i < [fastRecords count]; i++) {
+        
+        NSString * expected = [NSString stringWithFormat:@"Message %lu", (unsigned long)i];
+        NSString * message = [[fastRecords objectAtIndex:i] message];
+        
+        RBAssert([message isEqualToString:expected], @"The fast sink's record %lu is %@", (unsigned long)i, message);
+    }
+    
+    // The slow sink dropped what didn't fit and accounts for every record.
+    RBAssert(slowStatistics.recordsDropped > 0, @"The slow sink dropped nothing");
+    RBAssert(slowStatistics.recordsPending == 0, @"%lu records are still pending after a flush", (unsigned long)slowStatistics.recordsPending);
+    RBAssert(slowStatistics.recordsWritten + slowStatistics.recordsDropped == kMessageCount, 
+             @"The slow sink wrote %llu and dropped %llu of %lu records", 
+             slowStatistics.recordsWritten, slowStatistics.recordsDropped, (unsigned long)kMessageCount);
+    RBAssert(slowStatistics.recordsWritten == [[slowSink records] count], @"The slow sink's channel counted %llu records but it got %lu", 
+             slowStatistics.recordsWritten, (unsigned long)[[slowSink records] count]);
+    RBAssert(slowStatistics.batchesWritten == [slowSink batchCount], @"The slow sink's channel counted %llu batches but it got %lu", 
+             slowStatistics.batchesWritten, (unsigned long)[slowSink batchCount]);
+    RBAssert(slowStatistics.maxWriteTime >= kSlowSinkDelay, @"The slow sink's longest write took %f s", slowStatistics.maxWriteTime);
+    RBAssert(slowStatistics.maxLatency > fastStatistics.maxLatency, @"The slow sink's latency (%f s) isn't above the fast sink's (%f s)", 
+             slowStatistics.maxLatency, fastStatistics.maxLatency);
+}
+
+- (void)testSlowSinkDroppingOldestKeepsNewest {
+    
+    RBSlowLogSink * slowSink = [[RBSlowLogSink alloc] initWithCapacity:kMessageCount delay:kSlowSinkDelay];
+    RBLogSinkChannel * slowChannel = [[self logger] addSink:slowSink capacity:kSlowSinkCapacity overflowPolicy:RBLogSinkDropOldest];
+    
+    [self logMessages];
+    [[self logger] flush];
+    
+    NSString * expected = [NSString stringWithFormat:@"Message %lu", (unsigned long)(kMessageCount - 1)];
+    NSString * last = [[[slowSink records] lastObject] message];
+    RBLogSinkStatistics statistics = [slowChannel statistics];
+    
+    RBAssert([last isEqualToString:expected], @"The slow sink's last record is %@, expected %@", last, expected);
+    RBAssert(statistics.recordsDropped > 0, @"The slow sink dropped nothing");
+    RBAssert(statistics.recordsWritten + statistics.recordsDropped == kMessageCount, 
+             @"The slow sink wrote %llu and dropped %llu of %lu records", 
+             statistics.recordsWritten, statistics.recordsDropped, (unsigned long)kMessageCount);
+}
+
+- (NSTimeInterval)logMessages {
+    
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    
+    for (NSUInteger i = 0; i < kMessageCount; i++)
+        [[self logger] logMessage:[NSString stringWithFormat:@"Message %lu", (unsigned long)i]];
+    
+    return CFAbsoluteTimeGetCurrent() - start;
+}
+
+@end
@@ -0,0 +1,82 @@
+//
+// RBTestCase.h
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+
+
+/**
+ * Records a failure unless the condition holds. Only for use in RBTestCase 
+ * methods. The test keeps running, so one run reports every failure.
+ *
+ * @param condition The condition that should be true.
+ * @param format A format string describing the failure, and its arguments.
+ */
+#define RBAssert(condition, format, ...) \
+    do { \
+        if (!(condition)) \
+            [self recordFailureInFile:__FILE__ line:__LINE__ description:[NSString stringWithFormat:(format), ##__VA_ARGS__]]; \
+    } while (0)
+
+
+/**
+ * A set of tests. Subclasses add methods whose names start with "test" and 
+ * take no arguments; each runs on a new instance, between -setUp and 
+ * -tearDown. Failures are printed to stderr as they are recorded.
+ */
+@interface RBTestCase : NSObject
+
+/**
+ * The number of failures the instance has recorded.
+ */
+@property (nonatomic, assign, readonly) NSUInteger failureCount;
+
+/**
+ * Called before each test. Does nothing by default.
+ */
+- (void)setUp;
+
+/**
+ * Called after each test. Does nothing by default.
+ */
+- (void)tearDown;
+
+/**
+ * Records and prints a failure. Use RBAssert() instead of calling this 
+ * directly.
+ *
+ * @param file The source file of the failed check.
+ * @param line The line of the failed check.
+ * @param description What went wrong.
+ */
+- (void)recordFailureInFile:(const char *)file line:(NSUInteger)line description:(NSString *)description;
+
+/**
+ * Runs every test of the class, each on a new instance, and prints a line 
+ * per test.
+ *
+ * @return The number of tests that failed.
+ */
++ (NSUInteger)runTests;
+
+@end
@@ -0,0 +1,113 @@
+//
+// RBTestCase.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <objc/runtime.h>
+#import <stdio.h>
+#import <stdlib.h>
+
+#import "RBTestCase.h"
+
+
+@interface RBTestCase ()
+
+@property (nonatomic, assign, readwrite) NSUInteger failureCount;
+
+/**
+ * Returns the names of the class's test methods, sorted.
+ *
+ * @return An array of NSStrings.
+ */
++ (NSArray *)testNames;
+
+@end
+
+
+@implementation RBTestCase
+
+@synthesize failureCount;
+
+- (void)setUp {
+    // Overridden by subclasses.
+}
+
+- (void)tearDown {
+    // Overridden by subclasses.
+}
+
+- (void)recordFailureInFile:(const char *)file line:(NSUInteger)line description:(NSString *)description {
+    
+    fprintf(stderr, "%s:%lu: error: %s\n", file, (unsigned long)line, [description UTF8String]);
+    [self setFailureCount:[self failureCount] + 1];
+}
+
++ (NSUInteger)runTests {
+    
+    NSUInteger failedTests = 0;
+    
+    for (NSString * name in [self testNames]) {
+        
+        @autoreleasepool {
+            
+            RBTestCase * test = [self new];
+            SEL selector = NSSelectorFromString(name);
+            void (*testMethod)(id, SEL) = (void (*)(id, SEL))[test methodForSelector:selector];
+            
+            [test setUp];
+            testMethod(test, selector);
+            [test tearDown];
+            
+            if ([test failureCount] > 0)
+                failedTests++;
+            
+            printf("%s -[%s %s]\n", 
+                   [test failureCount] > 0 ? "FAIL" : "PASS", 
+                   class_getName(self), 
+                   [name UTF8String]);
+        }
+    }
+    
+    return failedTests;
+}
+
++ (NSArray *)testNames {
+    
+    NSMutableArray * names = [NSMutableArray array];
+    unsigned int count = 0;
+    Method * methods = class_copyMethodList(self, &count);
+    
+    for (unsigned int i = 0; i < count; i++) {
+        
+        SEL selector = method_getName(methods[i]);
+        NSString * name = NSStringFromSelector(selector);
+        
+        if ([name hasPrefix:@"test"] && method_getNumberOfArguments(methods[i]) == 2)
+            [names addObject:name];
+    }
+    
+    free(methods);
+    
+    return [names sortedArrayUsingSelector:@selector(compare:)];
+}
+
+@end
@@ -0,0 +1,173 @@
+//
+// RBTimestampEncoderTests.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <stdlib.h>
+
+#import "RBTimestampEncoderTests.h"
+#import "RBTimestampEncoder.h"
+
+/// The seconds in a day.
+static const CFTimeInterval kSecondsPerDay = 86400.0;
+
+/// The number of random times each test checks.
+static const NSUInteger kRandomTimeCount = 100000;
+
+
+@interface RBTimestampEncoderTests ()
+
+/**
+ * The formatter the encoder replaced, set up as RBExtendedLogFile used it.
+ */
+@property (nonatomic, strong) NSDateFormatter * formatter;
+
+/**
+ * Returns the text the encoder writes for the given time.
+ *
+ * @param encoder The encoder.
+ * @param time The time to encode.
+ *
+ * @return The text.
+ */
++ (NSString *)stringWithEncoder:(RBTimestampEncoder *)encoder time:(CFAbsoluteTime)time;
+
+/**
+ * Returns a random time within about 30 years of the reference date, either 
+ * side of it.
+ *
+ * @return The time.
+ */
++ (CFAbsoluteTime)randomTime;
+
+@end
+
+
+@implementation RBTimestampEncoderTests
+
+@synthesize formatter;
+
+- (void)setUp {
+    
+    NSDateFormatter * gmtFormatter = [NSDateFormatter new];
+    
+    [gmtFormatter setLocale:[[NSLocale alloc] initWithLocaleIdentifier:@"en_US_POSIX"]];
+    [gmtFormatter setTimeZone:[NSTimeZone timeZoneForSecondsFromGMT:0]];
+    [gmtFormatter setDateFormat:@"HH:mm:ss"];
+    [self setFormatter:gmtFormatter];
+    
+    // Repeatable, so a failure can be reproduced.
+    srand48(20111017);
+}
+
+- (void)testSecondsMatchDateFormatter {
+    
+    RBTimestampEncoder * encoder = [RBTimestampEncoder new];
+    
+    for (NSUInteger i = 0; i < kRandomTimeCount; i++) {
+        
+        CFAbsoluteTime time = [[self class] randomTime];
+        NSString * expected = [[self formatter] stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:time]];
+        NSString * actual = [[self class] stringWithEncoder:encoder time:time];
+        
+        RBAssert([actual isEqualToString:expected], @"%f encoded as %@, expected %@", time, actual, expected);
+    }
+}
+
+- (void)testBoundariesMatchDateFormatter {
+    
+    RBTimestampEncoder * encoder = [RBTimestampEncoder new];
+    CFAbsoluteTime days[] = { -2 * kSecondsPerDay, -kSecondsPerDay, 0, kSecondsPerDay, 3650 * kSecondsPerDay };
+    CFTimeInterval offsets[] = { -1, -0.000001, 0, 0.5, 0.999999, 1, 59, 60, 3599, 3600, kSecondsPerDay - 1 };
+    
+    for (NSUInteger i = 0; i < sizeof(days) / sizeof(days[0]); i++) {
+        for (NSUInteger j = 0; j < sizeof(offsets) / sizeof(offsets[0]); j++) {
+            
+            CFAbsoluteTime time = days[i] + offsets[j];
+            NSString * expected = [[self formatter] stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:time]];
+            NSString * actual = [[self class] stringWithEncoder:encoder time:time];
+            
+            RBAssert([actual isEqualToString:expected], @"%f encoded as %@, expected %@", time, actual, expected);
+        }
+    }
+}
+
+- (void)testCachedSecondIsReplacedGoingBackward {
+    
+    RBTimestampEncoder * encoder = [RBTimestampEncoder new];
+    CFAbsoluteTime times[] = { 1000.25, 1000.75, 999.5, 1000.0, 1001.0 };
+    
+    // Records logged out of order must not reuse the digits of a later second.
+    for (NSUInteger i = 0; i < sizeof(times) / sizeof(times[0]); i++) {
+        
+        NSString * expected = [[self formatter] stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:times[i]]];
+        NSString * actual = [[self class] stringWithEncoder:encoder time:times[i]];
+        
+        RBAssert([actual isEqualToString:expected], @"%f encoded as %@, expected %@", times[i], actual, expected);
+    }
+}
+
+- (void)testMillisecondsMatchDateFormatter {
+    
+    RBTimestampEncoder * encoder = [RBTimestampEncoder new];
+    
+    [encoder setPrecision:RBTimestampPrecisionMilliseconds];
+    [[self formatter] setDateFormat:@"HH:mm:ss.SSS"];
+    
+    for (NSUInteger i = 0; i < kRandomTimeCount; i++) {
+        
+        // Lands just past a whole millisecond, where rounding and truncating agree.
+        CFAbsoluteTime time = floor([[self class] randomTime] * 1000.0) / 1000.0 + 0.0002;
+        NSString * expected = [[self formatter] stringFromDate:[NSDate dateWithTimeIntervalSinceReferenceDate:time]];
+        NSString * actual = [[self class] stringWithEncoder:encoder time:time];
+        
+        RBAssert([actual isEqualToString:expected], @"%f encoded as %@, expected %@", time, actual, expected);
+    }
+}
+
+- (void)testMicroseconds {
+    
+    RBTimestampEncoder * encoder = [RBTimestampEncoder new];
+    
+    [encoder setPrecision:RBTimestampPrecisionMicroseconds];
+    
+    RBAssert([[[self class] stringWithEncoder:encoder time:3723.0000015] isEqualToString:@"01:02:03.000001"], 
+             @"Microseconds aren't written");
+    RBAssert([[[self class] stringWithEncoder:encoder time:-0.0000005] isEqualToString:@"23:59:59.999999"], 
+             @"Times before the reference date aren't written");
+    RBAssert([[[self class] stringWithEncoder:encoder time:59.9999999] isEqualToString:@"00:00:59.999999"], 
+             @"The fraction rolls over into the next second");
+}
+
++ (NSString *)stringWithEncoder:(RBTimestampEncoder *)encoder time:(CFAbsoluteTime)time {
+    
+    char buffer[RB_TIMESTAMP_MAX_LENGTH];
+    NSUInteger length = [encoder encodeTime:time intoBuffer:buffer];
+    
+    return [[NSString alloc] initWithBytes:buffer length:length encoding:NSASCIIStringEncoding];
+}
+
++ (CFAbsoluteTime)randomTime {
+    return (drand48() - 0.5) * 60.0 * 365.0 * kSecondsPerDay;
+}
+
+@end
@@ -0,0 +1,80 @@
+//
+// main.m
+//
+// Copyright (c) 2011 Robert Brown
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#import <Foundation/Foundation.h>
+#import <stdio.h>
+
+#import "RBTestCase.h"
+#import "RBErrorThrottleTests.h"
+#import "RBExtendedLogFileTests.h"
+#import "RBFlightRecorderTests.h"
+#import "RBLogSinkTests.h"
+#import "RBTimestampEncoderTests.h"
+
+
+/**
+ * Returns every RBTestCase subclass, in the order they run.
+ *
+ * @return An array of classes.
+ */
+static NSArray * RBTestCaseClasses(void) {
+    return [NSArray arrayWithObjects:
+            [RBTimestampEncoderTests class], 
+            [RBExtendedLogFileTests class], 
+            [RBLogSinkTests class], 
+            [RBErrorThrottleTests class], 
+            [RBFlightRecorderTests class], 
+            nil];
+}
+
+int main(int argc, const char * argv[]) {
+    
+    NSUInteger failedTests = 0;
+    
+    @autoreleasepool {
+        
+        NSMutableArray * classes = [NSMutableArray array];
+        
+        // Runs the named test cases, or all of them.
+        for (int i = 1; i < argc; i++) {
+            
+            Class testClass = NSClassFromString([NSString stringWithUTF8String:argv[i]]);
+            
+            if (![RBTestCaseClasses() containsObject:testClass]) {
+                fprintf(stderr, "Unknown test case %s\n", argv[i]);
+                return 2;
+            }
+            
+            [classes addObject:testClass];
+        }
+        
+        if ([classes count] == 0)
+            [classes addObjectsFromArray:RBTestCaseClasses()];
+        
+        for (Class testClass in classes)
+            failedTests += [testClass runTests];
+    }
+    
+    return failedTests > 0 ? 1 : 0;
+}